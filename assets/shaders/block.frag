@@ -4,6 +4,8 @@ layout(binding = 1) uniform sampler2D tex_sampler;
 
 layout(location = 0) in vec2 texcoord;
 layout(location = 1) flat in uint direction;
+layout(location = 2) flat in uint texture_id;
+layout(location = 3) flat in uint texture_types;
 layout(location = 0) out vec4 color;
 
 const float face_color[6] = {
@@ -11,5 +13,7 @@ const float face_color[6] = {
 };
 
 void main() {
-    color = vec4(texture(tex_sampler, texcoord).rgb * face_color[direction], 1);
+    vec2 uv = fract(texcoord);
+    uv.y = (uv.y + texture_id) / texture_types;
+    color = vec4(texture(tex_sampler, uv).rgb * face_color[direction], 1);
 }
@@ -40,24 +40,53 @@ const vec2 texcoords[4] = {
     vec2(1, 1),
 };
 
+// The two axes each face spans, scaled by the face extent
+const uvec2 face_axes[6] = {
+    uvec2(0, 1), // NORTH
+    uvec2(0, 1), // SOUTH
+    uvec2(2, 1), // WEST
+    uvec2(2, 1), // EAST
+    uvec2(0, 2), // TOP
+    uvec2(0, 2), // BOTTOM
+};
+
 layout(binding = 0) uniform UBO {
     mat4 mvp;
 } ubo;
 
+// The origin of each section, indexed by the slot of its faces
+layout(std430, binding = 2) readonly buffer SectionOrigins {
+    ivec4 section_origins[];
+};
+
 layout(push_constant) uniform PCONST {
     uint texture_types;
 } pc;
 
-layout(location = 0) in uint direction;
-layout(location = 1) in uint texture_id;
-layout(location = 2) in ivec3 position;
+// x:5 y:5 z:5 direction:3 (extent.x - 1):5 (extent.y - 1):5
+layout(location = 0) in uint packed;
+// texture:12 slot:20
+layout(location = 1) in uint texture_slot;
 
 layout(location = 0) out vec2 texcoord;
 layout(location = 1) out uint out_direction;
+layout(location = 2) out uint out_texture_id;
+layout(location = 3) out uint out_texture_types;
 
 void main() {
-    gl_Position = ubo.mvp * vec4(cube[direction * 4 + gl_VertexIndex] + position, 1);
-    texcoord = texcoords[gl_VertexIndex];
-    texcoord.y = (texcoord.y + texture_id) / pc.texture_types;
+    uint direction = (packed >> 15) & 7u;
+    uvec2 extent = uvec2((packed >> 18) & 31u, (packed >> 23) & 31u) + 1u;
+    uint texture_id = texture_slot & 0xfffu;
+    ivec3 position = section_origins[texture_slot >> 12].xyz +
+                     ivec3(packed & 31u, (packed >> 5) & 31u, (packed >> 10) & 31u);
+
+    vec3 scale = vec3(1);
+    scale[face_axes[direction].x] = extent.x;
+    scale[face_axes[direction].y] = extent.y;
+    gl_Position = ubo.mvp * vec4(cube[direction * 4 + gl_VertexIndex] * scale + position, 1);
+    // Repeat the texture once per block, it will be wrapped in fragment shader
+    texcoord = texcoords[gl_VertexIndex] * vec2(extent);
     out_direction = direction;
+    out_texture_id = texture_id;
+    out_texture_types = pc.texture_types;
 }
@@ -11,6 +11,7 @@ enum class Key {
   kA = GLFW_KEY_A,
   kS = GLFW_KEY_S,
   kD = GLFW_KEY_D,
+  kM = GLFW_KEY_M,
   kSpace = GLFW_KEY_SPACE,
   kLShift = GLFW_KEY_LEFT_SHIFT,
 };
@@ -16,6 +16,9 @@ extern vk::Device device;
 [[nodiscard]] std::uint32_t GetGraphicsQueue();
 [[nodiscard]] std::uint32_t GetPresentQueue();
 
+/// The device features enabled at creation
+[[nodiscard]] const vk::PhysicalDeviceFeatures &GetEnabledFeatures();
+
 } // namespace vulkan
 
 #endif // VKMC_BASE_VULKAN_H_
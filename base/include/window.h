@@ -3,6 +3,7 @@
 #define VKMC_BASE_WINDOW_H_
 
 #include <cstdint>
+#include <string_view>
 
 namespace window {
 
@@ -10,6 +11,9 @@ namespace window {
 
 [[nodiscard]] std::uint16_t GetHeight() noexcept;
 
+/// Show a status after the title of the window, empty to show the title only
+void SetStatus(std::string_view status);
+
 } // namespace window
 
 #endif // VKMC_BASE_WINDOW_H_
@@ -0,0 +1,3 @@
+#include <event.h>
+
+EventDispatcher events::global;
@@ -109,6 +109,7 @@ vk::Instance vulkan::instance;
 vk::SurfaceKHR vulkan::surface;
 vk::Device vulkan::device;
 static VulkanSuitablePhysicalDevice suitable_gpu;
+static vk::PhysicalDeviceFeatures enabled_features;
 
 static std::vector<const char *> GetRequiredInstanceExtensionNames() noexcept {
   std::vector<const char *> extensions;
@@ -240,14 +241,20 @@ static vk::Device CreateLogicalDevice(
       .pQueuePriorities = &priority,
   };
   std::array queue_ci{grahics_ci, present_ci};
-  vk::PhysicalDeviceFeatures features[2];
+
+  // Optional features, users check GetEnabledFeatures() for fallbacks
+  auto supported = device.GetHandle().getFeatures();
+  enabled_features = vk::PhysicalDeviceFeatures{
+      .multiDrawIndirect = supported.multiDrawIndirect,
+      .drawIndirectFirstInstance = supported.drawIndirectFirstInstance,
+  };
 
   vk::DeviceCreateInfo ci{
       .queueCreateInfoCount = 2,
       .pQueueCreateInfos = queue_ci.data(),
       .enabledExtensionCount = std::uint32_t(extensions.size()),
       .ppEnabledExtensionNames = extensions.data(),
-      .pEnabledFeatures = features,
+      .pEnabledFeatures = &enabled_features,
   };
 
   return device.GetHandle().createDevice(ci);
@@ -280,3 +287,7 @@ std::uint32_t vulkan::GetGraphicsQueue() {
 std::uint32_t vulkan::GetPresentQueue() {
   return suitable_gpu.GetPresentQueueIndex();
 }
+
+const vk::PhysicalDeviceFeatures &vulkan::GetEnabledFeatures() {
+  return enabled_features;
+}
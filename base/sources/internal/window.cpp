@@ -1,5 +1,6 @@
 #include <cstdint>
 #include <stdexcept>
+#include <string>
 
 #include <event.h>
 
@@ -7,6 +8,8 @@
 
 static std::uint16_t width;
 static std::uint16_t height;
+static GLFWwindow *window_ptr;
+static std::string title;
 
 static struct {
   EventPublisher *window_size;
@@ -20,6 +23,8 @@ GLFWwindow *window::internal::CreateWindow(int width, int height, const char *ti
   if (window == nullptr) {
     throw std::runtime_error("Failed to create window!");
   }
+  window_ptr = window;
+  ::title = title;
   events::global.SubscribeEvent(
       events::kWindowSize, +[](std::uint16_t width, std::uint16_t height) {
         ::width = width;
@@ -55,3 +60,8 @@ std::uint16_t window::GetWidth() noexcept {
 std::uint16_t window::GetHeight() noexcept {
   return height;
 }
+
+void window::SetStatus(std::string_view status) {
+  auto text = status.empty() ? title : title + " - " + std::string(status);
+  glfwSetWindowTitle(window_ptr, text.c_str());
+}
@@ -8,15 +8,12 @@
 
 #include <application.h>
 #include <assets/json.h>
-#include <event.h>
 
 #include "internal/assets.h"
 #include "internal/input.h"
 #include "internal/vulkan.h"
 #include "internal/window.h"
 
-EventDispatcher events::global;
-
 static GLFWwindow *InitializeWindow() {
   if (glfwInit() != GLFW_TRUE) {
     throw std::runtime_error("Failed to initialize GLFW!");
@@ -0,0 +1,76 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "benchmark.h"
+
+static std::atomic<std::size_t> allocation_count;
+static std::atomic<std::size_t> allocated_bytes;
+
+// Count the allocations of the whole program, the aligned and nothrow
+// forms are left to the standard library
+void *operator new(std::size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  if (auto p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+  std::free(p);
+}
+
+std::size_t bench::GetAllocationCount() noexcept {
+  return allocation_count.load(std::memory_order_relaxed);
+}
+
+std::size_t bench::GetAllocatedBytes() noexcept {
+  return allocated_bytes.load(std::memory_order_relaxed);
+}
+
+void bench::Runner::Report(const Result &result) const {
+  std::printf(
+      "%-32s %12.1f ns/%-8s %14.0f %s/s %10.2f allocs/op %12.1f B/op\n",
+      result.name.c_str(), result.GetNsPerOp(), result.unit.c_str(),
+      result.GetOpsPerSecond(), result.unit.c_str(),
+      double(result.allocations) / double(result.ops),
+      double(result.allocated_bytes) / double(result.ops)
+  );
+  std::fflush(stdout);
+}
+
+nlohmann::json bench::Runner::ToJson() const {
+  auto benchmarks = nlohmann::json::array();
+  for (auto &result : results_) {
+    benchmarks.push_back({
+        {"name", result.name},
+        {"unit", result.unit},
+        {"iterations", result.iterations},
+        {"ops", result.ops},
+        {"ns_per_op", result.GetNsPerOp()},
+        {"ops_per_second", result.GetOpsPerSecond()},
+        {"allocations_per_op", double(result.allocations) / double(result.ops)},
+        {"bytes_per_op", double(result.allocated_bytes) / double(result.ops)},
+    });
+  }
+  return {{"benchmarks", std::move(benchmarks)}};
+}
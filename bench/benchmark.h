@@ -0,0 +1,109 @@
+#pragma once
+#ifndef VKMC_BENCH_BENCHMARK_H_
+#define VKMC_BENCH_BENCHMARK_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace bench {
+
+/// The number and bytes of operator new calls on all threads since start
+[[nodiscard]] std::size_t GetAllocationCount() noexcept;
+[[nodiscard]] std::size_t GetAllocatedBytes() noexcept;
+
+/// Keep the value so the computation producing it is not optimized out
+template <class T>
+inline void DoNotOptimize(const T &value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const T *sink;
+  sink = &value;
+#endif
+}
+
+struct Result {
+  std::string name;
+  /// What one operation is, e.g. chunk or sample
+  std::string unit;
+  /// The number of measured calls
+  std::size_t iterations;
+  /// The number of operations done by all measured calls
+  std::size_t ops;
+  double seconds;
+  std::size_t allocations;
+  std::size_t allocated_bytes;
+
+  [[nodiscard]] double GetNsPerOp() const noexcept {
+    return seconds * 1e9 / double(ops);
+  }
+
+  [[nodiscard]] double GetOpsPerSecond() const noexcept {
+    return double(ops) / seconds;
+  }
+};
+
+/// Runs benchmarks matching a name filter and collects their results.
+/// A benchmark is a callable returning the number of operations it did.
+class Runner {
+public:
+  Runner(double min_seconds, std::string filter)
+      : min_seconds_(min_seconds), filter_(std::move(filter)) {}
+
+  /// Call the benchmark once to warm up, then until it ran for the minimum time
+  template <class Fn>
+  void Run(std::string_view name, std::string_view unit, Fn &&fn) {
+    if (name.find(filter_) == std::string_view::npos) {
+      return;
+    }
+
+    DoNotOptimize(fn());
+
+    using Clock = std::chrono::steady_clock;
+    Result result{
+        .name = std::string(name),
+        .unit = std::string(unit),
+        .iterations = 0,
+        .ops = 0,
+        .seconds = 0,
+        .allocations = 0,
+        .allocated_bytes = 0,
+    };
+    auto allocations = GetAllocationCount();
+    auto allocated_bytes = GetAllocatedBytes();
+    auto start = Clock::now();
+    do {
+      result.ops += fn();
+      ++result.iterations;
+      result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (result.seconds < min_seconds_);
+    result.allocations = GetAllocationCount() - allocations;
+    result.allocated_bytes = GetAllocatedBytes() - allocated_bytes;
+
+    Report(results_.emplace_back(std::move(result)));
+  }
+
+  [[nodiscard]] const std::vector<Result> &GetResults() const noexcept {
+    return results_;
+  }
+
+  [[nodiscard]] nlohmann::json ToJson() const;
+
+private:
+  void Report(const Result &) const;
+
+  double min_seconds_;
+  std::string filter_;
+  std::vector<Result> results_;
+};
+
+} // namespace bench
+
+#endif // VKMC_BENCH_BENCHMARK_H_
@@ -0,0 +1,493 @@
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include "../base/sources/internal/assets.h"
+#include "../game/block/registry.h"
+#include "../game/chunk/chunk_map.h"
+#include "../game/chunk/codec.h"
+#include "../game/chunk/generator.h"
+#include "../game/chunk/manager.h"
+#include "../game/chunk/neighborhood.h"
+#include "../game/chunk/storage.h"
+#include "../game/job/worker_pool.h"
+#include "../game/math/perlin.h"
+#include "../game/mesh/mesher.h"
+#include "../game/physical/raycast.h"
+#include "benchmark.h"
+
+namespace {
+
+constexpr std::uint64_t kSeed = 0;
+
+struct Options {
+  std::string assets = "default.assets";
+  std::string json;
+  std::string filter;
+  double min_seconds = .5;
+};
+
+Options ParseOptions(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    auto value = [&] {
+      if (i + 1 == argc) {
+        throw std::runtime_error("Missing value of " + std::string(arg));
+      }
+      return std::string(argv[++i]);
+    };
+    if (arg == "--assets") {
+      options.assets = value();
+    } else if (arg == "--json") {
+      options.json = value();
+    } else if (arg == "--filter") {
+      options.filter = value();
+    } else if (arg == "--min-time") {
+      options.min_seconds = std::stod(value());
+    } else {
+      throw std::runtime_error(
+          "Usage: vkmc_bench [--assets file] [--json file] [--filter name] [--min-time seconds]"
+      );
+    }
+  }
+  return options;
+}
+
+void RunPerlin(bench::Runner &runner) {
+  Perlin<512> perlin{std::mt19937_64(kSeed)};
+  constexpr int n = 64;
+  runner.Run("perlin/sample", "sample", [&] {
+    float sum = 0;
+    for (int x = 0; x != n; ++x) {
+      for (int z = 0; z != n; ++z) {
+        sum += perlin({x * .125f, z * .125f});
+      }
+    }
+    bench::DoNotOptimize(sum);
+    return std::size_t(n * n);
+  });
+
+  std::vector<float> xs(n * n), zs(n * n), values(n * n);
+  for (int x = 0; x != n; ++x) {
+    for (int z = 0; z != n; ++z) {
+      xs[x * n + z] = x * .125f;
+      zs[x * n + z] = z * .125f;
+    }
+  }
+  runner.Run("perlin/sample_batch", "sample", [&] {
+    perlin(xs.data(), zs.data(), values.data(), values.size());
+    bench::DoNotOptimize(values.front());
+    return values.size();
+  });
+}
+
+void RunGenerator(bench::Runner &runner, const BlockRegistry &registry) {
+  ChunkGenerator generator(kSeed);
+  auto chunk = std::make_unique<Chunk>();
+  std::int32_t x = 0;
+  runner.Run("generator/chunk", "chunk", [&] {
+    generator.Generate(registry, *chunk, x++, 0);
+    bench::DoNotOptimize(*chunk);
+    return std::size_t(1);
+  });
+
+  // Where the time of the chunks goes, the 2-D stages are mostly cache hits
+  auto stats = generator.GetStageStats();
+  for (std::size_t i = 0; i != stats.size(); ++i) {
+    auto &stage = stats[i];
+    if (stage.runs != 0) {
+      std::printf(
+          "  %-30s %12.1f ns/run %10.1f%% cached\n",
+          ChunkGenerator::GetStageName(ChunkGenerator::Stage(i)),
+          double(stage.nanoseconds) / double(stage.runs),
+          100. * double(stage.cache_hits) / double(stage.runs)
+      );
+    }
+  }
+}
+
+void RunMesher(bench::Runner &runner, const BlockRegistry &registry) {
+  // The center chunk of 3 x 3 generated chunks, its borders see real neighbours
+  ChunkGenerator generator(kSeed);
+  std::vector<std::unique_ptr<Chunk>> chunks;
+  for (int i = 0; i != 9; ++i) {
+    generator.Generate(registry, *chunks.emplace_back(std::make_unique<Chunk>()), i % 3 - 1, i / 3 - 1);
+  }
+  auto at = [&](int x, int z) { return chunks[(z + 1) * 3 + x + 1].get(); };
+
+  std::vector<ChunkMeshInput> inputs(Chunk::kSections);
+  for (std::uint32_t section = 0; section != Chunk::kSections; ++section) {
+    inputs[section].Capture(
+        {0, 0}, section, *at(0, 0),
+        at(0, 1), at(0, -1), at(1, 0), at(-1, 0)
+    );
+    inputs[section].slot = section;
+  }
+
+  ChunkMesher mesher(registry);
+  std::vector<FaceInstance> faces(ChunkMesher::kMaxFaces);
+  auto run = [&](std::string_view name, MeshingMode mode) {
+    runner.Run(name, "section", [&] {
+      std::uint32_t n_face = 0;
+      for (auto &input : inputs) {
+        n_face += mesher.Generate(mode, input, faces.data());
+      }
+      bench::DoNotOptimize(n_face);
+      return inputs.size();
+    });
+  };
+  run("mesher/per_face", MeshingMode::kPerFace);
+  run("mesher/greedy", MeshingMode::kGreedy);
+}
+
+void RunChunkManager(bench::Runner &runner, const BlockRegistry &registry, WorkerPool &workers) {
+  for (std::int32_t radius : {2, 4, 8}) {
+    // Load every chunk in the radius around the origin from nothing
+    auto name = "chunk_manager/load_radius_" + std::to_string(radius);
+    runner.Run(name, "chunk", [&] {
+      ChunkManager manager(kSeed, workers);
+      manager.SetRenderDistance(radius, 2);
+      manager.SetLoadBudget(std::numeric_limits<std::size_t>::max());
+      manager.LoadAutomatic(registry, {0, 0, 0});
+      workers.Wait();
+      manager.Integrate();
+
+      std::size_t loaded = 0;
+      for (std::int32_t x = -radius; x <= radius; ++x) {
+        for (std::int32_t z = -radius; z <= radius; ++z) {
+          loaded += manager.GetChunk({x, z}) != nullptr;
+        }
+      }
+      return loaded;
+    });
+  }
+}
+
+/// The hash ChunkManager used before ChunkMap, a negative z sign extends
+/// over x
+struct LegacyChunkIdHash {
+  std::uint64_t operator()(ChunkId val) const noexcept {
+    std::uint64_t x64 = val.x;
+    return ((x64 << 32) | val.y) ^ (x64 << 16);
+  }
+};
+
+void RunChunkMap(bench::Runner &runner) {
+  // Block lookups as ray marching does them, over a large loaded area
+  constexpr std::int32_t radius = 48;
+  constexpr std::size_t n = 4096;
+  std::vector<std::unique_ptr<Chunk>> chunks;
+  std::unordered_map<ChunkId, Chunk *, LegacyChunkIdHash> legacy;
+  std::unordered_map<ChunkId, Chunk *, ChunkIdHash> unordered;
+  ChunkMap<Chunk *> flat;
+  for (std::int32_t x = -radius; x <= radius; ++x) {
+    for (std::int32_t z = -radius; z <= radius; ++z) {
+      auto chunk = chunks.emplace_back(std::make_unique<Chunk>()).get();
+      chunk->Fill(BlockId(x & 1));
+      legacy.emplace(ChunkId{x, z}, chunk);
+      unordered.emplace(ChunkId{x, z}, chunk);
+      flat.TryEmplace({x, z}, chunk);
+    }
+  }
+
+  std::mt19937 random(kSeed);
+  std::uniform_int_distribution<std::int32_t> axis(-radius * 32, radius * 32 + 31);
+  std::uniform_int_distribution<std::int32_t> height(0, Chunk::kHeight - 1);
+  std::vector<glm::ivec3> positions(n);
+  for (auto &position : positions) {
+    position = {axis(random), height(random), axis(random)};
+  }
+
+  auto run = [&](std::string_view name, auto &&find) {
+    runner.Run(name, "lookup", [&] {
+      BlockId sum = 0;
+      for (auto &position : positions) {
+        auto chunk = find(Chunk::GetChunkIdFromWorldPosition(position));
+        sum += chunk ? (*chunk)(Chunk::GetPositionInChunk(position)) : 0;
+      }
+      bench::DoNotOptimize(sum);
+      return n;
+    });
+  };
+  run("chunk_map/unordered_legacy_hash", [&](ChunkId id) -> const Chunk * {
+    auto it = legacy.find(id);
+    return it != legacy.end() ? it->second : nullptr;
+  });
+  run("chunk_map/unordered", [&](ChunkId id) -> const Chunk * {
+    auto it = unordered.find(id);
+    return it != unordered.end() ? it->second : nullptr;
+  });
+  run("chunk_map/flat", [&](ChunkId id) -> const Chunk * {
+    auto chunk = flat.Find(id);
+    return chunk ? *chunk : nullptr;
+  });
+}
+
+void RunNeighborhood(bench::Runner &runner, const BlockRegistry &registry, WorkerPool &workers) {
+  ChunkManager manager(kSeed, workers);
+  for (std::int32_t x = -2; x <= 2; ++x) {
+    for (std::int32_t z = -2; z <= 2; ++z) {
+      manager.Load(registry, {x, z});
+    }
+  }
+
+  // Random blocks in the 3 x 3 chunks around the origin
+  constexpr std::size_t n = 4096;
+  std::mt19937 random(kSeed);
+  std::uniform_int_distribution<std::int32_t> axis(-32, 63);
+  std::uniform_int_distribution<std::int32_t> height(0, Chunk::kHeight - 1);
+  std::vector<glm::ivec3> positions(n);
+  for (auto &position : positions) {
+    position = {axis(random), height(random), axis(random)};
+  }
+  runner.Run("neighborhood/random_manager", "block", [&] {
+    BlockId sum = 0;
+    for (auto &position : positions) {
+      sum += manager.GetBlock(position);
+    }
+    bench::DoNotOptimize(sum);
+    return n;
+  });
+  runner.Run("neighborhood/random", "block", [&] {
+    ChunkNeighborhood around(manager, {0, 0});
+    BlockId sum = 0;
+    for (auto &position : positions) {
+      sum += around.GetBlock(position);
+    }
+    bench::DoNotOptimize(sum);
+    return n;
+  });
+
+  // The blocks of rays of 16 unit steps, found before the timing so the
+  // floor of the steps doesn't hide the lookups
+  constexpr std::size_t n_ray = 256, n_step = 16;
+  std::uniform_real_distribution<float> start(0, 32), direction(-1, 1);
+  std::vector<glm::ivec3> ray_blocks;
+  ray_blocks.reserve(n_ray * n_step);
+  for (std::size_t i = 0; i != n_ray; ++i) {
+    glm::vec3 origin{start(random), start(random) + 64, start(random)};
+    auto step = glm::normalize(glm::vec3(direction(random), direction(random), direction(random)));
+    for (std::size_t k = 0; k != n_step; ++k) {
+      ray_blocks.emplace_back(glm::floor(origin + step * float(k)));
+    }
+  }
+  runner.Run("neighborhood/ray_manager", "block", [&] {
+    BlockId sum = 0;
+    for (auto &block : ray_blocks) {
+      sum += manager.GetBlock(block);
+    }
+    bench::DoNotOptimize(sum);
+    return n_ray * n_step;
+  });
+  // As CastRay reads, the chunk is resolved when the ray enters it
+  auto read_ray = [](ChunkNeighborhood &around, const glm::ivec3 *blocks) {
+    BlockId sum = 0;
+    const Chunk *chunk = nullptr;
+    ChunkId chunk_id{};
+    for (std::size_t k = 0; k != n_step; ++k) {
+      if (auto id = Chunk::GetChunkIdFromWorldPosition(blocks[k]); chunk == nullptr || id != chunk_id) {
+        chunk = &around.GetChunkAt(blocks[k]);
+        chunk_id = id;
+      }
+      sum += (*chunk)(Chunk::GetPositionInChunk(blocks[k]));
+    }
+    return sum;
+  };
+  runner.Run("neighborhood/ray", "block", [&] {
+    BlockId sum = 0;
+    for (std::size_t i = 0; i != n_ray; ++i) {
+      auto blocks = ray_blocks.data() + i * n_step;
+      ChunkNeighborhood around(manager, Chunk::GetChunkIdFromWorldPosition(blocks[0]));
+      sum += read_ray(around, blocks);
+    }
+    bench::DoNotOptimize(sum);
+    return n_ray * n_step;
+  });
+  // One neighbourhood moved to each ray as CastRays does
+  runner.Run("neighborhood/ray_shared", "block", [&] {
+    BlockId sum = 0;
+    ChunkNeighborhood around(manager, Chunk::GetChunkIdFromWorldPosition(ray_blocks[0]));
+    for (std::size_t i = 0; i != n_ray; ++i) {
+      auto blocks = ray_blocks.data() + i * n_step;
+      around.Recenter(Chunk::GetChunkIdFromWorldPosition(blocks[0]));
+      sum += read_ray(around, blocks);
+    }
+    bench::DoNotOptimize(sum);
+    return n_ray * n_step;
+  });
+}
+
+void RunRaycast(bench::Runner &runner, const BlockRegistry &registry, WorkerPool &workers) {
+  ChunkManager manager(kSeed, workers);
+  for (std::int32_t x = -2; x <= 2; ++x) {
+    for (std::int32_t z = -2; z <= 2; ++z) {
+      manager.Load(registry, {x, z});
+    }
+  }
+
+  // Rays as long as the player reach from above the terrain in the chunks
+  // around the origin, most hit the ground. Groups of rays start at the
+  // same point like probes.
+  constexpr std::size_t n = 4096, n_group = 64;
+  std::mt19937 random(kSeed);
+  std::uniform_real_distribution<float> start(-32, 64), height(64, 96), direction(-1, 1);
+  std::vector<Ray> rays(n);
+  for (std::size_t i = 0; i != n; ++i) {
+    auto &ray = rays[i];
+    ray.origin = i % n_group == 0 ? glm::vec3(start(random), height(random), start(random)) : rays[i - 1].origin;
+    ray.direction = glm::normalize(glm::vec3(direction(random), direction(random) - 1, direction(random)));
+    ray.max_distance = 10;
+  }
+
+  // The unit step march the player used before the traversal, which may
+  // miss blocks whose corner the ray clips
+  runner.Run("raycast/march", "ray", [&] {
+    std::size_t hits = 0;
+    for (auto &ray : rays) {
+      for (float k = 0; k < ray.max_distance; k += std::min(1.f, ray.max_distance - k)) {
+        if (manager.GetBlock(glm::floor(ray.origin + ray.direction * k)) != blocks::kAir) {
+          ++hits;
+          break;
+        }
+      }
+    }
+    bench::DoNotOptimize(hits);
+    return n;
+  });
+  runner.Run("raycast/single", "ray", [&] {
+    std::size_t hits = 0;
+    for (auto &ray : rays) {
+      hits += CastRay(manager, ray).has_value();
+    }
+    bench::DoNotOptimize(hits);
+    return n;
+  });
+  std::vector<std::optional<RayHit>> hits(n);
+  runner.Run("raycast/batch", "ray", [&] {
+    CastRays(manager, rays, hits);
+    bench::DoNotOptimize(hits.data());
+    return n;
+  });
+}
+
+void RunChunkStorage(bench::Runner &runner, const BlockRegistry &registry) {
+  // Generated chunks saved to region files, then loaded back through mmap
+  constexpr std::int32_t n = 8;
+  ChunkGenerator generator(kSeed);
+  std::vector<std::shared_ptr<const Chunk>> chunks;
+  for (std::int32_t i = 0; i != n * n; ++i) {
+    auto chunk = std::make_shared<Chunk>();
+    generator.Generate(registry, *chunk, i % n, i / n);
+    chunks.emplace_back(std::move(chunk));
+  }
+
+  std::vector<std::uint8_t> data;
+  runner.Run("chunk_storage/encode", "chunk", [&] {
+    data.clear();
+    for (auto &chunk : chunks) {
+      EncodeChunk(*chunk, data);
+    }
+    bench::DoNotOptimize(data.front());
+    return chunks.size();
+  });
+  if (!data.empty()) {
+    std::printf("  %-30s %12.1f bytes/chunk\n", "encoded", double(data.size()) / double(chunks.size()));
+  }
+
+  auto directory = std::filesystem::temp_directory_path() / "vkmc_bench_storage";
+  std::filesystem::remove_all(directory);
+  {
+    ChunkStorage storage(directory);
+    for (std::int32_t i = 0; i != n * n; ++i) {
+      storage.Save({i % n, i / n}, chunks[i]);
+    }
+  }
+  {
+    ChunkStorage storage(directory);
+    auto chunk = std::make_unique<Chunk>();
+    std::int32_t i = 0;
+    runner.Run("chunk_storage/load", "chunk", [&] {
+      storage.Load({i % n, i / n}, *chunk);
+      i = (i + 1) % (n * n);
+      bench::DoNotOptimize(*chunk);
+      return std::size_t(1);
+    });
+  }
+  std::filesystem::remove_all(directory);
+}
+
+void RunBlockRegistry(bench::Runner &runner, const BlockRegistry &registry) {
+  constexpr int n = 1024;
+  auto dirt = registry.GetBlockId("dirt");
+  auto grass = registry.GetBlockId("grass_block");
+
+  runner.Run("block_registry/face_texture", "lookup", [&] {
+    TextureId sum = 0;
+    for (int i = 0; i != n; ++i) {
+      sum += registry.GetFaceTextureId(i & 1 ? dirt : grass, FaceDirection(i % 6));
+    }
+    bench::DoNotOptimize(sum);
+    return std::size_t(n);
+  });
+
+  std::string names[2]{"dirt", "grass_block"};
+  runner.Run("block_registry/block_id", "lookup", [&] {
+    BlockId sum = 0;
+    for (int i = 0; i != n; ++i) {
+      sum += registry.GetBlockId(names[i & 1]);
+    }
+    bench::DoNotOptimize(sum);
+    return std::size_t(n);
+  });
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  try {
+    auto options = ParseOptions(argc, argv);
+    assets::internal::LoadAssetsFile(options.assets);
+
+    {
+      BlockRegistry registry;
+      WorkerPool workers;
+      bench::Runner runner(options.min_seconds, options.filter);
+
+      RunPerlin(runner);
+      RunGenerator(runner, registry);
+      RunMesher(runner, registry);
+      RunChunkManager(runner, registry, workers);
+      RunChunkMap(runner);
+      RunNeighborhood(runner, registry, workers);
+      RunRaycast(runner, registry, workers);
+      RunChunkStorage(runner, registry);
+      RunBlockRegistry(runner, registry);
+
+      if (!options.json.empty()) {
+        auto json = runner.ToJson();
+        json["workers"] = workers.GetWorkerCount();
+        std::ofstream(options.json) << json.dump(2) << '\n';
+      }
+    }
+
+    assets::internal::UnloadAssetsFile();
+  } catch (std::exception &e) {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,62 @@
+#include <chrono>
+
+#include <application.h>
+#include <input.h>
+
+#include "player.h"
+#include "render/camera.h"
+#include "renderer.h"
+#include "world/world.h"
+
+class Game {
+private:
+  World world_;
+  Player player_;
+  Renderer renderer_;
+  bool mesher_key_down_;
+  std::chrono::steady_clock::time_point last_update_;
+
+public:
+  Game()
+      : world_(114514),
+        player_(world_.GetChunks(), world_.GetPlayerEntity()),
+        renderer_(world_.GetChunks(), world_.GetBlockRegistry(), world_.GetWorkers()),
+        mesher_key_down_(false),
+        last_update_(std::chrono::steady_clock::now()) {
+    world_.GetPlayerEntity().position = {0, 80, 0};
+    player_.SetViewDistance(float(world_.GetRenderDistance() * Chunk::kLength));
+    renderer_.BindCamera(player_.GetCamera());
+  }
+
+  void Update() {
+    // Toggle the mesher to compare face count and frame time
+    auto mesher_key_down = input::GetKey(input::Key::kM);
+    if (mesher_key_down && !mesher_key_down_) {
+      auto greedy = renderer_.GetMeshingMode() == MeshingMode::kGreedy;
+      renderer_.SetMeshingMode(greedy ? MeshingMode::kPerFace : MeshingMode::kGreedy);
+    }
+    mesher_key_down_ = mesher_key_down;
+
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration<double>(now - last_update_).count();
+    last_update_ = now;
+
+    player_.Update();
+    world_.Tick(elapsed);
+    renderer_.Render(world_.GetPlayerEntity().position);
+  }
+};
+
+static Game *game;
+
+void app::Initialize() {
+  game = new Game;
+}
+
+void app::Update() {
+  game->Update();
+}
+
+void app::Uninitialize() {
+  delete game;
+}
@@ -28,6 +28,8 @@ static FaceDirection ConvertToFaceDirection(std::string_view name) {
 BlockRegistry::BlockRegistry() {
   RegisterBlock("grass_block");
   RegisterBlock("dirt");
+  RegisterBlock("stone");
+  RegisterBlock("sand");
 }
 
 std::uint32_t BlockRegistry::RegisterBlock(const std::string &name) {
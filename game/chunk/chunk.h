@@ -2,73 +2,99 @@
 #ifndef VKMC_GAMEPLAY_CHUNK_H_
 #define VKMC_GAMEPLAY_CHUNK_H_
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
-#include <limits>
-#include <span>
-#include <unordered_map>
 
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 
 #include "../block/types.h"
+#include "section.h"
 
 using ChunkId = glm::ivec2;
 
+/// Both coordinates in one integer, x in the high half
+[[nodiscard]] constexpr std::uint64_t PackChunkId(ChunkId id) noexcept {
+  return (std::uint64_t(std::uint32_t(id.x)) << 32) | std::uint32_t(id.y);
+}
+
+[[nodiscard]] constexpr ChunkId UnpackChunkId(std::uint64_t key) noexcept {
+  return {std::int32_t(std::uint32_t(key >> 32)), std::int32_t(std::uint32_t(key))};
+}
+
+/// The packed id through the murmur3 finalizer, every bit of both
+/// coordinates reaches the low bits which pick the bucket
+struct ChunkIdHash {
+  std::uint64_t operator()(ChunkId val) const noexcept {
+    auto h = PackChunkId(val);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+  }
+};
+
+/// A column of independently stored sections
 class Chunk {
 private:
-  static constexpr std::size_t kChunkSizePow = 5; // 2^5 = 32
-  static_assert(
-      kChunkSizePow <= std::numeric_limits<std::uint8_t>::digits,
-      "The size of chunk is too large!"
-  );
-
-  static constexpr std::size_t kChunkPrimitives = std::size_t(1) << (kChunkSizePow * 3);
+  static constexpr std::size_t kChunkSizePow = ChunkSection::kLengthPow;
 
 public:
-  static constexpr std::size_t kLength = 1 << kChunkSizePow;
-
-  [[nodiscard]] static constexpr glm::vec<3, std::uint8_t>
-  GetPositionByIndex(std::uint32_t i) noexcept {
-    constexpr auto k = kChunkSizePow;
-    constexpr auto m = (1 << k) - 1;
-    // index is [y][x][z], swizzle to [x][y][z]
-    return {(i >> k) & m, (i >> (k * 2)) & m, i & m};
-  }
+  /// The length of chunk on x and z axis, also the height of a section
+  static constexpr std::size_t kLength = ChunkSection::kLength;
+  /// The number of sections in a column
+  static constexpr std::size_t kSections = 8;
+  /// The height of chunk on y axis
+  static constexpr std::size_t kHeight = kLength * kSections;
 
   [[nodiscard]] static constexpr ChunkId
   GetChunkIdFromWorldPosition(const glm::ivec3 &world) noexcept {
     return {world.x >> kChunkSizePow, world.z >> kChunkSizePow};
   }
 
-  [[nodiscard]] static constexpr glm::vec<3, std::uint8_t>
+  /// Position of a block in its chunk, y is kept in [0, kHeight)
+  [[nodiscard]] static constexpr glm::ivec3
   GetPositionInChunk(const glm::ivec3 &world) noexcept {
     constexpr auto m = (1 << kChunkSizePow) - 1;
-    return {world.x & m, world.y & m, world.z & m};
+    return {world.x & m, world.y, world.z & m};
   }
 
-  [[nodiscard]] const std::uint32_t &
-  operator()(std::uint8_t x, std::uint8_t y, std::uint8_t z) const {
-    return data_[y][x][z];
+  [[nodiscard]] BlockId operator()(int x, int y, int z) const noexcept {
+    return sections_[y >> kChunkSizePow](x, y & (kLength - 1), z);
   }
 
-  [[nodiscard]] std::uint32_t &
-  operator()(std::uint8_t x, std::uint8_t y, std::uint8_t z) {
-    return data_[y][x][z];
+  [[nodiscard]] BlockId operator()(const glm::ivec3 &pos) const noexcept {
+    return operator()(pos.x, pos.y, pos.z);
   }
 
-  [[nodiscard]] std::uint32_t &
-  operator()(const glm::vec<3, std::uint8_t> &pos) {
-    return operator()(pos.x, pos.y, pos.z);
+  void Set(int x, int y, int z, BlockId block) {
+    sections_[y >> kChunkSizePow].Set(x, y & (kLength - 1), z, block);
   }
 
-  [[nodiscard]] const std::uint32_t &
-  operator()(const glm::vec<3, std::uint8_t> &pos) const {
-    return operator()(pos.x, pos.y, pos.z);
+  void Set(const glm::ivec3 &pos, BlockId block) {
+    Set(pos.x, pos.y, pos.z, block);
+  }
+
+  [[nodiscard]] const ChunkSection &GetSection(std::size_t i) const noexcept {
+    return sections_[i];
+  }
+
+  [[nodiscard]] ChunkSection &GetSection(std::size_t i) noexcept {
+    return sections_[i];
+  }
+
+  /// Set all blocks of the chunk to given id
+  void Fill(BlockId block) {
+    for (auto &section : sections_) {
+      section.Fill(block);
+    }
   }
 
 private:
-  BlockId data_[kLength][kLength][kLength];
+  std::array<ChunkSection, kSections> sections_;
 };
 
 #endif // VKMC_GAMEPLAY_CHUNK_H_
@@ -0,0 +1,205 @@
+#pragma once
+#ifndef VKMC_CHUNK_CHUNK_MAP_H_
+#define VKMC_CHUNK_CHUNK_MAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "chunk.h"
+
+/// A flat hash map from chunk ids to small values such as chunk pointers.
+/// The slots are one array of packed ids and values, a lookup probes the
+/// following slots until the id or an empty slot. Erasing moves the later
+/// entries of the probe sequence back, so there are no tombstones.
+template <class T>
+class ChunkMap {
+private:
+  /// No chunk is this far away, the id marks empty slots
+  static constexpr std::uint64_t kEmpty = PackChunkId(
+      {std::numeric_limits<std::int32_t>::min(), std::numeric_limits<std::int32_t>::min()}
+  );
+  static constexpr std::size_t kMinCapacity = 16;
+
+  struct Slot {
+    std::uint64_t key = kEmpty;
+    T value{};
+  };
+
+public:
+  /// An entry seen by iteration, the value may be changed
+  template <bool kConst>
+  struct Entry {
+    ChunkId id;
+    std::conditional_t<kConst, const T, T> &value;
+  };
+
+  template <bool kConst>
+  class Iterator {
+  public:
+    using SlotPointer = std::conditional_t<kConst, const Slot *, Slot *>;
+    using difference_type = std::ptrdiff_t;
+    using value_type = Entry<kConst>;
+
+    Iterator() noexcept = default;
+
+    Iterator(SlotPointer slot, SlotPointer end) noexcept : slot_(slot), end_(end) {
+      Skip();
+    }
+
+    Entry<kConst> operator*() const noexcept {
+      return {UnpackChunkId(slot_->key), slot_->value};
+    }
+
+    Iterator &operator++() noexcept {
+      ++slot_;
+      Skip();
+      return *this;
+    }
+
+    Iterator operator++(int) noexcept {
+      auto old = *this;
+      ++*this;
+      return old;
+    }
+
+    bool operator==(const Iterator &other) const noexcept {
+      return slot_ == other.slot_;
+    }
+
+  private:
+    void Skip() noexcept {
+      while (slot_ != end_ && slot_->key == kEmpty) {
+        ++slot_;
+      }
+    }
+
+    SlotPointer slot_ = nullptr;
+    SlotPointer end_ = nullptr;
+  };
+
+  ChunkMap() : slots_(kMinCapacity), mask_(kMinCapacity - 1), size_(0) {}
+
+  [[nodiscard]] std::size_t GetSize() const noexcept {
+    return size_;
+  }
+
+  /// The value of the chunk, nullptr if it is not in the map
+  [[nodiscard]] T *Find(ChunkId id) noexcept {
+    auto key = PackChunkId(id);
+    for (auto i = GetHome(key);; i = (i + 1) & mask_) {
+      auto &slot = slots_[i];
+      if (slot.key == key) {
+        return &slot.value;
+      }
+      if (slot.key == kEmpty) {
+        return nullptr;
+      }
+    }
+  }
+
+  [[nodiscard]] const T *Find(ChunkId id) const noexcept {
+    return const_cast<ChunkMap *>(this)->Find(id);
+  }
+
+  [[nodiscard]] bool Contains(ChunkId id) const noexcept {
+    return Find(id) != nullptr;
+  }
+
+  /// Insert the value made from args if the chunk is not in the map.
+  /// Returns the value of the chunk and whether it was inserted.
+  template <class... Args>
+  std::pair<T *, bool> TryEmplace(ChunkId id, Args &&...args) {
+    if (auto value = Find(id)) {
+      return {value, false};
+    }
+    // At most half of the slots are used, probe sequences stay short
+    if ((size_ + 1) * 2 > slots_.size()) {
+      Rehash(slots_.size() * 2);
+    }
+    auto key = PackChunkId(id);
+    auto i = GetHome(key);
+    while (slots_[i].key != kEmpty) {
+      i = (i + 1) & mask_;
+    }
+    slots_[i].key = key;
+    slots_[i].value = T(std::forward<Args>(args)...);
+    ++size_;
+    return {&slots_[i].value, true};
+  }
+
+  /// Remove the chunk, returns whether it was in the map
+  bool Erase(ChunkId id) {
+    auto key = PackChunkId(id);
+    auto i = GetHome(key);
+    while (slots_[i].key != key) {
+      if (slots_[i].key == kEmpty) {
+        return false;
+      }
+      i = (i + 1) & mask_;
+    }
+
+    // Move back each later entry whose home is not between the hole and it
+    for (auto j = (i + 1) & mask_; slots_[j].key != kEmpty; j = (j + 1) & mask_) {
+      auto home = GetHome(slots_[j].key);
+      if (((j - home) & mask_) >= ((j - i) & mask_)) {
+        slots_[i] = std::move(slots_[j]);
+        i = j;
+      }
+    }
+    slots_[i] = Slot{};
+    --size_;
+    return true;
+  }
+
+  void Clear() {
+    slots_ = std::vector<Slot>(kMinCapacity);
+    mask_ = kMinCapacity - 1;
+    size_ = 0;
+  }
+
+  Iterator<false> begin() noexcept {
+    return {slots_.data(), slots_.data() + slots_.size()};
+  }
+
+  Iterator<false> end() noexcept {
+    return {slots_.data() + slots_.size(), slots_.data() + slots_.size()};
+  }
+
+  Iterator<true> begin() const noexcept {
+    return {slots_.data(), slots_.data() + slots_.size()};
+  }
+
+  Iterator<true> end() const noexcept {
+    return {slots_.data() + slots_.size(), slots_.data() + slots_.size()};
+  }
+
+private:
+  [[nodiscard]] std::size_t GetHome(std::uint64_t key) const noexcept {
+    return ChunkIdHash{}(UnpackChunkId(key)) & mask_;
+  }
+
+  void Rehash(std::size_t capacity) {
+    auto old = std::move(slots_);
+    slots_ = std::vector<Slot>(capacity);
+    mask_ = capacity - 1;
+    for (auto &slot : old) {
+      if (slot.key != kEmpty) {
+        auto i = GetHome(slot.key);
+        while (slots_[i].key != kEmpty) {
+          i = (i + 1) & mask_;
+        }
+        slots_[i] = std::move(slot);
+      }
+    }
+  }
+
+  std::vector<Slot> slots_;
+  std::size_t mask_;
+  std::size_t size_;
+};
+
+#endif // VKMC_CHUNK_CHUNK_MAP_H_
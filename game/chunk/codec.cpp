@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include "codec.h"
+
+static_assert(std::endian::native == std::endian::little, "Chunks are encoded in little endian");
+
+namespace {
+
+enum SectionTag : std::uint8_t {
+  kUniform = 0,
+  kPalette = 1,
+};
+
+template <class Tp>
+void Append(std::vector<std::uint8_t> &dst, const Tp *data, std::size_t count) {
+  auto size = dst.size();
+  dst.resize(size + count * sizeof(Tp));
+  std::memcpy(dst.data() + size, data, count * sizeof(Tp));
+}
+
+template <class Tp>
+void Append(std::vector<std::uint8_t> &dst, Tp value) {
+  Append(dst, &value, 1);
+}
+
+void AppendVarint(std::vector<std::uint8_t> &dst, std::uint32_t value) {
+  while (value >= 0x80) {
+    dst.push_back(std::uint8_t(value | 0x80));
+    value >>= 7;
+  }
+  dst.push_back(std::uint8_t(value));
+}
+
+/// Runs of index words, a varint count << 1 | 1 then the repeated word,
+/// or count << 1 then count different words. Layers of the same block
+/// become a single run.
+void AppendWords(std::vector<std::uint8_t> &dst, std::span<const std::uint64_t> words) {
+  std::size_t literal = 0;
+  auto flush_literal = [&](std::size_t end) {
+    if (literal != end) {
+      AppendVarint(dst, std::uint32_t(end - literal) << 1);
+      Append(dst, words.data() + literal, end - literal);
+    }
+  };
+
+  for (std::size_t i = 0; i != words.size();) {
+    auto end = i + 1;
+    while (end != words.size() && words[end] == words[i]) {
+      ++end;
+    }
+    // A repeat takes the count and one word, pairs stay literal
+    if (end - i > 2) {
+      flush_literal(i);
+      AppendVarint(dst, std::uint32_t(end - i) << 1 | 1);
+      Append(dst, words[i]);
+      literal = end;
+    }
+    i = end;
+  }
+  flush_literal(words.size());
+}
+
+class Reader {
+public:
+  explicit Reader(std::span<const std::uint8_t> src) noexcept : src_(src) {}
+
+  template <class Tp>
+  void Read(Tp *dst, std::size_t count) {
+    if (count > (src_.size() - offset_) / sizeof(Tp)) {
+      throw std::runtime_error("The encoded chunk is truncated!");
+    }
+    std::memcpy(dst, src_.data() + offset_, count * sizeof(Tp));
+    offset_ += count * sizeof(Tp);
+  }
+
+  template <class Tp>
+  Tp Read() {
+    Tp value;
+    Read(&value, 1);
+    return value;
+  }
+
+  std::uint32_t ReadVarint() {
+    std::uint32_t value = 0;
+    for (std::uint32_t shift = 0; shift < 32; shift += 7) {
+      auto byte = Read<std::uint8_t>();
+      value |= std::uint32_t(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        return value;
+      }
+    }
+    throw std::runtime_error("The encoded chunk has a bad varint!");
+  }
+
+  [[nodiscard]] bool IsEnd() const noexcept {
+    return offset_ == src_.size();
+  }
+
+private:
+  std::span<const std::uint8_t> src_;
+  std::size_t offset_ = 0;
+};
+
+/// Whether all indices in the word are in the palette
+bool IsWordInPalette(std::uint64_t word, std::uint32_t bits, std::size_t palette_size) noexcept {
+  if (palette_size == std::size_t(1) << bits) {
+    return true;
+  }
+  auto mask = (std::uint64_t(1) << bits) - 1;
+  for (std::uint32_t shift = 0; shift != 64; shift += bits) {
+    if (((word >> shift) & mask) >= palette_size) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::unique_ptr<PaletteStorage> ReadStorage(Reader &reader) {
+  auto bits = std::uint32_t(reader.Read<std::uint8_t>());
+  if (bits == 0 || bits > 16 || !std::has_single_bit(bits)) {
+    throw std::runtime_error("The encoded chunk has bad bits per index!");
+  }
+  auto palette_size = reader.Read<std::uint32_t>();
+  if (palette_size < 2 || palette_size > (std::size_t(1) << bits)) {
+    throw std::runtime_error("The encoded chunk has a bad palette size!");
+  }
+  std::vector<BlockId> palette(palette_size);
+  reader.Read(palette.data(), palette.size());
+
+  // Only distinct words are checked, a run is checked once
+  std::vector<std::uint64_t> words(ChunkSection::kVolume * bits / 64);
+  for (std::size_t i = 0; i != words.size();) {
+    auto run = reader.ReadVarint();
+    auto count = run >> 1;
+    if (count == 0 || count > words.size() - i) {
+      throw std::runtime_error("The encoded chunk has a bad run!");
+    }
+    if (run & 1) {
+      auto word = reader.Read<std::uint64_t>();
+      if (!IsWordInPalette(word, bits, palette_size)) {
+        throw std::runtime_error("The encoded chunk has an index out of the palette!");
+      }
+      std::fill_n(words.begin() + i, count, word);
+    } else {
+      reader.Read(words.data() + i, count);
+      for (std::size_t j = i; j != i + count; ++j) {
+        if (!IsWordInPalette(words[j], bits, palette_size)) {
+          throw std::runtime_error("The encoded chunk has an index out of the palette!");
+        }
+      }
+    }
+    i += count;
+  }
+  return std::make_unique<PaletteStorage>(ChunkSection::kVolume, std::move(palette), bits, std::move(words));
+}
+
+} // namespace
+
+void EncodeChunk(const Chunk &chunk, std::vector<std::uint8_t> &dst) {
+  for (std::size_t i = 0; i != Chunk::kSections; ++i) {
+    auto &section = chunk.GetSection(i);
+    auto storage = section.GetStorage();
+    // A filled section keeps its storage with one block, stored as a tag
+    if (storage == nullptr || storage->IsUniform()) {
+      Append(dst, kUniform);
+      Append(dst, section.GetUniformBlock());
+      continue;
+    }
+
+    auto palette = storage->GetPalette();
+    Append(dst, kPalette);
+    Append(dst, std::uint8_t(storage->GetBitsPerIndex()));
+    Append(dst, std::uint32_t(palette.size()));
+    Append(dst, palette.data(), palette.size());
+    AppendWords(dst, storage->GetWords());
+  }
+}
+
+void DecodeChunk(std::span<const std::uint8_t> src, Chunk &chunk) {
+  Reader reader(src);
+  for (std::size_t i = 0; i != Chunk::kSections; ++i) {
+    auto &section = chunk.GetSection(i);
+    switch (reader.Read<std::uint8_t>()) {
+    case kUniform:
+      section.Fill(reader.Read<BlockId>());
+      break;
+    case kPalette:
+      section.Assign(ReadStorage(reader));
+      break;
+    default:
+      throw std::runtime_error("The encoded chunk has an unknown section!");
+    }
+  }
+  if (!reader.IsEnd()) {
+    throw std::runtime_error("The encoded chunk has trailing bytes!");
+  }
+}
@@ -0,0 +1,21 @@
+#pragma once
+#ifndef VKMC_CHUNK_CODEC_H_
+#define VKMC_CHUNK_CODEC_H_
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "chunk.h"
+
+/// Append the chunk to the buffer in a stable compressed form. Each
+/// section is a tag byte, then the block of a uniform section, or the bits
+/// per index, the palette and the run-length coded index words. Equal
+/// chunks built in the same order always give the same bytes.
+void EncodeChunk(const Chunk &, std::vector<std::uint8_t> &dst);
+
+/// Replace the blocks of the chunk with the encoded ones, throws if the
+/// data is malformed
+void DecodeChunk(std::span<const std::uint8_t> src, Chunk &);
+
+#endif // VKMC_CHUNK_CODEC_H_
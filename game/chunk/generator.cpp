@@ -1,55 +1,299 @@
+#include <algorithm>
+#include <cmath>
 #include <random>
+#include <vector>
 
 #include "generator.h"
 
-ChunkGenerator::ChunkGenerator(std::uint64_t seed) noexcept : perlin_(std::mt19937_64(seed)) {}
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// The width of the noise band around zero carved as caves
+constexpr float kCaveWidth = .06f;
+
+float Lerp(float a, float b, float t) noexcept {
+  return a + (b - a) * t;
+}
+
+float SmoothStep(float edge0, float edge1, float x) noexcept {
+  auto t = std::clamp((x - edge0) / (edge1 - edge0), 0.f, 1.f);
+  return t * t * (3 - 2 * t);
+}
+
+/// Octaves of doubling frequency and halving amplitude, each octave is
+/// offset so they do not all vanish at the origin
+template <std::size_t Permu, std::size_t N>
+void SampleFbm(
+    const Perlin<Permu> &perlin,
+    const std::array<float, N> &xs, const std::array<float, N> &zs,
+    std::array<float, N> &dst, int octaves, float frequency
+) noexcept {
+  std::array<float, N> px, pz, value;
+  dst.fill(0);
+  float amplitude = 1;
+  for (int octave = 0; octave != octaves; ++octave) {
+    for (std::size_t i = 0; i != N; ++i) {
+      px[i] = xs[i] * frequency;
+      pz[i] = zs[i] * frequency + float(octave) * 31.7f;
+    }
+    perlin(px.data(), pz.data(), value.data(), N);
+    for (std::size_t i = 0; i != N; ++i) {
+      dst[i] += value[i] * amplitude;
+    }
+    amplitude *= .5f;
+    frequency *= 2;
+  }
+}
+
+} // namespace
+
+ChunkGenerator::ChunkGenerator(std::uint64_t seed) noexcept
+    : perlin_(std::mt19937_64(seed)),
+      temperature_(std::mt19937_64(seed + 1)),
+      hilliness_(std::mt19937_64(seed + 2)),
+      overhang_(std::mt19937_64(seed + 3)),
+      cave_(std::mt19937_64(seed + 4)),
+      biome_cache_(kCacheCapacity),
+      height_cache_(kCacheCapacity),
+      counters_{} {}
+
+void ChunkGenerator::Record(Stage stage, Clock::time_point start, bool cache_hit) noexcept {
+  auto &counter = counters_[std::uint32_t(stage)];
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+  counter.runs.fetch_add(1, std::memory_order_relaxed);
+  counter.nanoseconds.fetch_add(elapsed.count(), std::memory_order_relaxed);
+  counter.cache_hits.fetch_add(cache_hit, std::memory_order_relaxed);
+}
+
+std::array<ChunkGenerator::StageStats, ChunkGenerator::kStages> ChunkGenerator::GetStageStats() const noexcept {
+  std::array<StageStats, kStages> stats;
+  for (std::size_t i = 0; i != kStages; ++i) {
+    stats[i] = {
+        .runs = counters_[i].runs.load(std::memory_order_relaxed),
+        .nanoseconds = counters_[i].nanoseconds.load(std::memory_order_relaxed),
+        .cache_hits = counters_[i].cache_hits.load(std::memory_order_relaxed),
+    };
+  }
+  return stats;
+}
+
+const char *ChunkGenerator::GetStageName(Stage stage) noexcept {
+  switch (stage) {
+    case Stage::kBiome: return "biome";
+    case Stage::kHeight: return "height";
+    case Stage::kDensity: return "density";
+    case Stage::kDecoration: return "decoration";
+  }
+  return "unknown";
+}
+
+std::shared_ptr<const ChunkGenerator::BiomeMap> ChunkGenerator::GetBiomeMap(ChunkId id) {
+  auto start = Clock::now();
+  auto [map, hit] = biome_cache_.GetOrMake(id, [&] { return MakeBiomeMap(id); });
+  Record(Stage::kBiome, start, hit);
+  return map;
+}
+
+std::shared_ptr<const ChunkGenerator::HeightMap> ChunkGenerator::GetHeightMap(ChunkId id) {
+  auto biome = GetBiomeMap(id);
+  auto start = Clock::now();
+  auto [map, hit] = height_cache_.GetOrMake(id, [&] { return MakeHeightMap(id, *biome); });
+  Record(Stage::kHeight, start, hit);
+  return map;
+}
+
+ChunkGenerator::BiomeMap ChunkGenerator::MakeBiomeMap(ChunkId id) const noexcept {
+  std::array<float, kLatticeSize> xs, zs;
+  for (std::int32_t i = 0; i != kCells; ++i) {
+    for (std::int32_t j = 0; j != kCells; ++j) {
+      xs[i * kCells + j] = float(id.x * std::int32_t(Chunk::kLength) + i * kCellSize);
+      zs[i * kCells + j] = float(id.y * std::int32_t(Chunk::kLength) + j * kCellSize);
+    }
+  }
+
+  BiomeMap map;
+  SampleFbm(temperature_, xs, zs, map.temperature, 2, 1.f / 512);
+  SampleFbm(hilliness_, xs, zs, map.hilliness, 3, 1.f / 256);
+  for (auto &hilliness : map.hilliness) {
+    hilliness = SmoothStep(-.15f, .35f, hilliness);
+  }
+  return map;
+}
+
+ChunkGenerator::HeightMap ChunkGenerator::MakeHeightMap(ChunkId id, const BiomeMap &biome) const noexcept {
+  std::array<float, kLatticeSize> xs, zs;
+  for (std::int32_t i = 0; i != kCells; ++i) {
+    for (std::int32_t j = 0; j != kCells; ++j) {
+      xs[i * kCells + j] = float(id.x * std::int32_t(Chunk::kLength) + i * kCellSize);
+      zs[i * kCells + j] = float(id.y * std::int32_t(Chunk::kLength) + j * kCellSize);
+    }
+  }
+
+  HeightMap map;
+  SampleFbm(perlin_, xs, zs, map.height, 5, 1.f / 128);
+  for (std::size_t i = 0; i != kLatticeSize; ++i) {
+    auto hilliness = biome.hilliness[i];
+    map.height[i] = kGroundHeight + Lerp(4, kMountainRise, hilliness) +
+                    map.height[i] * Lerp(8, kMountainAmplitude, hilliness);
+  }
+  return map;
+}
 
 void ChunkGenerator::Generate(
     const BlockRegistry &registry,
     Chunk &chunk, std::int32_t x, std::int32_t z
 ) {
-  auto dirt = registry.GetBlockId("dirt");
-  auto grass = registry.GetBlockId("grass_block");
-
-  x *= kSamples;
-  z *= kSamples;
+  constexpr std::int32_t n = kCells + 1;
+  constexpr std::int32_t ny = kVerticalCells + 1;
+  constexpr std::int32_t length = Chunk::kLength;
+  constexpr std::int32_t height = Chunk::kHeight;
 
-  // Sample distance between two blocks
-  constexpr auto dx = float(kSamples) / Chunk::kLength;
-  constexpr auto dz = float(kSamples) / Chunk::kLength;
+  // The lattice of the chunk and the first points of the neighbours on +x and +z
+  float column_height[n][n], column_hilliness[n][n], column_temperature[n][n];
+  for (std::int32_t dx = 0; dx != 2; ++dx) {
+    for (std::int32_t dz = 0; dz != 2; ++dz) {
+      auto biome = GetBiomeMap({x + dx, z + dz});
+      auto heights = GetHeightMap({x + dx, z + dz});
+      for (std::int32_t i = dx * kCells; i != std::min(n, (dx + 1) * kCells); ++i) {
+        for (std::int32_t j = dz * kCells; j != std::min(n, (dz + 1) * kCells); ++j) {
+          auto index = (i - dx * kCells) * kCells + (j - dz * kCells);
+          column_height[i][j] = heights->height[index];
+          column_hilliness[i][j] = biome->hilliness[index];
+          column_temperature[i][j] = biome->temperature[index];
+        }
+      }
+    }
+  }
 
-  constexpr auto tiling_size = Chunk::kLength / kSamples;
+  // Density above zero is solid. It falls with the height above the
+  // terrain, the noise makes overhangs on hills.
+  auto start = Clock::now();
+  thread_local std::vector<float> density(n * n * ny), cave(n * n * ny);
+  for (std::int32_t i = 0; i != n; ++i) {
+    auto wx = float(x * length + i * kCellSize);
+    for (std::int32_t j = 0; j != n; ++j) {
+      auto wz = float(z * length + j * kCellSize);
+      auto overhang = Lerp(.1f, .8f, column_hilliness[i][j]);
+      for (std::int32_t k = 0; k != ny; ++k) {
+        auto wy = float(k * kCellSize);
+        auto index = (i * n + j) * ny + k;
+        auto base = (column_height[i][j] - wy) / 16;
+        // The noise can not turn points far from the surface
+        if (base < -1) {
+          density[index] = base;
+          cave[index] = 1;
+          continue;
+        }
+        density[index] = base > 1 ? base : base + overhang * overhang_({wx / 32, wy / 24, wz / 32});
+        cave[index] = cave_({wx / 48, wy / 32, wz / 48});
+      }
+    }
+  }
 
-  for (std::int32_t xx = 0; xx != kSamples; ++xx) {
-    for (std::int32_t zz = 0; zz != kSamples; ++zz) {
+  // Interpolate the lattice in each cell, the bounds of the corners skip
+  // cells which are all air or all solid
+  thread_local std::vector<std::uint8_t> solid(height * length * length);
+  std::ranges::fill(solid, 0);
+  auto solid_index = [](std::int32_t bx, std::int32_t by, std::int32_t bz) {
+    return (by * length + bx) * length + bz;
+  };
+  for (std::int32_t i = 0; i != kCells; ++i) {
+    for (std::int32_t j = 0; j != kCells; ++j) {
+      for (std::int32_t k = 0; k != kVerticalCells; ++k) {
+        float d[2][2][2], c[2][2][2];
+        auto d_min = 1e9f, d_max = -1e9f, c_min = 1e9f, c_max = -1e9f;
+        for (int corner = 0; corner != 8; ++corner) {
+          auto ci = corner >> 2, cj = corner >> 1 & 1, ck = corner & 1;
+          auto index = ((i + ci) * n + j + cj) * ny + k + ck;
+          d[ci][cj][ck] = density[index];
+          c[ci][cj][ck] = cave[index];
+          d_min = std::min(d_min, density[index]);
+          d_max = std::max(d_max, density[index]);
+          c_min = std::min(c_min, cave[index]);
+          c_max = std::max(c_max, cave[index]);
+        }
+        if (d_max <= 0) {
+          continue;
+        }
 
-      // Generate for each tiling
-      for (int xxx = 0; xxx != tiling_size; ++xxx) {
-        auto sample_x = xx + xxx * dx;
-        for (int zzz = 0; zzz != tiling_size; ++zzz) {
-          auto sample_z = zz + zzz * dz;
+        auto y0 = k * kCellSize;
+        auto no_cave = c_min >= kCaveWidth || c_max <= -kCaveWidth || y0 + kCellSize <= kCaveFloor;
+        for (std::int32_t bx = 0; bx != kCellSize; ++bx) {
+          auto tx = float(bx) / kCellSize;
+          for (std::int32_t by = 0; by != kCellSize; ++by) {
+            auto ty = float(by) / kCellSize;
+            for (std::int32_t bz = 0; bz != kCellSize; ++bz) {
+              auto tz = float(bz) / kCellSize;
+              auto trilinear = [&](const float (&v)[2][2][2]) {
+                return Lerp(
+                    Lerp(Lerp(v[0][0][0], v[0][1][0], tz), Lerp(v[1][0][0], v[1][1][0], tz), tx),
+                    Lerp(Lerp(v[0][0][1], v[0][1][1], tz), Lerp(v[1][0][1], v[1][1][1], tz), tx),
+                    ty
+                );
+              };
+              if (d_min <= 0 && trilinear(d) <= 0) {
+                continue;
+              }
+              if (!no_cave && y0 + by >= kCaveFloor && std::abs(trilinear(c)) < kCaveWidth) {
+                continue;
+              }
+              solid[solid_index(i * kCellSize + bx, y0 + by, j * kCellSize + bz)] = 1;
+            }
+          }
+        }
+      }
+    }
+  }
+  Record(Stage::kDensity, start);
 
-          // 0 ~ 1
-          auto value = perlin_({x + sample_x, z + sample_z}) + .5f;
-          constexpr auto max = Chunk::kLength / 8 - 1;
-          std::int32_t block_y = Chunk::kLength / 2 + max * value;
+  // The surface gets the top and filler blocks of the biome, cave floors
+  // and the undersides of overhangs stay stone
+  start = Clock::now();
+  auto stone = registry.GetBlockId("stone");
+  auto dirt = registry.GetBlockId("dirt");
+  auto grass = registry.GetBlockId("grass_block");
+  auto sand = registry.GetBlockId("sand");
 
-          auto block_x = xx * tiling_size + xxx;
-          auto block_z = zz * tiling_size + zzz;
+  // The surface blocks of each column, the layers are walked top down with
+  // the number of solid blocks above in each column
+  constexpr std::int32_t area = length * length;
+  BlockId tops[area], fillers[area];
+  std::int32_t depths[area]{};
+  for (std::int32_t bx = 0; bx != length; ++bx) {
+    for (std::int32_t bz = 0; bz != length; ++bz) {
+      auto i = bx / kCellSize, j = bz / kCellSize;
+      auto tx = float(bx % kCellSize) / kCellSize, tz = float(bz % kCellSize) / kCellSize;
+      auto bilinear = [&](const float (&v)[n][n]) {
+        return Lerp(Lerp(v[i][j], v[i][j + 1], tz), Lerp(v[i + 1][j], v[i + 1][j + 1], tz), tx);
+      };
 
-          for (int i = Chunk::kLength - 1; i != block_y; --i) {
-            chunk(block_x, i, block_z) = BlockRegistry::kAir;
-          }
-          chunk(block_x, block_y, block_z) = grass;
-          if (block_y == 0) {
-            continue;
-          }
+      auto column = bx * length + bz;
+      tops[column] = grass;
+      fillers[column] = dirt;
+      if (bilinear(column_temperature) > .25f) {
+        tops[column] = fillers[column] = sand;
+      } else if (bilinear(column_hilliness) > .7f && bilinear(column_height) > 112) {
+        tops[column] = fillers[column] = stone;
+      }
+    }
+  }
 
-          while (--block_y >= 0) {
-            chunk(block_x, block_y, block_z) = dirt;
-          }
-        }
+  thread_local std::vector<BlockId> blocks(height * length * length);
+  for (std::int32_t by = height - 1; by >= 0; --by) {
+    auto layer = by * area;
+    for (std::int32_t column = 0; column != area; ++column) {
+      if (!solid[layer + column]) {
+        blocks[layer + column] = blocks::kAir;
+        continue;
       }
+      auto depth = depths[column]++;
+      blocks[layer + column] = depth == 0 ? tops[column] : depth < 4 ? fillers[column] : stone;
     }
   }
+
+  for (std::size_t s = 0; s != Chunk::kSections; ++s) {
+    chunk.GetSection(s).Assign(blocks.data() + s * ChunkSection::kVolume);
+  }
+  Record(Stage::kDecoration, start);
 }
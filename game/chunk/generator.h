@@ -2,28 +2,117 @@
 #ifndef VKMC_GENERATOR_H_
 #define VKMC_GENERATOR_H_
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 
 #include "../block/registry.h"
 #include "../math/perlin.h"
 #include "chunk.h"
+#include "stage_cache.h"
 
+/// Generates chunks in stages: a biome map, a heightmap of fBm octaves, a
+/// 3-D density for overhangs and caves, and the surface decoration. The
+/// 2-D stages are sampled on a coarse lattice and cached by chunk, so the
+/// neighbours reuse the samples on their shared borders.
 class ChunkGenerator {
+public:
+  enum class Stage : std::uint32_t {
+    kBiome,
+    kHeight,
+    kDensity,
+    kDecoration,
+  };
+  static constexpr std::size_t kStages = 4;
+
+  struct StageStats {
+    std::uint64_t runs;
+    std::uint64_t nanoseconds;
+    /// The runs served by the cache, only the 2-D stages are cached
+    std::uint64_t cache_hits;
+  };
+
 private:
-  /// The number of smaples for each chunk
-  static constexpr std::int32_t kSamples = 4;
+  /// The blocks between two lattice points on each axis
+  static constexpr std::int32_t kCellSize = 4;
+  /// The lattice points of a chunk on x and z, the last row of cells
+  /// ends at the first points of the neighbours
+  static constexpr std::int32_t kCells = Chunk::kLength / kCellSize;
+  static constexpr std::int32_t kVerticalCells = Chunk::kHeight / kCellSize;
+  static constexpr std::size_t kLatticeSize = kCells * kCells;
+
+  /// The height terrain is centred on
+  static constexpr float kGroundHeight = Chunk::kLength * 2;
+  /// The rise of mountains above the ground and the amplitude of their
+  /// height noise, plains have a fraction of both
+  static constexpr float kMountainRise = 24;
+  static constexpr float kMountainAmplitude = 56;
+  /// Caves are not carved below this height
+  static constexpr std::int32_t kCaveFloor = 4;
+  /// The chunks each 2-D stage keeps
+  static constexpr std::size_t kCacheCapacity = 4096;
+
+  /// The climate of the lattice points of a chunk, indexed by [x][z]
+  struct BiomeMap {
+    std::array<float, kLatticeSize> temperature;
+    /// 0 for plains to 1 for mountains
+    std::array<float, kLatticeSize> hilliness;
+  };
+
+  /// The terrain height of the lattice points of a chunk, indexed by [x][z]
+  struct HeightMap {
+    std::array<float, kLatticeSize> height;
+  };
 
 public:
+  /// No block is generated at or above this height. The fBm of the height
+  /// map is within ±2, the density turns solid up to 16 blocks above it
+  /// and a cell more in the interpolation.
+  static constexpr std::int32_t kMaxHeight =
+      std::int32_t(kGroundHeight + kMountainRise + 2 * kMountainAmplitude) + 16 + kCellSize;
 
   ChunkGenerator(std::uint64_t seed) noexcept;
 
+  /// Fill the chunk at (x, z), it is safe to generate different chunks
+  /// on several threads at the same time. The blocks only depend on the
+  /// seed and the position, not on the cache or the order of calls.
   void Generate(
       const BlockRegistry &registry,
       Chunk &chunk, std::int32_t x, std::int32_t z
   );
 
+  [[nodiscard]] std::array<StageStats, kStages> GetStageStats() const noexcept;
+
+  [[nodiscard]] static const char *GetStageName(Stage) noexcept;
+
 private:
+  struct StageCounter {
+    std::atomic<std::uint64_t> runs;
+    std::atomic<std::uint64_t> nanoseconds;
+    std::atomic<std::uint64_t> cache_hits;
+  };
+
+  std::shared_ptr<const BiomeMap> GetBiomeMap(ChunkId);
+  std::shared_ptr<const HeightMap> GetHeightMap(ChunkId);
+
+  /// Add a run of the stage which began at start to its counter
+  void Record(Stage, std::chrono::steady_clock::time_point start, bool cache_hit = false) noexcept;
+
+  [[nodiscard]] BiomeMap MakeBiomeMap(ChunkId) const noexcept;
+  [[nodiscard]] HeightMap MakeHeightMap(ChunkId, const BiomeMap &) const noexcept;
+
   Perlin<512> perlin_;
+  Perlin<512> temperature_;
+  Perlin<512> hilliness_;
+  Perlin<512> overhang_;
+  Perlin<512> cave_;
+
+  StageCache<BiomeMap> biome_cache_;
+  StageCache<HeightMap> height_cache_;
+  std::array<StageCounter, kStages> counters_;
 };
 
 #endif // VKMC_GENERATOR_H_
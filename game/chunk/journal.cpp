@@ -0,0 +1,122 @@
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "journal.h"
+
+static_assert(std::endian::native == std::endian::little, "Journals are little endian");
+
+namespace {
+
+struct Record {
+  std::int32_t chunk_x;
+  std::int32_t chunk_z;
+  /// x | y << 5 | z << 13
+  std::uint32_t position;
+  BlockId old_block;
+  BlockId new_block;
+  /// FNV-1a of the fields before
+  std::uint32_t check;
+};
+
+static_assert(sizeof(Record) == 24);
+
+std::uint32_t GetCheck(const Record &record) noexcept {
+  auto bytes = reinterpret_cast<const std::uint8_t *>(&record);
+  std::uint32_t hash = 2166136261u;
+  for (std::size_t i = 0; i != offsetof(Record, check); ++i) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
+
+Record MakeRecord(const BlockEdit &edit) noexcept {
+  Record record{
+      .chunk_x = edit.chunk.x,
+      .chunk_z = edit.chunk.y,
+      .position = std::uint32_t(edit.position.x) | std::uint32_t(edit.position.y) << 5 |
+                  std::uint32_t(edit.position.z) << 13,
+      .old_block = edit.old_block,
+      .new_block = edit.new_block,
+      .check = 0,
+  };
+  record.check = GetCheck(record);
+  return record;
+}
+
+BlockEdit MakeEdit(const Record &record) noexcept {
+  return {
+      .chunk = {record.chunk_x, record.chunk_z},
+      .position = {record.position & 31, (record.position >> 5) & 255, (record.position >> 13) & 31},
+      .old_block = record.old_block,
+      .new_block = record.new_block,
+  };
+}
+
+} // namespace
+
+BlockJournal::BlockJournal(const std::filesystem::path &path) : path_(path), file_(nullptr), size_(0) {
+  if (std::filesystem::exists(path)) {
+    file_ = Open("rb");
+    Record record;
+    while (std::fread(&record, sizeof(record), 1, file_) == 1 && record.check == GetCheck(record)) {
+      recovered_.emplace_back(MakeEdit(record));
+    }
+    std::fclose(file_);
+    size_ = recovered_.size() * sizeof(Record);
+    std::filesystem::resize_file(path, size_);
+  }
+  file_ = Open("ab");
+}
+
+BlockJournal::~BlockJournal() {
+  std::fclose(file_);
+}
+
+void BlockJournal::Append(std::span<const BlockEdit> edits) {
+  std::vector<Record> records;
+  records.reserve(edits.size());
+  for (auto &edit : edits) {
+    records.emplace_back(MakeRecord(edit));
+  }
+  if (std::fwrite(records.data(), sizeof(Record), records.size(), file_) != records.size() ||
+      std::fflush(file_) != 0) {
+    throw std::runtime_error("Failed to write the journal " + path_.string() + "!");
+  }
+  size_ += records.size() * sizeof(Record);
+#ifdef _WIN32
+  auto synced = _commit(_fileno(file_)) == 0;
+#else
+  auto synced = fdatasync(fileno(file_)) == 0;
+#endif
+  if (!synced) {
+    throw std::runtime_error("Failed to sync the journal " + path_.string() + "!");
+  }
+}
+
+void BlockJournal::Clear() {
+  // The old file stays open if the truncated one can not be opened
+  auto file = Open("wb");
+  std::fclose(file_);
+  file_ = file;
+  size_ = 0;
+}
+
+std::FILE *BlockJournal::Open(const char *mode) const {
+#ifdef _WIN32
+  auto file = _wfopen(path_.c_str(), mode[0] == 'a' ? L"ab" : mode[0] == 'w' ? L"wb" : L"rb");
+#else
+  auto file = std::fopen(path_.c_str(), mode);
+#endif
+  if (file == nullptr) {
+    throw std::runtime_error("Could not open the journal " + path_.string() + "!");
+  }
+  return file;
+}
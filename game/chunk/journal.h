@@ -0,0 +1,63 @@
+#pragma once
+#ifndef VKMC_CHUNK_JOURNAL_H_
+#define VKMC_CHUNK_JOURNAL_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include <common/classes.h>
+
+#include "../block/types.h"
+#include "chunk.h"
+
+/// A block changed by the player
+struct BlockEdit {
+  ChunkId chunk;
+  /// The position in the chunk
+  glm::ivec3 position;
+  BlockId old_block;
+  BlockId new_block;
+};
+
+/// An append-only log of block edits. Each record has a checksum, a record
+/// torn by a crash ends the log.
+class BlockJournal : NonCopyMove {
+public:
+  /// Open the journal, it is created if missing. The valid records are
+  /// read first, a torn record at the end is cut off.
+  explicit BlockJournal(const std::filesystem::path &path);
+
+  ~BlockJournal();
+
+  /// The edits which were in the journal when it was opened
+  [[nodiscard]] const std::vector<BlockEdit> &GetRecovered() const noexcept {
+    return recovered_;
+  }
+
+  /// Append the edits and wait until they are on the disk, throws if they
+  /// could not be written or synced
+  void Append(std::span<const BlockEdit> edits);
+
+  /// Remove all edits, after the chunks they changed were saved
+  void Clear();
+
+  /// The bytes in the journal
+  [[nodiscard]] std::uint64_t GetSize() const noexcept {
+    return size_;
+  }
+
+private:
+  [[nodiscard]] std::FILE *Open(const char *mode) const;
+
+  std::filesystem::path path_;
+  std::FILE *file_;
+  std::uint64_t size_;
+  std::vector<BlockEdit> recovered_;
+};
+
+#endif // VKMC_CHUNK_JOURNAL_H_
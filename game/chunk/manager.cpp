@@ -1,95 +1,260 @@
 #include "manager.h"
 
-#include <application.h>
-#include <bitset>
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <iostream>
 #include <ranges>
+
+#include <application.h>
 #include <event.h>
 
 #include "manager.h"
 #include "../events.h"
 
-ChunkManager::ChunkManager(std::uint64_t seed) : generator_(seed), valid_(false) {
+ChunkManager::ChunkManager(std::uint64_t seed, WorkerPool &workers)
+    : generator_(seed), workers_(workers), storage_(nullptr), load_budget_(8) {
+  SetRenderDistance(8, 2);
   chunk_load_ = &events::global.RegisterEvent(events::kChunkLoaded);
   chunk_unload_ = &events::global.RegisterEvent(events::kChunkUnloaded);
   chunk_update_ = &events::global.RegisterEvent(events::kChunkUpdate);
 }
 
-void ChunkManager::LoadAutomatic(const BlockRegistry &registry, const glm::ivec3 &pos) {
-  auto chunk = Chunk::GetChunkIdFromWorldPosition(pos);
-  std::array<glm::ivec2, 9> new_load;
-  std::bitset<9> keep;
-  {
-    auto it = new_load.begin();
-    constexpr auto offset = std::array{-1, 0, 1};
-    for (auto x : offset) {
-      for (auto y : offset) {
-        *it = {chunk.x + x, chunk.y + y};
-        if (valid_) {
-          int i = 0;
-          for (auto &l : loaded_) {
-            if (l == *it) {
-              keep[i] = true;
-            }
-            ++i;
-          }
-        }
-        ++it;
+ChunkManager::~ChunkManager() {
+  // Jobs hold the generator and the result list of this manager
+  workers_.Wait();
+  if (storage_ != nullptr) {
+    Checkpoint();
+  }
+}
+
+void ChunkManager::Recover(const BlockRegistry &registry) {
+  auto edits = storage_->TakeRecoveredEdits();
+  if (edits.empty()) {
+    return;
+  }
+
+  // The chunks may be saved with some of the edits already, replaying all
+  // of them in order ends with the last block of each position
+  std::unordered_map<ChunkId, std::vector<BlockEdit>, ChunkIdHash> chunk_edits;
+  for (auto &edit : edits) {
+    chunk_edits[edit.chunk].emplace_back(edit);
+  }
+  for (auto &[id, list] : chunk_edits) {
+    auto chunk = pool_.Acquire();
+    Make(registry, id, *chunk);
+    for (auto &edit : list) {
+      chunk->Set(edit.position, edit.new_block);
+    }
+    storage_->Save(id, std::move(chunk));
+  }
+  storage_->Checkpoint();
+}
+
+void ChunkManager::Checkpoint() {
+  SaveModified();
+  storage_->Checkpoint();
+}
+
+void ChunkManager::SaveModified() {
+  for (auto id : modified_) {
+    // The loaded chunk is still edited, the storage gets a copy which
+    // reuses the section storages of a recycled chunk
+    auto copy = pool_.Acquire();
+    *copy = **chunks_.Find(id);
+    storage_->Save(id, std::move(copy));
+  }
+  modified_.clear();
+}
+
+void ChunkManager::SetRenderDistance(std::int32_t distance, std::int32_t margin) {
+  // d^2 <= r^2 + r is about (r + 0.5)^2, the circle isn't pinched at the axes
+  auto load_distance2 = distance * distance + distance;
+  auto unload = distance + margin;
+  unload_distance2_ = unload * unload + unload;
+
+  load_order_.clear();
+  for (std::int32_t x = -distance; x <= distance; ++x) {
+    for (std::int32_t y = -distance; y <= distance; ++y) {
+      if (x * x + y * y <= load_distance2) {
+        load_order_.emplace_back(x, y);
       }
     }
   }
 
-  for (int i = 0; i != loaded_.size(); ++i) {
-    if (!keep[i]) {
-      Unload(loaded_[i]);
+  // Spiral outward: by ring distance, then by angle inside a ring
+  std::ranges::sort(load_order_, [](ChunkId a, ChunkId b) {
+    auto da = a.x * a.x + a.y * a.y;
+    auto db = b.x * b.x + b.y * b.y;
+    if (da != db) {
+      return da < db;
+    }
+    return std::atan2(float(a.y), float(a.x)) < std::atan2(float(b.y), float(b.x));
+  });
+
+  load_cursor_ = 0;
+  center_.reset();
+
+  // Unloaded chunks wait for the storage and chunks unloaded while
+  // generating wait for Integrate, an eighth more covers them
+  std::size_t in_range = 0;
+  for (std::int32_t x = -unload; x <= unload; ++x) {
+    for (std::int32_t y = -unload; y <= unload; ++y) {
+      in_range += x * x + y * y <= unload_distance2_;
+    }
+  }
+  pool_.Reserve(in_range + in_range / 8);
+}
+
+void ChunkManager::LoadAutomatic(const BlockRegistry &registry, const glm::ivec3 &pos) {
+  auto center = Chunk::GetChunkIdFromWorldPosition(pos);
+  auto out_of_range = [&](ChunkId id) {
+    auto d = id - center;
+    return d.x * d.x + d.y * d.y > unload_distance2_;
+  };
+
+  if (center_ != center) {
+    center_ = center;
+    load_cursor_ = 0;
+
+    // One pass over the loaded chunks, each test is O(1)
+    std::vector<ChunkId> unload;
+    for (auto entry : chunks_) {
+      if (out_of_range(entry.id)) {
+        unload.emplace_back(entry.id);
+      }
+    }
+    for (auto &id : pending_) {
+      if (out_of_range(id)) {
+        unload.emplace_back(id);
+      }
+    }
+    for (auto id : unload) {
+      Unload(id);
     }
   }
 
-  for (auto &c : new_load) {
-    auto &chunk = Load(registry, c);
+  for (std::size_t budget = load_budget_; budget && load_cursor_ != load_order_.size(); ++load_cursor_) {
+    auto id = center + load_order_[load_cursor_];
+    if (!chunks_.Contains(id) && !pending_.contains(id)) {
+      Request(registry, id);
+      --budget;
+    }
   }
-  loaded_ = new_load;
-  valid_ = true;
 }
 
 Chunk &ChunkManager::Load(const BlockRegistry &registry, ChunkId id) {
-  auto [it, add] = chunks_.try_emplace(id);
+  auto [chunk, add] = chunks_.TryEmplace(id);
   if (add) {
-    generator_.Generate(registry, it->second, id.x, id.y);
-    chunk_load_->EmitArgs(id, &it->second);
+    *chunk = pool_.Acquire();
+    Make(registry, id, **chunk);
+    pending_.erase(id);
+    chunk_load_->EmitArgs(id, chunk->get());
+  }
+  return **chunk;
+}
+
+void ChunkManager::Request(const BlockRegistry &registry, ChunkId id) {
+  if (chunks_.Contains(id) || !pending_.emplace(id).second) {
+    return;
+  }
+
+  workers_.Submit([this, &registry, id] {
+    auto chunk = pool_.Acquire();
+    Make(registry, id, *chunk);
+    std::lock_guard lock(generated_mutex_);
+    generated_.emplace_back(id, std::move(chunk));
+  });
+}
+
+void ChunkManager::Make(const BlockRegistry &registry, ChunkId id, Chunk &chunk) {
+  if (storage_ != nullptr) {
+    try {
+      if (storage_->Load(id, chunk)) {
+        return;
+      }
+    } catch (std::exception &e) {
+      std::cerr << "Failed to load chunk (" << id.x << ", " << id.y << "): " << e.what() << '\n';
+    }
+  }
+  generator_.Generate(registry, chunk, id.x, id.y);
+}
+
+void ChunkManager::Integrate() {
+  decltype(generated_) generated;
+  {
+    std::lock_guard lock(generated_mutex_);
+    generated.swap(generated_);
+  }
+
+  for (auto &[id, chunk] : generated) {
+    // Drop the chunk if it was unloaded while generating
+    if (!pending_.erase(id)) {
+      continue;
+    }
+    auto [loaded, add] = chunks_.TryEmplace(id, std::move(chunk));
+    if (add) {
+      chunk_load_->EmitArgs(id, loaded->get());
+    }
   }
-  return it->second;
 }
 
 void ChunkManager::Unload(ChunkId id) {
-  if (chunks_.erase(id)) {
-    chunk_unload_->EmitArgs(id);
+  pending_.erase(id);
+  auto chunk = chunks_.Find(id);
+  if (chunk == nullptr) {
+    return;
+  }
+  if (modified_.erase(id)) {
+    storage_->Save(id, std::move(*chunk));
   }
+  chunks_.Erase(id);
+  chunk_unload_->EmitArgs(id);
 }
 
 BlockId ChunkManager::GetBlock(const glm::ivec3 &position) const noexcept {
-  if (position.y < 0 || Chunk::kLength <= position.y) {
+  if (position.y < 0 || std::int32_t(Chunk::kHeight) <= position.y) {
     return blocks::kAir;
   }
   auto id = Chunk::GetChunkIdFromWorldPosition(position);
-  auto it = chunks_.find(id);
-  if (it == chunks_.end()) {
+  auto chunk = chunks_.Find(id);
+  if (chunk == nullptr) {
     return blocks::kAir;
   }
 
-  return it->second(Chunk::GetPositionInChunk(position));
+  return (**chunk)(Chunk::GetPositionInChunk(position));
+}
+
+const Chunk *ChunkManager::GetChunk(ChunkId id) const noexcept {
+  auto chunk = chunks_.Find(id);
+  return chunk != nullptr ? chunk->get() : nullptr;
 }
 
 void ChunkManager::SetBlock(const glm::ivec3 &position, BlockId block) noexcept {
-  if (position.y < 0 || Chunk::kLength <= position.y) {
+  if (position.y < 0 || std::int32_t(Chunk::kHeight) <= position.y) {
     return;
   }
   auto id = Chunk::GetChunkIdFromWorldPosition(position);
-  auto it = chunks_.find(id);
-  if (it == chunks_.end()) {
+  auto chunk = chunks_.Find(id);
+  if (chunk == nullptr) {
     return;
   }
 
-  chunk_update_->EmitArgs(id, &it->second);
+  auto local = Chunk::GetPositionInChunk(position);
+  auto old_block = (**chunk)(local);
+  (*chunk)->Set(local, block);
+
+  // Only edited chunks are saved, the journal keeps the edits until then
+  if (storage_ != nullptr && old_block != block) {
+    storage_->Record({.chunk = id, .position = local, .old_block = old_block, .new_block = block});
+    modified_.emplace(id);
+    // The writer does the checkpoint, edits go on meanwhile
+    if (storage_->GetJournalSize() > kJournalLimit && !storage_->IsCheckpointPending()) {
+      SaveModified();
+      storage_->RequestCheckpoint();
+    }
+  }
 
-  it->second(Chunk::GetPositionInChunk(position)) = block;
+  // Subscribers rebuild from the chunk data, so emit after modification
+  chunk_update_->EmitArgs(id, chunk->get(), local);
 }
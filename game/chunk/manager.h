@@ -2,44 +2,127 @@
 #ifndef VKMC_CHUNK_MANAGER_H_
 #define VKMC_CHUNK_MANAGER_H_
 
-#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include <event/publisher.h>
 
+#include "../job/worker_pool.h"
 #include "chunk.h"
+#include "chunk_map.h"
 #include "generator.h"
+#include "pool.h"
+#include "storage.h"
 
 class ChunkManager {
 private:
-  struct ChunkIdHash {
-    std::uint64_t operator()(ChunkId val) const noexcept {
-      std::uint64_t x64 = val.x;
-      return ((x64 << 32) | val.y) ^ (x64 << 16);
-    }
-  };
-
   ChunkGenerator generator_;
-  std::unordered_map<ChunkId, Chunk, ChunkIdHash> chunks_;
-  std::array<ChunkId, 9> loaded_;
-  bool valid_;
+  WorkerPool &workers_;
+  /// Where edited chunks are saved, nullptr if they are dropped
+  ChunkStorage *storage_;
+  /// Loaded chunks edited since they were loaded, the others are the same
+  /// as generated or as saved
+  std::unordered_set<ChunkId, ChunkIdHash> modified_;
+  /// Declared before the chunks, which return to it
+  ChunkPool pool_;
+  ChunkMap<ChunkPool::Handle> chunks_;
+
+  /// Offsets of chunks within render distance, the closest first
+  std::vector<ChunkId> load_order_;
+  /// The next position of load_order_ to check
+  std::size_t load_cursor_;
+  /// Chunks farther than this squared distance are unloaded
+  std::int32_t unload_distance2_;
+  /// The maximum number of chunks requested per update
+  std::size_t load_budget_;
+  std::optional<ChunkId> center_;
   EventPublisher *chunk_load_;
   EventPublisher *chunk_unload_;
   EventPublisher *chunk_update_;
 
+  /// Chunks are being generated by workers
+  std::unordered_set<ChunkId, ChunkIdHash> pending_;
+  /// Chunks were generated by workers and wait for integration
+  std::vector<std::pair<ChunkId, ChunkPool::Handle>> generated_;
+  std::mutex generated_mutex_;
+
 public:
-  ChunkManager(std::uint64_t seed);
+  ChunkManager(std::uint64_t seed, WorkerPool &);
+
+  /// The journal is emptied by saving the edited chunks after this size,
+  /// without waiting for the storage
+  static constexpr std::uint64_t kJournalLimit = std::uint64_t(4) << 20;
+
+  /// Saves the edited chunks if there is a storage
+  ~ChunkManager();
+
+  /// Log edits to the storage, save the edited chunks when they are
+  /// unloaded and load chunks from it before generating them. The storage
+  /// must outlive the manager.
+  void SetStorage(ChunkStorage *storage) noexcept {
+    storage_ = storage;
+  }
+
+  /// Apply the edits left in the journal of the storage by a crash to the
+  /// saved chunks
+  void Recover(const BlockRegistry &registry);
+
+  /// Save the edited chunks and empty the journal, waits for the storage
+  void Checkpoint();
+
+  /// Set the radius of loaded chunks around the player. Chunks are kept
+  /// until they are farther than distance + margin to avoid thrashing.
+  /// The chunk pool grows to hold all chunks within the unload distance.
+  void SetRenderDistance(std::int32_t distance, std::int32_t margin);
 
+  /// The counters of the chunk pool
+  [[nodiscard]] ChunkPool::Stats GetPoolStats() const {
+    return pool_.GetStats();
+  }
+
+  /// Set the maximum number of chunks requested per update
+  void SetLoadBudget(std::size_t budget) noexcept {
+    load_budget_ = budget;
+  }
+
+  /// Unload the chunks out of range and request the missing ones in range,
+  /// the closest first and no more than the load budget each call
   void LoadAutomatic(const BlockRegistry &registry, const glm::ivec3 &pos);
 
+  /// Move the chunks generated by workers into the world, must be called
+  /// on the main thread, the load events are emitted here
+  void Integrate();
+
   BlockId GetBlock(const glm::ivec3 &pos) const noexcept;
 
+  /// Get a loaded chunk, returns nullptr if the chunk is not loaded
+  [[nodiscard]] const Chunk *GetChunk(ChunkId) const noexcept;
+
   void SetBlock(const glm::ivec3 &pos, BlockId) noexcept;
 
+  /// Load or generate the chunk on the current thread if it is not loaded
   Chunk &Load(const BlockRegistry &registry, ChunkId);
 
+  /// Load or generate the chunk on a worker if it is neither loaded nor
+  /// pending
+  void Request(const BlockRegistry &registry, ChunkId);
+
+  /// Remove the chunk, it is saved if it was edited and there is a storage
   void Unload(ChunkId);
+
+private:
+  /// Fill the chunk from the storage, or generate it if it was never saved
+  void Make(const BlockRegistry &registry, ChunkId, Chunk &);
+
+  /// Queue copies of the edited chunks to the storage
+  void SaveModified();
 };
 
 #endif // VKMC_CHUNK_MANAGER_H_
@@ -0,0 +1,24 @@
+#include "neighborhood.h"
+
+const Chunk ChunkNeighborhood::kEmpty;
+
+ChunkNeighborhood::ChunkNeighborhood(const ChunkManager &chunks, ChunkId center) noexcept
+    : manager_(&chunks), center_(center + ChunkId(1)) {
+  Recenter(center);
+}
+
+void ChunkNeighborhood::Recenter(ChunkId center) noexcept {
+  if (center == center_) {
+    return;
+  }
+  center_ = center;
+  origin_x_ = (center.x - 1) * std::int32_t(Chunk::kLength);
+  origin_z_ = (center.y - 1) * std::int32_t(Chunk::kLength);
+  chunks_.fill(nullptr);
+}
+
+const Chunk &ChunkNeighborhood::Find(std::int32_t index) const noexcept {
+  auto chunk = manager_->GetChunk({center_.x + index % kLength - 1, center_.y + index / kLength - 1});
+  chunks_[index] = chunk != nullptr ? chunk : &kEmpty;
+  return *chunks_[index];
+}
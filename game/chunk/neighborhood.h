@@ -0,0 +1,92 @@
+#pragma once
+#ifndef VKMC_CHUNK_NEIGHBORHOOD_H_
+#define VKMC_CHUNK_NEIGHBORHOOD_H_
+
+#include <array>
+#include <cstdint>
+
+#include <glm/vec3.hpp>
+
+#include "chunk.h"
+#include "manager.h"
+
+/// The 3 x 3 chunks around a center chunk, each looked up once when first
+/// read. A block near the center is then read by indexing the array of
+/// chunks instead of a map lookup per block, blocks farther away fall
+/// back to the manager.
+/// Missing chunks read as air like ChunkManager::GetBlock. The chunks are
+/// only valid until chunks are unloaded, keep a neighbourhood for one
+/// query like a ray or a physics step.
+class ChunkNeighborhood {
+public:
+  /// The chunks on each axis
+  static constexpr std::int32_t kLength = 3;
+
+  ChunkNeighborhood(const ChunkManager &chunks, ChunkId center) noexcept;
+
+  /// Move to another center, does nothing if it is the same center
+  void Recenter(ChunkId center) noexcept;
+
+  [[nodiscard]] ChunkId GetCenter() const noexcept {
+    return center_;
+  }
+
+  /// The chunk at offset (dx, dz) from the center, each in [-1, 1],
+  /// nullptr if it is not loaded
+  [[nodiscard]] const Chunk *GetChunk(std::int32_t dx, std::int32_t dz) const noexcept {
+    auto chunk = &Resolve((dz + 1) * kLength + dx + 1);
+    return chunk != &kEmpty ? chunk : nullptr;
+  }
+
+  /// Whether the world position is in the chunks of the neighbourhood
+  [[nodiscard]] bool Contains(const glm::ivec3 &world) const noexcept {
+    return std::uint32_t(world.x - origin_x_) < kSpan && std::uint32_t(world.z - origin_z_) < kSpan;
+  }
+
+  /// The chunk holding the world position, which must be in the
+  /// neighbourhood. A missing chunk is all air. A reader walking through
+  /// a chunk like a ray resolves it once and indexes it from then on.
+  [[nodiscard]] const Chunk &GetChunkAt(const glm::ivec3 &world) const noexcept {
+    constexpr auto shift = std::uint32_t(ChunkSection::kLengthPow);
+    auto x = std::uint32_t(world.x - origin_x_), z = std::uint32_t(world.z - origin_z_);
+    return Resolve((z >> shift) * kLength + (x >> shift));
+  }
+
+  /// The block at a world position, air above and below the world
+  [[nodiscard]] BlockId GetBlock(const glm::ivec3 &world) const noexcept {
+    auto x = std::uint32_t(world.x - origin_x_), z = std::uint32_t(world.z - origin_z_);
+    if (x >= kSpan || z >= kSpan) {
+      return manager_->GetBlock(world);
+    }
+    if (std::uint32_t(world.y) >= Chunk::kHeight) {
+      return blocks::kAir;
+    }
+    constexpr auto shift = std::uint32_t(ChunkSection::kLengthPow), mask = std::uint32_t(Chunk::kLength - 1);
+    return Resolve((z >> shift) * kLength + (x >> shift))(int(x & mask), world.y, int(z & mask));
+  }
+
+private:
+  /// The blocks of the neighbourhood on x and z
+  static constexpr std::uint32_t kSpan = kLength * Chunk::kLength;
+
+  /// Stands in for missing chunks, all air
+  static const Chunk kEmpty;
+
+  [[nodiscard]] const Chunk &Resolve(std::int32_t index) const noexcept {
+    auto chunk = chunks_[index];
+    return chunk != nullptr ? *chunk : Find(index);
+  }
+
+  /// Look up a chunk on its first read
+  const Chunk &Find(std::int32_t index) const noexcept;
+
+  const ChunkManager *manager_;
+  ChunkId center_;
+  /// The world position of the first block of the first chunk
+  std::int32_t origin_x_;
+  std::int32_t origin_z_;
+  /// By [z][x], nullptr until looked up
+  mutable std::array<const Chunk *, kLength * kLength> chunks_;
+};
+
+#endif // VKMC_CHUNK_NEIGHBORHOOD_H_
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <utility>
+
+#include "palette.h"
+
+PaletteStorage::PaletteStorage(std::size_t size, BlockId fill) : size_(size) {
+  Fill(fill);
+}
+
+PaletteStorage::PaletteStorage(
+    std::size_t size, std::vector<BlockId> palette,
+    std::uint32_t bits, std::vector<std::uint64_t> words
+)
+    : palette_(std::move(palette)), words_(std::move(words)), size_(size) {
+  if (bits == 0 || bits > 16 || !std::has_single_bit(bits)) {
+    throw std::runtime_error("Invalid bits per palette index!");
+  }
+  SetBitsPerIndex(bits);
+  if (palette_.size() < 2 || palette_.size() > (std::size_t(1) << bits) ||
+      words_.size() != (size_ + per_word_mask_) >> per_word_shift_) {
+    throw std::runtime_error("The palette doesn't match the indices!");
+  }
+}
+
+void PaletteStorage::Fill(BlockId block) {
+  palette_.assign(1, block);
+  words_.clear();
+  bits_ = 0;
+  bits_shift_ = 0;
+  per_word_shift_ = 0;
+  per_word_mask_ = 0;
+  index_mask_ = 0;
+}
+
+void PaletteStorage::Set(std::size_t i, BlockId block) {
+  auto it = std::ranges::find(palette_, block);
+  std::size_t index = it - palette_.begin();
+  if (it == palette_.end()) {
+    if (palette_.size() == kMaxPaletteSize) {
+      throw std::runtime_error("Too many distinct blocks in a palette!");
+    }
+    palette_.emplace_back(block);
+    if (palette_.size() > (std::size_t(1) << bits_)) {
+      Grow(std::max(bits_ * 2, 1u));
+    }
+  } else if (bits_ == 0) {
+    // The only block already
+    return;
+  }
+  SetIndex(i, index);
+}
+
+void PaletteStorage::Assign(std::span<const BlockId> blocks) {
+  if (blocks.size() != size_) {
+    throw std::runtime_error("Assigned blocks don't match the storage size!");
+  }
+
+  // Runs of the same block are common, only a new block searches the
+  // palette. The storage is left as it was if the palette is too large.
+  std::vector<BlockId> palette{blocks.front()};
+  auto last = blocks.front();
+  for (auto block : blocks) {
+    if (block != last && std::ranges::find(palette, block) == palette.end()) {
+      if (palette.size() == kMaxPaletteSize) {
+        throw std::runtime_error("Too many distinct blocks in a palette!");
+      }
+      palette.emplace_back(block);
+    }
+    last = block;
+  }
+  palette_ = std::move(palette);
+
+  if (palette_.size() == 1) {
+    Fill(last);
+    return;
+  }
+
+  ResetIndices(std::bit_ceil(std::uint32_t(std::bit_width(palette_.size() - 1))));
+  last = palette_.front();
+  std::uint64_t index = 0;
+  for (std::size_t w = 0; w != words_.size(); ++w) {
+    std::uint64_t word = 0;
+    auto first = w << per_word_shift_;
+    auto count = std::min<std::size_t>(per_word_mask_ + 1, size_ - first);
+    for (std::size_t i = 0; i != count; ++i) {
+      if (blocks[first + i] != last) {
+        last = blocks[first + i];
+        index = std::ranges::find(palette_, last) - palette_.begin();
+      }
+      word |= index << (i << bits_shift_);
+    }
+    words_[w] = word;
+  }
+}
+
+void PaletteStorage::ResetIndices(std::uint32_t bits) {
+  SetBitsPerIndex(bits);
+  words_.assign((size_ + per_word_mask_) >> per_word_shift_, 0);
+}
+
+void PaletteStorage::SetBitsPerIndex(std::uint32_t bits) noexcept {
+  bits_ = bits;
+  bits_shift_ = std::countr_zero(bits);
+  per_word_shift_ = std::countr_zero(64 / bits);
+  per_word_mask_ = (64 / bits) - 1;
+  index_mask_ = (std::uint64_t(1) << bits) - 1;
+}
+
+void PaletteStorage::Grow(std::uint32_t bits) {
+  std::vector<std::uint64_t> old_words(std::move(words_));
+  auto old_bits = bits_;
+  auto old_bits_shift = bits_shift_;
+  auto old_per_word_shift = per_word_shift_;
+  auto old_per_word_mask = per_word_mask_;
+  auto old_index_mask = index_mask_;
+
+  ResetIndices(bits);
+
+  if (old_bits == 0) {
+    // Every block was the palette entry 0
+    return;
+  }
+
+  for (std::size_t i = 0; i != size_; ++i) {
+    auto word = old_words[i >> old_per_word_shift];
+    auto shift = (i & old_per_word_mask) << old_bits_shift;
+    SetIndex(i, (word >> shift) & old_index_mask);
+  }
+}
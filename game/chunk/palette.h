@@ -0,0 +1,109 @@
+#pragma once
+#ifndef VKMC_CHUNK_PALETTE_H_
+#define VKMC_CHUNK_PALETTE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "../block/types.h"
+
+/// Block storage that keeps each distinct block id once in a palette and
+/// stores bit-packed palette indices for the blocks. An index takes 0, 1,
+/// 2, 4, 8 or 16 bits, the width grows automatically when a new block id
+/// does not fit. A storage filled with a single block id has no indices.
+class PaletteStorage {
+public:
+  /// The maximum number of distinct block ids
+  static constexpr std::size_t kMaxPaletteSize = std::size_t(1) << 16;
+
+  explicit PaletteStorage(std::size_t size, BlockId fill = blocks::kAir);
+
+  /// Restore a storage from its palette and packed indices as returned by
+  /// GetPalette and GetWords. The indices must be less than the palette
+  /// size, throws if the sizes don't match.
+  PaletteStorage(
+      std::size_t size, std::vector<BlockId> palette,
+      std::uint32_t bits, std::vector<std::uint64_t> words
+  );
+
+  [[nodiscard]] BlockId Get(std::size_t i) const noexcept {
+    if (bits_ == 0) {
+      return palette_.front();
+    }
+    auto word = words_[i >> per_word_shift_];
+    auto shift = (i & per_word_mask_) << bits_shift_;
+    return palette_[(word >> shift) & index_mask_];
+  }
+
+  void Set(std::size_t i, BlockId);
+
+  /// Set all blocks to given id, the palette is reset
+  void Fill(BlockId);
+
+  /// Replace all blocks, the palette is rebuilt with the narrowest indices
+  void Assign(std::span<const BlockId> blocks);
+
+  [[nodiscard]] std::size_t GetSize() const noexcept {
+    return size_;
+  }
+
+  [[nodiscard]] std::size_t GetPaletteSize() const noexcept {
+    return palette_.size();
+  }
+
+  [[nodiscard]] std::uint32_t GetBitsPerIndex() const noexcept {
+    return bits_;
+  }
+
+  /// The block ids of the indices
+  [[nodiscard]] std::span<const BlockId> GetPalette() const noexcept {
+    return palette_;
+  }
+
+  /// The bit-packed indices, the first index is in the low bits of a word
+  [[nodiscard]] std::span<const std::uint64_t> GetWords() const noexcept {
+    return words_;
+  }
+
+  /// Whether all blocks are the same id
+  [[nodiscard]] bool IsUniform() const noexcept {
+    return palette_.size() == 1;
+  }
+
+  /// The number of bytes used by palette and indices
+  [[nodiscard]] std::size_t GetMemoryUsage() const noexcept {
+    return palette_.capacity() * sizeof(BlockId) + words_.capacity() * sizeof(std::uint64_t);
+  }
+
+private:
+  /// Repack the indices with a wider bits
+  void Grow(std::uint32_t bits);
+
+  /// Set the index width and clear the indices
+  void ResetIndices(std::uint32_t bits);
+
+  /// Set the index width, the indices are left as they are
+  void SetBitsPerIndex(std::uint32_t bits) noexcept;
+
+  void SetIndex(std::size_t i, std::uint64_t index) noexcept {
+    auto &word = words_[i >> per_word_shift_];
+    auto shift = (i & per_word_mask_) << bits_shift_;
+    word = (word & ~(index_mask_ << shift)) | (index << shift);
+  }
+
+  std::vector<BlockId> palette_;
+  std::vector<std::uint64_t> words_;
+  std::size_t size_;
+
+  std::uint32_t bits_;
+  /// log2(bits_)
+  std::uint32_t bits_shift_;
+  /// log2(64 / bits_)
+  std::uint32_t per_word_shift_;
+  std::uint64_t per_word_mask_;
+  std::uint64_t index_mask_;
+};
+
+#endif // VKMC_CHUNK_PALETTE_H_
@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <functional>
+
+#include "pool.h"
+
+ChunkPool::ChunkPool(std::size_t capacity)
+    : capacity_(0), in_use_(0), high_water_(0), hits_(0), misses_(0) {
+  Reserve(capacity);
+}
+
+void ChunkPool::Reserve(std::size_t capacity) {
+  std::lock_guard lock(mutex_);
+  if (capacity <= capacity_) {
+    return;
+  }
+  auto size = capacity - capacity_;
+  auto &slab = slabs_.emplace_back(Slab{std::make_unique<Chunk[]>(size), size});
+  free_.reserve(capacity);
+  for (std::size_t i = size; i != 0; --i) {
+    free_.push_back(&slab.chunks[i - 1]);
+  }
+  capacity_ = capacity;
+}
+
+ChunkPool::Handle ChunkPool::Acquire() {
+  Chunk *chunk = nullptr;
+  {
+    std::lock_guard lock(mutex_);
+    high_water_ = std::max(high_water_, ++in_use_);
+    if (!free_.empty()) {
+      chunk = free_.back();
+      free_.pop_back();
+      ++hits_;
+    } else {
+      ++misses_;
+    }
+  }
+  if (chunk == nullptr) {
+    chunk = new Chunk;
+  }
+  return Handle(chunk, Deleter{this});
+}
+
+ChunkPool::Stats ChunkPool::GetStats() const {
+  std::lock_guard lock(mutex_);
+  return {
+      .hits = hits_,
+      .misses = misses_,
+      .in_use = in_use_,
+      .high_water = high_water_,
+      .capacity = capacity_,
+  };
+}
+
+void ChunkPool::Release(Chunk *chunk) noexcept {
+  std::unique_lock lock(mutex_);
+  --in_use_;
+  auto pooled = std::ranges::any_of(slabs_, [chunk](const Slab &slab) {
+    return std::less_equal<>{}(slab.chunks.get(), chunk) && std::less<>{}(chunk, slab.chunks.get() + slab.size);
+  });
+  if (pooled) {
+    free_.push_back(chunk);
+    return;
+  }
+  lock.unlock();
+  delete chunk;
+}
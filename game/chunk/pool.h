@@ -0,0 +1,74 @@
+#pragma once
+#ifndef VKMC_CHUNK_POOL_H_
+#define VKMC_CHUNK_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <common/classes.h>
+
+#include "chunk.h"
+
+/// Recycles chunks so loading and unloading don't allocate. Chunks live in
+/// slabs allocated when the capacity grows, released ones go to a free
+/// list. An empty pool allocates the chunk from the heap and counts a
+/// miss. A released chunk keeps its section storages, which generating
+/// or copying into it reuses, decoding a saved chunk replaces them. Safe
+/// to use from several threads.
+class ChunkPool : NonCopyMove {
+public:
+  struct Stats {
+    /// Chunks taken from the free list
+    std::uint64_t hits;
+    /// Chunks allocated from the heap because the pool was empty
+    std::uint64_t misses;
+    std::size_t in_use;
+    /// The most chunks in use at the same time
+    std::size_t high_water;
+    std::size_t capacity;
+  };
+
+  /// Returns the chunk to its pool
+  struct Deleter {
+    ChunkPool *pool;
+
+    void operator()(Chunk *chunk) const noexcept {
+      pool->Release(chunk);
+    }
+  };
+
+  using Handle = std::unique_ptr<Chunk, Deleter>;
+
+  explicit ChunkPool(std::size_t capacity = 0);
+
+  /// Grow the pool to at least capacity chunks, it never shrinks
+  void Reserve(std::size_t capacity);
+
+  /// Take a chunk, the blocks are left from its last use and every
+  /// section has to be filled
+  [[nodiscard]] Handle Acquire();
+
+  [[nodiscard]] Stats GetStats() const;
+
+private:
+  void Release(Chunk *) noexcept;
+
+  struct Slab {
+    std::unique_ptr<Chunk[]> chunks;
+    std::size_t size;
+  };
+
+  mutable std::mutex mutex_;
+  std::vector<Slab> slabs_;
+  std::vector<Chunk *> free_;
+  std::size_t capacity_;
+  std::size_t in_use_;
+  std::size_t high_water_;
+  std::uint64_t hits_;
+  std::uint64_t misses_;
+};
+
+#endif // VKMC_CHUNK_POOL_H_
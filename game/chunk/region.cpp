@@ -0,0 +1,294 @@
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "codec.h"
+#include "region.h"
+
+static_assert(std::endian::native == std::endian::little, "Region files are little endian");
+
+RegionFile::RegionFile(const std::filesystem::path &path)
+    : path_(path), file_size_(0), end_(0), map_(nullptr), map_size_(0) {
+#ifndef _WIN32
+  fd_ = -1;
+#endif
+  auto created = !std::filesystem::exists(path);
+  if (created) {
+    std::ofstream out(path, std::ios::binary);
+    Header header{};
+    std::memcpy(header.magic, Header::kMagic, sizeof(header.magic));
+    header.version = Header::kVersion;
+    table_ = {};
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(table_.data()), sizeof(table_));
+    if (!out) {
+      throw std::runtime_error("Could not create the region file " + path.string() + "!");
+    }
+  }
+
+  file_.open(path, std::ios::binary | std::ios::in | std::ios::out);
+  Header header{};
+  file_.read(reinterpret_cast<char *>(&header), sizeof(header));
+  file_.read(reinterpret_cast<char *>(table_.data()), sizeof(table_));
+  if (!file_ || std::memcmp(header.magic, Header::kMagic, sizeof(header.magic)) != 0 ||
+      header.version != Header::kVersion) {
+    throw std::runtime_error("Could not open the region file " + path.string() + "!");
+  }
+  file_size_ = std::filesystem::file_size(path);
+  BuildFreeList();
+  Map();
+
+  if (created) {
+    SyncFile();
+#ifndef _WIN32
+    // The chunks of the file are lost after a crash without its name
+    auto directory = path.parent_path().empty() ? std::filesystem::path(".") : path.parent_path();
+    if (auto fd = open(directory.c_str(), O_RDONLY); fd != -1) {
+      fsync(fd);
+      close(fd);
+    }
+#endif
+  }
+}
+
+RegionFile::~RegionFile() {
+  try {
+    Sync();
+  } catch (std::exception &) {
+    // The table on the disk still points at the old copies
+  }
+  Unmap();
+#ifndef _WIN32
+  if (fd_ != -1) {
+    close(fd_);
+  }
+#endif
+}
+
+bool RegionFile::Load(ChunkId id, Chunk &chunk) const {
+  std::shared_lock lock(mutex_);
+  auto &entry = table_[GetIndex(id)];
+  if (entry.offset == 0) {
+    return false;
+  }
+  if (entry.offset + entry.size > file_size_) {
+    throw std::runtime_error("The region file " + path_.string() + " is truncated!");
+  }
+  DecodeChunk({map_ + entry.offset, entry.size}, chunk);
+  return true;
+}
+
+void RegionFile::Write(ChunkId id, std::span<const std::uint8_t> data) {
+  auto index = GetIndex(id);
+  auto capacity = GetCapacity(data.size());
+  auto offset = Allocate(capacity);
+  file_.seekp(std::streamoff(offset));
+  file_.write(reinterpret_cast<const char *>(data.data()), std::streamsize(data.size()));
+  file_.flush();
+  if (!file_) {
+    Free(offset, capacity);
+    throw std::runtime_error("Failed to write the region file " + path_.string() + "!");
+  }
+
+  std::lock_guard lock(mutex_);
+  auto &entry = table_[index];
+  if (entry.offset != 0) {
+    // A copy written since the last sync is not in the table on the disk
+    if (unsynced_[index]) {
+      Free(entry.offset, entry.capacity);
+    } else {
+      released_.emplace_back(entry.offset, entry.capacity);
+    }
+  }
+  entry = {.offset = offset, .size = std::uint32_t(data.size()), .capacity = std::uint32_t(capacity)};
+  unsynced_.set(index);
+
+  file_size_ = std::max(file_size_, offset + data.size());
+#ifdef _WIN32
+  // The copy doesn't see the writes to the file
+  copy_.resize(file_size_);
+  std::memcpy(copy_.data() + offset, data.data(), data.size());
+  map_ = copy_.data();
+  map_size_ = copy_.size();
+#else
+  if (file_size_ > map_size_) {
+    Map();
+  }
+#endif
+}
+
+void RegionFile::Sync() {
+  // Only the writing thread changes the table, the lock isn't needed to
+  // read it here
+  if (unsynced_.none()) {
+    return;
+  }
+
+  // The chunks go to the disk first, the table there never points at
+  // missing ones
+  SyncFile();
+  for (std::size_t index = 0; index != kChunks; ++index) {
+    if (unsynced_[index]) {
+      file_.seekp(std::streamoff(sizeof(Header) + index * sizeof(Entry)));
+      file_.write(reinterpret_cast<const char *>(&table_[index]), sizeof(Entry));
+    }
+  }
+  SyncFile();
+
+  unsynced_.reset();
+  for (auto [offset, capacity] : released_) {
+    Free(offset, capacity);
+  }
+  released_.clear();
+}
+
+void RegionFile::BuildFreeList() {
+  constexpr std::uint64_t kDataStart = sizeof(Header) + sizeof(Entry) * kChunks;
+  auto damaged = [this] {
+    return std::runtime_error("The table of the region file " + path_.string() + " is damaged!");
+  };
+  std::vector<std::pair<std::uint64_t, std::uint64_t>> used;
+  for (auto &entry : table_) {
+    if (entry.offset == 0) {
+      continue;
+    }
+    // The space after the last chunk may pass the end of the file, the
+    // chunk itself may not
+    if (entry.offset < kDataStart || entry.capacity < entry.size || entry.offset + entry.size > file_size_) {
+      throw damaged();
+    }
+    used.emplace_back(entry.offset, entry.capacity);
+  }
+  std::ranges::sort(used);
+
+  free_.clear();
+  auto cursor = kDataStart;
+  for (auto [offset, capacity] : used) {
+    if (offset < cursor) {
+      throw damaged();
+    }
+    if (offset > cursor) {
+      free_.emplace(cursor, offset - cursor);
+    }
+    cursor = offset + capacity;
+  }
+  end_ = (cursor + kSectorSize - 1) / kSectorSize * kSectorSize;
+}
+
+std::uint64_t RegionFile::Allocate(std::uint64_t capacity) {
+  for (auto it = free_.begin(); it != free_.end(); ++it) {
+    auto [offset, size] = *it;
+    if (size < capacity) {
+      continue;
+    }
+    free_.erase(it);
+    if (size != capacity) {
+      free_.emplace(offset + capacity, size - capacity);
+    }
+    return offset;
+  }
+
+  auto offset = end_;
+  end_ += capacity;
+  return offset;
+}
+
+void RegionFile::Free(std::uint64_t offset, std::uint64_t capacity) {
+  // Merge with the adjacent free ranges
+  auto next = free_.lower_bound(offset);
+  if (next != free_.end() && offset + capacity == next->first) {
+    capacity += next->second;
+    next = free_.erase(next);
+  }
+  if (next != free_.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == offset) {
+      offset = prev->first;
+      capacity += prev->second;
+      free_.erase(prev);
+    }
+  }
+
+  if (offset + capacity == end_) {
+    end_ = offset;
+  } else {
+    free_.emplace(offset, capacity);
+  }
+}
+
+void RegionFile::SyncFile() {
+  file_.flush();
+  if (!file_) {
+    throw std::runtime_error("Failed to write the region file " + path_.string() + "!");
+  }
+#ifdef _WIN32
+  // The stream has no descriptor, commit the file through another one
+  auto fd = _wopen(path_.c_str(), _O_RDWR | _O_BINARY);
+  auto failed = fd == -1 || _commit(fd) != 0;
+  if (fd != -1) {
+    _close(fd);
+  }
+#else
+  auto failed = fsync(fd_) != 0;
+#endif
+  if (failed) {
+    throw std::runtime_error("Failed to sync the region file " + path_.string() + "!");
+  }
+}
+
+#ifdef _WIN32
+
+void RegionFile::Map() {
+  copy_.resize(file_size_);
+  std::ifstream in(path_, std::ios::binary);
+  in.read(reinterpret_cast<char *>(copy_.data()), std::streamsize(copy_.size()));
+  map_ = copy_.data();
+  map_size_ = copy_.size();
+}
+
+void RegionFile::Unmap() noexcept {
+  map_ = nullptr;
+  map_size_ = 0;
+}
+
+#else
+
+void RegionFile::Map() {
+  auto size = std::max<std::size_t>(file_size_, map_size_ * 2);
+  Unmap();
+  if (fd_ == -1) {
+    // Also syncs the writes of the stream
+    fd_ = open(path_.c_str(), O_RDWR);
+    if (fd_ == -1) {
+      throw std::runtime_error("Could not map the region file " + path_.string() + "!");
+    }
+  }
+  auto map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd_, 0);
+  if (map == MAP_FAILED) {
+    throw std::runtime_error("Could not map the region file " + path_.string() + "!");
+  }
+  map_ = static_cast<const std::uint8_t *>(map);
+  map_size_ = size;
+}
+
+void RegionFile::Unmap() noexcept {
+  if (map_ != nullptr) {
+    munmap(const_cast<std::uint8_t *>(map_), map_size_);
+    map_ = nullptr;
+    map_size_ = 0;
+  }
+}
+
+#endif
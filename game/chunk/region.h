@@ -0,0 +1,130 @@
+#pragma once
+#ifndef VKMC_CHUNK_REGION_H_
+#define VKMC_CHUNK_REGION_H_
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <shared_mutex>
+#include <span>
+#include <vector>
+
+#include <common/classes.h>
+
+#include "chunk.h"
+
+/// A file of 32 x 32 chunks: a header, a table of the offset and size of
+/// each encoded chunk, and the chunks. Loads decode straight from a shared
+/// memory map of the file.
+///
+/// A write never overwrites the stored copy of a chunk. The new copy goes
+/// to free sectors and the table on the disk points at it after Sync, so a
+/// crash leaves one of the copies whole. The space of the old copy is
+/// reused from then on.
+class RegionFile : NonCopyMove {
+public:
+  static constexpr std::int32_t kLengthPow = 5;
+  static constexpr std::int32_t kLength = 1 << kLengthPow;
+  static constexpr std::size_t kChunks = kLength * kLength;
+  /// The unit of the space given to a chunk
+  static constexpr std::uint64_t kSectorSize = 4096;
+
+  [[nodiscard]] static constexpr ChunkId GetRegionId(ChunkId id) noexcept {
+    return {id.x >> kLengthPow, id.y >> kLengthPow};
+  }
+
+  /// Open the region file, it is created if missing. Throws if the file
+  /// can't be opened, is not a region file or its table is damaged.
+  explicit RegionFile(const std::filesystem::path &path);
+
+  ~RegionFile();
+
+  /// Decode the stored chunk, returns false if the chunk was never
+  /// written. Safe to call on any thread.
+  bool Load(ChunkId, Chunk &) const;
+
+  /// Store an encoded chunk, loads see it at once and the disk after Sync.
+  /// Writes and syncs must not run on several threads at the same time.
+  void Write(ChunkId, std::span<const std::uint8_t> data);
+
+  /// Wait until the written chunks are on the disk, then point the table
+  /// on the disk at them. Loads don't wait for it.
+  void Sync();
+
+private:
+  struct Entry {
+    /// 0 if the chunk is not stored
+    std::uint64_t offset;
+    std::uint32_t size;
+    /// The bytes given to the chunk at offset
+    std::uint32_t capacity;
+  };
+
+  struct Header {
+    static constexpr char kMagic[8] = {'V', 'K', 'M', 'C', 'R', 'G', 'N', 'F'};
+    static constexpr std::uint32_t kVersion = 1;
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+  };
+
+  [[nodiscard]] static std::size_t GetIndex(ChunkId id) noexcept {
+    return std::size_t(id.y & (kLength - 1)) * kLength + std::size_t(id.x & (kLength - 1));
+  }
+
+  /// The space to give to an encoded chunk, in whole sectors
+  [[nodiscard]] static std::uint64_t GetCapacity(std::size_t size) noexcept {
+    return (size + kSectorSize - 1) / kSectorSize * kSectorSize;
+  }
+
+  /// Find the free space of the file from the table, throws if an entry
+  /// is in the header or the table, leaves the file or overlaps another
+  void BuildFreeList();
+
+  /// The lowest free range fitting the capacity, or the end of the file
+  [[nodiscard]] std::uint64_t Allocate(std::uint64_t capacity);
+
+  void Free(std::uint64_t offset, std::uint64_t capacity);
+
+  /// Flush the stream and wait until the file is on the disk
+  void SyncFile();
+
+  /// Map the file again after it grew past the map. The map is grown
+  /// geometrically and may extend past the end of the file, that part is
+  /// never read.
+  void Map();
+
+  void Unmap() noexcept;
+
+  std::filesystem::path path_;
+  std::fstream file_;
+  std::uint64_t file_size_;
+  std::array<Entry, kChunks> table_;
+  /// offset -> size of the unused space before end_
+  std::map<std::uint64_t, std::uint64_t> free_;
+  /// The end of the space given to chunks, a multiple of kSectorSize
+  std::uint64_t end_;
+  /// The entries written since the last sync
+  std::bitset<kChunks> unsynced_;
+  /// The old copies the table on the disk may still point at, freed after
+  /// the next sync
+  std::vector<std::pair<std::uint64_t, std::uint64_t>> released_;
+
+  /// Loads share the lock, writes and remapping own it
+  mutable std::shared_mutex mutex_;
+  const std::uint8_t *map_;
+  std::size_t map_size_;
+#ifdef _WIN32
+  /// Without mmap the file is read into memory instead
+  std::vector<std::uint8_t> copy_;
+#else
+  int fd_;
+#endif
+};
+
+#endif // VKMC_CHUNK_REGION_H_
@@ -0,0 +1,115 @@
+#pragma once
+#ifndef VKMC_CHUNK_SECTION_H_
+#define VKMC_CHUNK_SECTION_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "../block/types.h"
+#include "palette.h"
+
+/// A cube of blocks in a chunk column. A section whose blocks are all the
+/// same id is stored as a single tag, the block storage is allocated on
+/// the first different block. A filled section keeps its storage with one
+/// block, so a recycled chunk doesn't allocate it again.
+class ChunkSection {
+public:
+  static constexpr std::size_t kLengthPow = 5; // 2^5 = 32
+  static constexpr std::size_t kLength = 1 << kLengthPow;
+  static constexpr std::size_t kVolume = kLength * kLength * kLength;
+
+  ChunkSection() noexcept : uniform_(blocks::kAir) {}
+
+  ChunkSection(const ChunkSection &other)
+      : blocks_(other.IsUniform() ? nullptr : std::make_unique<PaletteStorage>(*other.blocks_)),
+        uniform_(other.uniform_) {}
+
+  ChunkSection &operator=(const ChunkSection &other) {
+    if (other.IsUniform()) {
+      Fill(other.uniform_);
+    } else if (blocks_ == nullptr) {
+      blocks_ = std::make_unique<PaletteStorage>(*other.blocks_);
+    } else {
+      *blocks_ = *other.blocks_;
+    }
+    uniform_ = other.uniform_;
+    return *this;
+  }
+
+  [[nodiscard]] BlockId operator()(int x, int y, int z) const noexcept {
+    return blocks_ ? blocks_->Get(GetIndex(x, y, z)) : uniform_;
+  }
+
+  void Set(int x, int y, int z, BlockId block) {
+    if (blocks_ == nullptr) {
+      if (block == uniform_) {
+        return;
+      }
+      blocks_ = std::make_unique<PaletteStorage>(kVolume, uniform_);
+    }
+    blocks_->Set(GetIndex(x, y, z), block);
+  }
+
+  /// Set all blocks to given id, the block storage is kept for the next
+  /// different block
+  void Fill(BlockId block) {
+    if (blocks_ != nullptr) {
+      blocks_->Fill(block);
+    }
+    uniform_ = block;
+  }
+
+  /// Replace all kVolume blocks, indexed as GetIndex. A section of one
+  /// block id is stored as a tag.
+  void Assign(const BlockId *blocks) {
+    auto first = blocks[0];
+    if (std::all_of(blocks, blocks + kVolume, [first](BlockId block) { return block == first; })) {
+      Fill(first);
+      return;
+    }
+    if (blocks_ == nullptr) {
+      blocks_ = std::make_unique<PaletteStorage>(kVolume, uniform_);
+    }
+    blocks_->Assign({blocks, kVolume});
+  }
+
+  /// Replace the block storage, its size must be kVolume
+  void Assign(std::unique_ptr<PaletteStorage> storage) noexcept {
+    if (storage->IsUniform()) {
+      uniform_ = storage->GetPalette().front();
+    }
+    blocks_ = std::move(storage);
+  }
+
+  /// Whether the section was filled with one block id, either without a
+  /// storage or with a kept storage of one block
+  [[nodiscard]] bool IsUniform() const noexcept {
+    return blocks_ == nullptr || blocks_->IsUniform();
+  }
+
+  /// The block id of a uniform section, a kept storage holds the same
+  [[nodiscard]] BlockId GetUniformBlock() const noexcept {
+    return uniform_;
+  }
+
+  /// The block storage, nullptr if the section never had a different
+  /// block. A uniform section may keep one.
+  [[nodiscard]] const PaletteStorage *GetStorage() const noexcept {
+    return blocks_.get();
+  }
+
+  [[nodiscard]] static constexpr std::uint32_t GetIndex(int x, int y, int z) noexcept {
+    // index is [y][x][z]
+    constexpr auto k = kLengthPow;
+    return (std::uint32_t(y) << (k * 2)) | (std::uint32_t(x) << k) | std::uint32_t(z);
+  }
+
+private:
+  std::unique_ptr<PaletteStorage> blocks_;
+  BlockId uniform_;
+};
+
+#endif // VKMC_CHUNK_SECTION_H_
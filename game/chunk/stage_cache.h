@@ -0,0 +1,58 @@
+#pragma once
+#ifndef VKMC_CHUNK_STAGE_CACHE_H_
+#define VKMC_CHUNK_STAGE_CACHE_H_
+
+#include <concepts>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "chunk.h"
+
+/// The outputs of a generator stage by chunk, shared by the neighbours
+/// which read their border samples. It is safe to use from several
+/// threads. The oldest entry is evicted when the cache is full.
+template <class T>
+class StageCache {
+public:
+  explicit StageCache(std::size_t capacity) noexcept : capacity_(capacity) {}
+
+  /// Get the output of the chunk, make is called outside the lock on a
+  /// miss. Returns the output and whether it was cached.
+  template <std::invocable<> Make>
+  std::pair<std::shared_ptr<const T>, bool> GetOrMake(ChunkId id, Make &&make) {
+    {
+      std::lock_guard lock(mutex_);
+      auto it = entries_.find(id);
+      if (it != entries_.end()) {
+        return {it->second, true};
+      }
+    }
+
+    // Another thread may make the same output meanwhile, both are equal
+    auto value = std::make_shared<const T>(make());
+    std::lock_guard lock(mutex_);
+    auto [it, add] = entries_.try_emplace(id, std::move(value));
+    std::pair<std::shared_ptr<const T>, bool> result{it->second, false};
+    if (add) {
+      order_.push_back(id);
+      if (order_.size() > capacity_) {
+        entries_.erase(order_.front());
+        order_.pop_front();
+      }
+    }
+    return result;
+  }
+
+private:
+  std::size_t capacity_;
+  std::mutex mutex_;
+  std::unordered_map<ChunkId, std::shared_ptr<const T>, ChunkIdHash> entries_;
+  /// Chunks in insertion order
+  std::deque<ChunkId> order_;
+};
+
+#endif // VKMC_CHUNK_STAGE_CACHE_H_
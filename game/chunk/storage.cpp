@@ -0,0 +1,225 @@
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "codec.h"
+#include "storage.h"
+
+static std::filesystem::path MakeDirectory(std::filesystem::path directory) {
+  std::filesystem::create_directories(directory);
+  return directory;
+}
+
+ChunkStorage::ChunkStorage(std::filesystem::path directory)
+    : directory_(MakeDirectory(std::move(directory))),
+      journal_(directory_ / "journal.log"),
+      journal_size_(journal_.GetSize()),
+      checkpoint_pending_(false),
+      recovered_(journal_.GetRecovered()),
+      checkpoint_edits_(0),
+      syncing_(false),
+      checkpoint_(false),
+      stop_(false) {
+  thread_ = std::thread(&ChunkStorage::Run, this);
+}
+
+ChunkStorage::~ChunkStorage() {
+  {
+    std::lock_guard lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_one();
+  thread_.join();
+}
+
+void ChunkStorage::Save(ChunkId id, std::shared_ptr<const Chunk> chunk) {
+  {
+    std::lock_guard lock(mutex_);
+    auto &queued = queued_[id];
+    queued.chunk = std::move(chunk);
+    if (queued.in_order) {
+      return;
+    }
+    queued.in_order = true;
+    order_.push_back(id);
+  }
+  wake_.notify_one();
+}
+
+bool ChunkStorage::Load(ChunkId id, Chunk &chunk) {
+  std::shared_ptr<const Chunk> queued;
+  {
+    std::lock_guard lock(mutex_);
+    auto it = queued_.find(id);
+    if (it != queued_.end()) {
+      queued = it->second.chunk;
+    }
+  }
+  if (queued) {
+    chunk = *queued;
+    return true;
+  }
+
+  auto region = GetRegion(RegionFile::GetRegionId(id), false);
+  return region && region->Load(id, chunk);
+}
+
+void ChunkStorage::Flush() {
+  std::unique_lock lock(mutex_);
+  idle_.wait(lock, [this] { return IsIdle(); });
+}
+
+void ChunkStorage::Record(const BlockEdit &edit) {
+  {
+    std::lock_guard lock(mutex_);
+    edits_.emplace_back(edit);
+  }
+  wake_.notify_one();
+}
+
+std::vector<BlockEdit> ChunkStorage::TakeRecoveredEdits() {
+  return std::move(recovered_);
+}
+
+void ChunkStorage::Checkpoint() {
+  RequestCheckpoint();
+  std::unique_lock lock(mutex_);
+  idle_.wait(lock, [this] { return !checkpoint_; });
+}
+
+void ChunkStorage::RequestCheckpoint() {
+  {
+    std::lock_guard lock(mutex_);
+    if (checkpoint_) {
+      // The edits since the pending request are kept in the journal too
+      return;
+    }
+    checkpoint_ = true;
+    checkpoint_edits_ = edits_.size();
+    checkpoint_pending_.store(true, std::memory_order_relaxed);
+  }
+  wake_.notify_one();
+}
+
+RegionFile *ChunkStorage::GetRegion(ChunkId region, bool create) {
+  std::lock_guard lock(regions_mutex_);
+  auto it = regions_.find(region);
+  if (it != regions_.end()) {
+    return it->second.get();
+  }
+
+  auto path = directory_ / ("r." + std::to_string(region.x) + "." + std::to_string(region.y) + ".vkr");
+  if (!create && !std::filesystem::exists(path)) {
+    return nullptr;
+  }
+  return regions_.emplace(region, std::make_unique<RegionFile>(path)).first->second.get();
+}
+
+void ChunkStorage::SyncRegions() {
+  // Loads may open more regions meanwhile, those have nothing to sync
+  std::vector<RegionFile *> regions;
+  {
+    std::lock_guard lock(regions_mutex_);
+    for (auto &[id, region] : regions_) {
+      regions.emplace_back(region.get());
+    }
+  }
+  for (auto region : regions) {
+    region->Sync();
+  }
+}
+
+void ChunkStorage::Run() {
+  std::vector<std::uint8_t> data;
+  std::vector<BlockEdit> edits;
+  std::unique_lock lock(mutex_);
+  while (true) {
+    wake_.wait(lock, [this] { return stop_ || !order_.empty() || HasEditsToAppend() || checkpoint_; });
+
+    // Edits go first, a saved chunk never has edits missing in the journal
+    if (HasEditsToAppend()) {
+      if (checkpoint_) {
+        edits.assign(edits_.begin(), edits_.begin() + std::ptrdiff_t(checkpoint_edits_));
+        edits_.erase(edits_.begin(), edits_.begin() + std::ptrdiff_t(checkpoint_edits_));
+        checkpoint_edits_ = 0;
+      } else {
+        edits.swap(edits_);
+      }
+      syncing_ = true;
+      lock.unlock();
+      try {
+        journal_.Append(edits);
+        journal_size_.store(journal_.GetSize(), std::memory_order_relaxed);
+      } catch (std::exception &e) {
+        std::cerr << "Failed to log " << edits.size() << " edits: " << e.what() << '\n';
+      }
+      edits.clear();
+      lock.lock();
+      syncing_ = false;
+      if (IsIdle()) {
+        idle_.notify_all();
+      }
+      continue;
+    }
+
+    if (order_.empty()) {
+      if (checkpoint_) {
+        // The chunks saved before the request are written, the edits since
+        // wait in edits_ for the emptied journal
+        syncing_ = true;
+        lock.unlock();
+        try {
+          SyncRegions();
+          journal_.Clear();
+          journal_size_.store(0, std::memory_order_relaxed);
+        } catch (std::exception &e) {
+          // The journal is kept, the next checkpoint tries again
+          std::cerr << "Failed to checkpoint: " << e.what() << '\n';
+        }
+        lock.lock();
+        syncing_ = false;
+        checkpoint_ = false;
+        checkpoint_pending_.store(false, std::memory_order_relaxed);
+        idle_.notify_all();
+        continue;
+      }
+
+      // Stopped and everything was written
+      lock.unlock();
+      try {
+        SyncRegions();
+      } catch (std::exception &e) {
+        std::cerr << "Failed to sync the regions: " << e.what() << '\n';
+      }
+      return;
+    }
+
+    auto id = order_.front();
+    order_.pop_front();
+    auto &queued = queued_[id];
+    queued.in_order = false;
+    auto chunk = queued.chunk;
+    lock.unlock();
+
+    try {
+      data.clear();
+      EncodeChunk(*chunk, data);
+      GetRegion(RegionFile::GetRegionId(id), true)->Write(id, data);
+    } catch (std::exception &e) {
+      std::cerr << "Failed to save chunk (" << id.x << ", " << id.y << "): " << e.what() << '\n';
+    }
+
+    // The chunk may go back to a pool which is destroyed once idle
+    chunk.reset();
+    lock.lock();
+    // Keep the chunk visible to loads if it was saved again meanwhile
+    auto it = queued_.find(id);
+    if (!it->second.in_order) {
+      queued_.erase(it);
+      if (IsIdle()) {
+        idle_.notify_all();
+      }
+    }
+  }
+}
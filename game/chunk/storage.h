@@ -0,0 +1,127 @@
+#pragma once
+#ifndef VKMC_CHUNK_STORAGE_H_
+#define VKMC_CHUNK_STORAGE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <common/classes.h>
+
+#include "chunk.h"
+#include "journal.h"
+#include "region.h"
+
+/// Saves chunks into the region files of a directory. Saving only queues
+/// the chunk, a writer thread encodes and writes it. Loads see the queued
+/// chunks, so a chunk can be loaded again before it reaches the disk.
+///
+/// Block edits are logged in a journal before any chunk is written, the
+/// writer syncs all edits recorded meanwhile at once. After a crash the
+/// edits of the journal are replayed over the saved chunks. A checkpoint
+/// syncs the region files and only then empties the journal, it runs on
+/// the writer too.
+class ChunkStorage : NonCopyMove {
+public:
+  /// Use the region files in the directory, it is created if missing
+  explicit ChunkStorage(std::filesystem::path directory);
+
+  /// Write all queued chunks before returning
+  ~ChunkStorage();
+
+  /// Queue the chunk to be written, a chunk queued again before it was
+  /// written is only written once
+  void Save(ChunkId, std::shared_ptr<const Chunk>);
+
+  /// Replace the blocks of the chunk with the saved ones, returns false if
+  /// the chunk was never saved. Safe to call on any thread.
+  bool Load(ChunkId, Chunk &);
+
+  /// Block until all queued chunks and edits were written
+  void Flush();
+
+  /// Queue the edit to the journal
+  void Record(const BlockEdit &);
+
+  /// The edits left in the journal by the last run, which may not be in
+  /// the saved chunks. They are only returned once.
+  [[nodiscard]] std::vector<BlockEdit> TakeRecoveredEdits();
+
+  /// Write everything queued, sync the region files and empty the
+  /// journal, all edited chunks must have been saved. Waits for the writer.
+  void Checkpoint();
+
+  /// Like Checkpoint but returns at once. The edits recorded after the
+  /// request are kept for the emptied journal.
+  void RequestCheckpoint();
+
+  /// Whether a requested checkpoint is not done yet
+  [[nodiscard]] bool IsCheckpointPending() const noexcept {
+    return checkpoint_pending_.load(std::memory_order_relaxed);
+  }
+
+  /// The bytes in the journal
+  [[nodiscard]] std::uint64_t GetJournalSize() const noexcept {
+    return journal_size_.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct Queued {
+    std::shared_ptr<const Chunk> chunk;
+    /// Whether the chunk is in order_, false while it is being written
+    bool in_order = false;
+  };
+
+  /// Get the region file, nullptr if it doesn't exist and create is false
+  RegionFile *GetRegion(ChunkId region, bool create);
+
+  void Run();
+
+  /// Sync the chunks written to every region file, on the writer
+  void SyncRegions();
+
+  /// Whether edits wait for the writer, those recorded after a pending
+  /// checkpoint only go to the journal once it is emptied
+  [[nodiscard]] bool HasEditsToAppend() const noexcept {
+    return checkpoint_ ? checkpoint_edits_ != 0 : !edits_.empty();
+  }
+
+  [[nodiscard]] bool IsIdle() const noexcept {
+    return queued_.empty() && edits_.empty() && !syncing_ && !checkpoint_;
+  }
+
+  std::filesystem::path directory_;
+  BlockJournal journal_;
+  std::atomic<std::uint64_t> journal_size_;
+  std::atomic<bool> checkpoint_pending_;
+  std::vector<BlockEdit> recovered_;
+
+  std::mutex regions_mutex_;
+  std::unordered_map<ChunkId, std::unique_ptr<RegionFile>, ChunkIdHash> regions_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  std::unordered_map<ChunkId, Queued, ChunkIdHash> queued_;
+  std::deque<ChunkId> order_;
+  /// Edits to append to the journal
+  std::vector<BlockEdit> edits_;
+  /// The number of edits at the front of edits_ recorded before the
+  /// pending checkpoint
+  std::size_t checkpoint_edits_;
+  /// The writer is appending edits or doing a checkpoint
+  bool syncing_;
+  bool checkpoint_;
+  bool stop_;
+
+  std::thread thread_;
+};
+
+#endif // VKMC_CHUNK_STORAGE_H_
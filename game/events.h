@@ -4,8 +4,11 @@
 
 namespace events {
 
+/// Args: ChunkId, const Chunk *
 constexpr auto kChunkLoaded = "chunk_load";
+/// Args: ChunkId
 constexpr auto kChunkUnloaded = "chunk_unload";
+/// Args: ChunkId, const Chunk *, glm::ivec3 position of the block in chunk
 constexpr auto kChunkUpdate = "chunk_update";
 
 } // namespace events
@@ -0,0 +1,124 @@
+#include <algorithm>
+
+#include "worker_pool.h"
+
+/// The pool and queue index of the current thread if it is a worker
+static thread_local const WorkerPool *current_pool = nullptr;
+static thread_local std::size_t current_queue = 0;
+
+WorkerPool::WorkerPool(std::size_t workers) : queued_(0), unfinished_(0), stop_(false), next_queue_(0) {
+  if (workers == 0) {
+    auto hardware = std::thread::hardware_concurrency();
+    workers = std::max(hardware, 2u) - 1;
+  }
+
+  queues_.reserve(workers);
+  for (std::size_t i = 0; i != workers; ++i) {
+    queues_.emplace_back(std::make_unique<Queue>());
+  }
+
+  threads_.reserve(workers);
+  for (std::size_t i = 0; i != workers; ++i) {
+    threads_.emplace_back(&WorkerPool::Run, this, i);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkerPool::Submit(Job job) {
+  std::size_t index;
+  if (current_pool == this) {
+    index = current_queue;
+  } else {
+    index = next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+  }
+
+  {
+    auto &queue = *queues_[index];
+    std::lock_guard lock(queue.mutex);
+    queue.jobs.emplace_back(std::move(job));
+  }
+
+  {
+    std::lock_guard lock(mutex_);
+    ++queued_;
+    ++unfinished_;
+  }
+  wake_.notify_one();
+}
+
+void WorkerPool::Wait() {
+  std::unique_lock lock(mutex_);
+  idle_.wait(lock, [this] { return unfinished_ == 0; });
+}
+
+bool WorkerPool::Pop(std::size_t index, Job &job) {
+  auto &queue = *queues_[index];
+  std::lock_guard lock(queue.mutex);
+  if (queue.jobs.empty()) {
+    return false;
+  }
+  job = std::move(queue.jobs.front());
+  queue.jobs.pop_front();
+  return true;
+}
+
+bool WorkerPool::Steal(std::size_t index, Job &job) {
+  for (std::size_t i = 1; i != queues_.size(); ++i) {
+    auto &queue = *queues_[(index + i) % queues_.size()];
+    std::lock_guard lock(queue.mutex);
+    if (!queue.jobs.empty()) {
+      job = std::move(queue.jobs.back());
+      queue.jobs.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkerPool::Run(std::size_t index) {
+  current_pool = this;
+  current_queue = index;
+
+  Job job;
+  while (true) {
+    {
+      std::unique_lock lock(mutex_);
+      wake_.wait(lock, [this] { return stop_ || queued_ != 0; });
+      if (stop_) {
+        return;
+      }
+    }
+
+    if (!Pop(index, job) && !Steal(index, job)) {
+      // Another worker took the job between wake and pop
+      continue;
+    }
+
+    {
+      std::lock_guard lock(mutex_);
+      --queued_;
+    }
+
+    job();
+    job = nullptr;
+
+    bool idle;
+    {
+      std::lock_guard lock(mutex_);
+      idle = --unfinished_ == 0;
+    }
+    if (idle) {
+      idle_.notify_all();
+    }
+  }
+}
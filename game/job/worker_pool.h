@@ -0,0 +1,67 @@
+#pragma once
+#ifndef VKMC_JOB_WORKER_POOL_H_
+#define VKMC_JOB_WORKER_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <common/classes.h>
+
+/// A fixed number of worker threads, each owns a job queue.
+/// Idle workers steal jobs from the back of other queues.
+class WorkerPool : NonCopyMove {
+public:
+  using Job = std::function<void()>;
+
+  /// Create the pool with given number of workers, 0 means one less than
+  /// the hardware threads so the main thread keeps a core
+  explicit WorkerPool(std::size_t workers = 0);
+
+  ~WorkerPool();
+
+  /// Queue a job, it will run on one of the worker threads.
+  /// Jobs submitted from a worker go to its own queue.
+  void Submit(Job);
+
+  /// Block the current thread until all submitted jobs were done
+  void Wait();
+
+  [[nodiscard]] std::size_t GetWorkerCount() const noexcept {
+    return threads_.size();
+  }
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+  };
+
+  void Run(std::size_t index);
+
+  bool Pop(std::size_t index, Job &);
+
+  bool Steal(std::size_t index, Job &);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  /// The number of jobs in queues
+  std::size_t queued_;
+  /// The number of jobs submitted and not finished yet
+  std::size_t unfinished_;
+  bool stop_;
+
+  std::atomic<std::size_t> next_queue_;
+};
+
+#endif // VKMC_JOB_WORKER_POOL_H_
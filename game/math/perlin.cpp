@@ -1,5 +1,18 @@
+#include <cmath>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
 #include "perlin.h"
 
+#if defined(__AVX2__)
+#define VKMC_PERLIN_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VKMC_PERLIN_SSE2
+#include <emmintrin.h>
+#endif
+
 const std::array<glm::vec2, 8> kPerlinGrad{
     glm::vec2(1, 0),
     glm::vec2(-1, 0),
@@ -10,3 +23,210 @@ const std::array<glm::vec2, 8> kPerlinGrad{
     glm::normalize(glm::vec2(-1.f, 1.f)),
     glm::normalize(glm::vec2(-1.f, -1.f)),
 };
+
+/// The edges of a cube, padded to 16 so the hash is masked
+static const std::array<glm::vec3, 16> kPerlinGrad3{
+    glm::vec3(1, 1, 0), glm::vec3(-1, 1, 0), glm::vec3(1, -1, 0), glm::vec3(-1, -1, 0),
+    glm::vec3(1, 0, 1), glm::vec3(-1, 0, 1), glm::vec3(1, 0, -1), glm::vec3(-1, 0, -1),
+    glm::vec3(0, 1, 1), glm::vec3(0, -1, 1), glm::vec3(0, 1, -1), glm::vec3(0, -1, -1),
+    glm::vec3(1, 1, 0), glm::vec3(0, -1, 1), glm::vec3(-1, 1, 0), glm::vec3(0, -1, -1),
+};
+
+// The vector paths repeat the scalar operations in the same order, this
+// file is built without floating point contraction so neither path fuses
+// a multiply and an add.
+
+namespace {
+
+/// The gradient index of the lattice point (x, y)
+std::uint32_t Hash(const std::uint16_t *permu, std::uint32_t mask, std::int32_t x, std::int32_t y) noexcept {
+  return permu[permu[x & mask] + (y & mask)] & (kPerlinGrad.size() - 1);
+}
+
+float Grad(std::uint32_t hash, float x, float y) noexcept {
+  auto &g = kPerlinGrad[hash];
+  return g.x * x + g.y * y;
+}
+
+float Fade(float t) noexcept {
+  return t * t * t * (t * (t * 6 - 15) + 10);
+}
+
+float Lerp(float a, float b, float t) noexcept {
+  return (1 - t) * a + t * b;
+}
+
+#ifdef VKMC_PERLIN_AVX2
+
+__m256 Fade(__m256 t) noexcept {
+  auto t3 = _mm256_mul_ps(_mm256_mul_ps(t, t), t);
+  auto inner = _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6)), _mm256_set1_ps(15));
+  return _mm256_mul_ps(t3, _mm256_add_ps(_mm256_mul_ps(t, inner), _mm256_set1_ps(10)));
+}
+
+__m256 Lerp(__m256 a, __m256 b, __m256 t) noexcept {
+  return _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(1), t), a), _mm256_mul_ps(t, b));
+}
+
+/// Look up 8 entries of the 16 bit permutation table, reading 32 bits
+/// stays in the table since the index is at most 2 * mask
+__m256i Permute(const std::uint16_t *permu, __m256i index) noexcept {
+  auto words = _mm256_i32gather_epi32(reinterpret_cast<const int *>(permu), index, 2);
+  return _mm256_and_si256(words, _mm256_set1_epi32(0xffff));
+}
+
+void SampleAVX2(const std::uint16_t *permu, std::uint32_t mask, const float *x, const float *y, float *dst) noexcept {
+  auto grad_x = _mm256_setr_ps(
+      kPerlinGrad[0].x, kPerlinGrad[1].x, kPerlinGrad[2].x, kPerlinGrad[3].x,
+      kPerlinGrad[4].x, kPerlinGrad[5].x, kPerlinGrad[6].x, kPerlinGrad[7].x
+  );
+  auto grad_y = _mm256_setr_ps(
+      kPerlinGrad[0].y, kPerlinGrad[1].y, kPerlinGrad[2].y, kPerlinGrad[3].y,
+      kPerlinGrad[4].y, kPerlinGrad[5].y, kPerlinGrad[6].y, kPerlinGrad[7].y
+  );
+  auto masks = _mm256_set1_epi32(std::int32_t(mask));
+  auto one = _mm256_set1_ps(1);
+
+  auto px = _mm256_loadu_ps(x), py = _mm256_loadu_ps(y);
+  auto floor_x = _mm256_floor_ps(px), floor_y = _mm256_floor_ps(py);
+  auto fx = _mm256_sub_ps(px, floor_x), fy = _mm256_sub_ps(py, floor_y);
+  auto ix = _mm256_cvttps_epi32(floor_x), iy = _mm256_cvttps_epi32(floor_y);
+
+  auto x0 = _mm256_and_si256(ix, masks);
+  auto x1 = _mm256_and_si256(_mm256_add_epi32(ix, _mm256_set1_epi32(1)), masks);
+  auto y0 = _mm256_and_si256(iy, masks);
+  auto y1 = _mm256_and_si256(_mm256_add_epi32(iy, _mm256_set1_epi32(1)), masks);
+  auto p0 = Permute(permu, x0), p1 = Permute(permu, x1);
+
+  auto grad = [&](__m256i px, __m256i y, __m256 tx, __m256 ty) {
+    auto hash = _mm256_and_si256(Permute(permu, _mm256_add_epi32(px, y)), _mm256_set1_epi32(7));
+    auto gx = _mm256_permutevar8x32_ps(grad_x, hash);
+    auto gy = _mm256_permutevar8x32_ps(grad_y, hash);
+    return _mm256_add_ps(_mm256_mul_ps(gx, tx), _mm256_mul_ps(gy, ty));
+  };
+  auto fx1 = _mm256_sub_ps(fx, one), fy1 = _mm256_sub_ps(fy, one);
+  auto g00 = grad(p0, y0, fx, fy);
+  auto g10 = grad(p1, y0, fx1, fy);
+  auto g01 = grad(p0, y1, fx, fy1);
+  auto g11 = grad(p1, y1, fx1, fy1);
+
+  auto u = Fade(fx), v = Fade(fy);
+  _mm256_storeu_ps(dst, Lerp(Lerp(g00, g10, u), Lerp(g01, g11, u), v));
+}
+
+#endif
+
+#ifdef VKMC_PERLIN_SSE2
+
+__m128 Fade(__m128 t) noexcept {
+  auto t3 = _mm_mul_ps(_mm_mul_ps(t, t), t);
+  auto inner = _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6)), _mm_set1_ps(15));
+  return _mm_mul_ps(t3, _mm_add_ps(_mm_mul_ps(t, inner), _mm_set1_ps(10)));
+}
+
+__m128 Lerp(__m128 a, __m128 b, __m128 t) noexcept {
+  return _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1), t), a), _mm_mul_ps(t, b));
+}
+
+void SampleSSE2(const std::uint16_t *permu, std::uint32_t mask, const float *x, const float *y, float *dst) noexcept {
+  auto one = _mm_set1_ps(1);
+
+  // Floor without SSE4.1, exact for |p| < 2^31 like the int conversion.
+  // The floor has the sign of p, which keeps floor(-0) = -0 as std::floor.
+  auto sign = _mm_set1_ps(-0.f);
+  auto px = _mm_loadu_ps(x), py = _mm_loadu_ps(y);
+  auto trunc_x = _mm_cvtepi32_ps(_mm_cvttps_epi32(px));
+  auto trunc_y = _mm_cvtepi32_ps(_mm_cvttps_epi32(py));
+  auto floor_x = _mm_sub_ps(trunc_x, _mm_and_ps(_mm_cmplt_ps(px, trunc_x), one));
+  auto floor_y = _mm_sub_ps(trunc_y, _mm_and_ps(_mm_cmplt_ps(py, trunc_y), one));
+  floor_x = _mm_or_ps(floor_x, _mm_and_ps(px, sign));
+  floor_y = _mm_or_ps(floor_y, _mm_and_ps(py, sign));
+  auto fx = _mm_sub_ps(px, floor_x), fy = _mm_sub_ps(py, floor_y);
+
+  // No gather before AVX2, the table lookups are scalar
+  alignas(16) std::int32_t ix[4], iy[4];
+  _mm_store_si128(reinterpret_cast<__m128i *>(ix), _mm_cvttps_epi32(floor_x));
+  _mm_store_si128(reinterpret_cast<__m128i *>(iy), _mm_cvttps_epi32(floor_y));
+  alignas(16) float gx[4][4], gy[4][4];
+  for (int i = 0; i != 4; ++i) {
+    auto x0 = ix[i], y0 = iy[i];
+    std::uint32_t hashes[4]{
+        Hash(permu, mask, x0, y0),
+        Hash(permu, mask, x0 + 1, y0),
+        Hash(permu, mask, x0, y0 + 1),
+        Hash(permu, mask, x0 + 1, y0 + 1),
+    };
+    for (int corner = 0; corner != 4; ++corner) {
+      gx[corner][i] = kPerlinGrad[hashes[corner]].x;
+      gy[corner][i] = kPerlinGrad[hashes[corner]].y;
+    }
+  }
+
+  auto grad = [&](int corner, __m128 tx, __m128 ty) {
+    return _mm_add_ps(_mm_mul_ps(_mm_load_ps(gx[corner]), tx), _mm_mul_ps(_mm_load_ps(gy[corner]), ty));
+  };
+  auto fx1 = _mm_sub_ps(fx, one), fy1 = _mm_sub_ps(fy, one);
+  auto g00 = grad(0, fx, fy);
+  auto g10 = grad(1, fx1, fy);
+  auto g01 = grad(2, fx, fy1);
+  auto g11 = grad(3, fx1, fy1);
+
+  auto u = Fade(fx), v = Fade(fy);
+  _mm_storeu_ps(dst, Lerp(Lerp(g00, g10, u), Lerp(g01, g11, u), v));
+}
+
+#endif
+
+} // namespace
+
+float SamplePerlin(const std::uint16_t *permu, std::uint32_t mask, glm::vec2 p) noexcept {
+  auto floor_x = std::floor(p.x), floor_y = std::floor(p.y);
+  auto fx = p.x - floor_x, fy = p.y - floor_y;
+  auto x0 = std::int32_t(floor_x), y0 = std::int32_t(floor_y);
+
+  auto g00 = Grad(Hash(permu, mask, x0, y0), fx, fy);
+  auto g10 = Grad(Hash(permu, mask, x0 + 1, y0), fx - 1, fy);
+  auto g01 = Grad(Hash(permu, mask, x0, y0 + 1), fx, fy - 1);
+  auto g11 = Grad(Hash(permu, mask, x0 + 1, y0 + 1), fx - 1, fy - 1);
+
+  auto u = Fade(fx), v = Fade(fy);
+  return Lerp(Lerp(g00, g10, u), Lerp(g01, g11, u), v);
+}
+
+float SamplePerlin(const std::uint16_t *permu, std::uint32_t mask, glm::vec3 p) noexcept {
+  auto floor = glm::floor(p);
+  auto f = p - floor;
+  glm::ivec3 i{floor};
+
+  auto grad = [&](std::int32_t dx, std::int32_t dy, std::int32_t dz) {
+    auto xy = permu[permu[(i.x + dx) & mask] + ((i.y + dy) & mask)];
+    auto &g = kPerlinGrad3[permu[xy + ((i.z + dz) & mask)] & (kPerlinGrad3.size() - 1)];
+    return g.x * (f.x - dx) + g.y * (f.y - dy) + g.z * (f.z - dz);
+  };
+
+  auto u = Fade(f.x), v = Fade(f.y), w = Fade(f.z);
+  return Lerp(
+      Lerp(Lerp(grad(0, 0, 0), grad(1, 0, 0), u), Lerp(grad(0, 1, 0), grad(1, 1, 0), u), v),
+      Lerp(Lerp(grad(0, 0, 1), grad(1, 0, 1), u), Lerp(grad(0, 1, 1), grad(1, 1, 1), u), v),
+      w
+  );
+}
+
+void SamplePerlin(
+    const std::uint16_t *permu, std::uint32_t mask,
+    const float *x, const float *y, float *dst, std::size_t n
+) noexcept {
+  std::size_t i = 0;
+#if defined(VKMC_PERLIN_AVX2)
+  for (; i + 8 <= n; i += 8) {
+    SampleAVX2(permu, mask, x + i, y + i, dst + i);
+  }
+#elif defined(VKMC_PERLIN_SSE2)
+  for (; i + 4 <= n; i += 4) {
+    SampleSSE2(permu, mask, x + i, y + i, dst + i);
+  }
+#endif
+  for (; i != n; ++i) {
+    dst[i] = SamplePerlin(permu, mask, {x[i], y[i]});
+  }
+}
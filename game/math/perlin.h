@@ -6,56 +6,55 @@
 #include <array>
 #include <concepts>
 #include <cstddef>
-#include <cstring>
+#include <cstdint>
+#include <numeric>
 
-#include <glm/common.hpp>
-#include <glm/geometric.hpp>
 #include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
 
 extern const std::array<glm::vec2, 8> kPerlinGrad;
 
+/// The noise at p with a permutation table of 2 * (mask + 1) entries
+[[nodiscard]] float SamplePerlin(const std::uint16_t *permu, std::uint32_t mask, glm::vec2 p) noexcept;
+
+/// The 3-D noise at p with a permutation table of 2 * (mask + 1) entries
+[[nodiscard]] float SamplePerlin(const std::uint16_t *permu, std::uint32_t mask, glm::vec3 p) noexcept;
+
+/// The noise at the n points (x[i], y[i]), evaluated 8 or 4 points at once
+/// with AVX2 or SSE2. The results are bit-identical to the single point version.
+void SamplePerlin(
+    const std::uint16_t *permu, std::uint32_t mask,
+    const float *x, const float *y, float *dst, std::size_t n
+) noexcept;
+
 template <std::size_t Permu>
 class Perlin {
+  static_assert(Permu != 0 && (Permu & (Permu - 1)) == 0, "Coordinates are masked instead of modulo");
+  static_assert(Permu <= std::size_t(1) << 16, "The permutation is stored in 16 bits");
+
 public:
   template <std::invocable<> Rnd>
   Perlin(Rnd &&rand) {
-    for (std::size_t i = 0; i != Permu; ++i) {
-      permu_[i] = i;
-    }
+    std::iota(permu_, permu_ + Permu, std::uint16_t(0));
     std::shuffle(permu_, permu_ + Permu, rand);
-    std::memcpy(permu_ + Permu, permu_, sizeof(std::size_t) * Permu);
-  }
-
-  [[nodiscard]] float operator()(glm::vec2 p) noexcept {
-    glm::ivec2 flr{glm::floor(p)}, cir{flr.x + 1, flr.y + 1};
-    auto pf = glm::fract(p);
-    glm::vec2 t{Fade(pf.x), Fade(pf.y)};
-    return Lerp(
-        Lerp(Grad(flr, pf), Grad({cir.x, flr.y}, pf - glm::vec2(1, 0)), t.x),
-        Lerp(Grad({flr.x, cir.y}, pf - glm::vec2(0, 1)), Grad(cir, pf - glm::vec2(1, 1)), t.x),
-        t.y
-    );
-  }
-
-private:
-  auto Grad(glm::ivec2 p, glm::vec2 t) noexcept {
-    return glm::dot(kPerlinGrad[Hash(p) % kPerlinGrad.size()], t);
+    std::copy(permu_, permu_ + Permu, permu_ + Permu);
   }
 
-  float Fade(float t) noexcept {
-    return t * t * t * (t * (t * 6 - 15) + 10);
+  [[nodiscard]] float operator()(glm::vec2 p) const noexcept {
+    return SamplePerlin(permu_, Permu - 1, p);
   }
 
-  float Lerp(float a, float b, float t) noexcept {
-    return (1 - t) * a + t * b;
+  [[nodiscard]] float operator()(glm::vec3 p) const noexcept {
+    return SamplePerlin(permu_, Permu - 1, p);
   }
 
-  std::size_t Hash(glm::ivec2 p) noexcept {
-    return permu_[permu_[p.x % Permu] + p.y % Permu];
+  /// Write the noise at (x[i], y[i]) to dst[i] for n points
+  void operator()(const float *x, const float *y, float *dst, std::size_t n) const noexcept {
+    SamplePerlin(permu_, Permu - 1, x, y, dst, n);
   }
 
 private:
-  std::size_t permu_[Permu * 2];
+  std::uint16_t permu_[Permu * 2];
 };
 
 #endif // VKMC_MATH_PERLIN_H_
@@ -2,20 +2,60 @@
 #ifndef VKMC_MESH_FACE_INSTANCE_H_
 #define VKMC_MESH_FACE_INSTANCE_H_
 
-#include <span>
+#include <cstdint>
 
+#include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
-#include <vulkan/vulkan.hpp>
 
 #include "../block/types.h"
 
+/// A block face packed in 8 bytes. The position is local to the section,
+/// the vertex shader adds the origin of the section found by its slot.
 struct FaceInstance {
-  FaceDirection face;
-  TextureId texture;
-  glm::ivec3 position;
+  static constexpr std::uint32_t kTextureBits = 12;
+  static constexpr std::uint32_t kSlotBits = 32 - kTextureBits;
+  static constexpr std::uint32_t kMaxTextures = 1u << kTextureBits;
+  static constexpr std::uint32_t kMaxSlots = 1u << kSlotBits;
 
-  [[nodiscard]] static std::span<const vk::VertexInputAttributeDescription>
-  GetInputAttributes() noexcept;
+  /// x:5 y:5 z:5 direction:3 (extent.x - 1):5 (extent.y - 1):5
+  std::uint32_t packed;
+  /// texture:12 slot:20
+  std::uint32_t texture_slot;
+
+  /// Pack a face at a position in 0..31 covering 1..32 blocks along its two axes
+  [[nodiscard]] static constexpr FaceInstance Pack(
+      FaceDirection face, TextureId texture, glm::ivec3 position, glm::uvec2 extent, std::uint32_t slot
+  ) noexcept {
+    return {
+        .packed = std::uint32_t(position.x) | std::uint32_t(position.y) << 5 |
+                  std::uint32_t(position.z) << 10 | std::uint32_t(face) << 15 |
+                  (extent.x - 1) << 18 | (extent.y - 1) << 23,
+        .texture_slot = texture | slot << kTextureBits,
+    };
+  }
+
+  [[nodiscard]] constexpr glm::ivec3 GetPosition() const noexcept {
+    return {packed & 31, packed >> 5 & 31, packed >> 10 & 31};
+  }
+
+  [[nodiscard]] constexpr FaceDirection GetFace() const noexcept {
+    return FaceDirection(packed >> 15 & 7);
+  }
+
+  /// The number of blocks the face covers along its two axes
+  [[nodiscard]] constexpr glm::uvec2 GetExtent() const noexcept {
+    return {(packed >> 18 & 31) + 1, (packed >> 23 & 31) + 1};
+  }
+
+  [[nodiscard]] constexpr TextureId GetTexture() const noexcept {
+    return texture_slot & (kMaxTextures - 1);
+  }
+
+  [[nodiscard]] constexpr std::uint32_t GetSlot() const noexcept {
+    return texture_slot >> kTextureBits;
+  }
 };
 
+static_assert(sizeof(FaceInstance) == 8);
+
 #endif // VKMC_MESH_FACE_INSTANCE_H_
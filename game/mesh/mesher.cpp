@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <array>
+
+#include "mesher.h"
+
+namespace {
+
+constexpr int kLength = ChunkSection::kLength;
+constexpr int kLast = kLength - 1;
+
+constexpr std::array kFaceDirections{
+    FaceDirection::kNorth,
+    FaceDirection::kSouth,
+    FaceDirection::kWest,
+    FaceDirection::kEast,
+    FaceDirection::kTop,
+    FaceDirection::kBottom,
+};
+
+/// Indices of the normal axis and the two axes a face spans, matches the
+/// extent layout of FaceInstance and the cube in block.vert
+struct FaceAxes {
+  int n, u, v;
+};
+
+constexpr FaceAxes kFaceAxes[6]{
+    {2, 0, 1}, // north: +z
+    {2, 0, 1}, // south: -z
+    {0, 2, 1}, // west: +x
+    {0, 2, 1}, // east: -x
+    {1, 0, 2}, // top: +y
+    {1, 0, 2}, // bottom: -y
+};
+
+bool IsOpaque(BlockId block) noexcept {
+  return block != blocks::kAir;
+}
+
+bool IsOpaque(const ChunkBorderSlab &slab, int a, int b) noexcept {
+  return IsOpaque(slab[a * kLength + b]);
+}
+
+/// Test whether the face of the block at (x, y, z) is not covered by its neighbour
+bool IsFaceVisible(const ChunkMeshInput &in, int x, int y, int z, FaceDirection dir) noexcept {
+  auto &blocks = in.blocks;
+  switch (dir) {
+    case FaceDirection::kNorth:
+      return z == kLast ? !IsOpaque(in.north, y, x) : !IsOpaque(blocks(x, y, z + 1));
+    case FaceDirection::kSouth:
+      return z == 0 ? !IsOpaque(in.south, y, x) : !IsOpaque(blocks(x, y, z - 1));
+    case FaceDirection::kWest:
+      return x == kLast ? !IsOpaque(in.west, y, z) : !IsOpaque(blocks(x + 1, y, z));
+    case FaceDirection::kEast:
+      return x == 0 ? !IsOpaque(in.east, y, z) : !IsOpaque(blocks(x - 1, y, z));
+    case FaceDirection::kTop:
+      return y == kLast ? !IsOpaque(in.top, x, z) : !IsOpaque(blocks(x, y + 1, z));
+    case FaceDirection::kBottom:
+      return y == 0 ? !IsOpaque(in.bottom, x, z) : !IsOpaque(blocks(x, y - 1, z));
+  }
+  return true;
+}
+
+/// Copy the plane of a section where the axis equals to plane, the other
+/// two axes are taken in the order of ChunkBorderSlab
+void CaptureSlab(ChunkBorderSlab &slab, const ChunkSection *section, int axis, int plane) noexcept {
+  if (section == nullptr || section->IsUniform()) {
+    slab.fill(section ? section->GetUniformBlock() : blocks::kAir);
+    return;
+  }
+  for (int a = 0; a != kLength; ++a) {
+    for (int b = 0; b != kLength; ++b) {
+      auto &block = slab[a * kLength + b];
+      switch (axis) {
+        case 0: block = (*section)(plane, a, b); break;
+        case 1: block = (*section)(a, plane, b); break;
+        case 2: block = (*section)(b, a, plane); break;
+      }
+    }
+  }
+}
+
+bool IsSlabOpaque(const ChunkBorderSlab &slab) noexcept {
+  return std::ranges::all_of(slab, [](BlockId block) { return IsOpaque(block); });
+}
+
+} // namespace
+
+void ChunkMeshInput::Capture(
+    ChunkId chunk_id, std::uint32_t section_index, const Chunk &chunk,
+    const Chunk *north_chunk, const Chunk *south_chunk,
+    const Chunk *west_chunk, const Chunk *east_chunk
+) {
+  auto section_of = [section_index](const Chunk *chunk) {
+    return chunk ? &chunk->GetSection(section_index) : nullptr;
+  };
+
+  id = chunk_id;
+  section = section_index;
+  blocks = chunk.GetSection(section_index);
+  CaptureSlab(north, section_of(north_chunk), 2, 0);
+  CaptureSlab(south, section_of(south_chunk), 2, kLast);
+  CaptureSlab(west, section_of(west_chunk), 0, 0);
+  CaptureSlab(east, section_of(east_chunk), 0, kLast);
+
+  auto above = section_index + 1 != Chunk::kSections ? &chunk.GetSection(section_index + 1) : nullptr;
+  auto below = section_index != 0 ? &chunk.GetSection(section_index - 1) : nullptr;
+  CaptureSlab(top, above, 1, 0);
+  CaptureSlab(bottom, below, 1, kLast);
+}
+
+std::uint32_t ChunkMesher::Generate(MeshingMode mode, const ChunkMeshInput &input, FaceInstance *dst) const {
+  // Skip sections without any visible face
+  if (input.blocks.IsUniform()) {
+    if (!IsOpaque(input.blocks.GetUniformBlock())) {
+      return 0;
+    }
+    auto slabs = {&input.north, &input.south, &input.west, &input.east, &input.top, &input.bottom};
+    if (std::ranges::all_of(slabs, [](auto slab) { return IsSlabOpaque(*slab); })) {
+      return 0;
+    }
+  }
+
+  switch (mode) {
+    case MeshingMode::kPerFace: return GeneratePerFace(input, dst);
+    case MeshingMode::kGreedy: return GenerateGreedy(input, dst);
+  }
+  return 0;
+}
+
+std::uint32_t ChunkMesher::GeneratePerFace(const ChunkMeshInput &input, FaceInstance *dst) const {
+  auto &blocks = input.blocks;
+  auto faces = dst;
+
+  for (int y = 0; y != kLength; ++y) {
+    for (int x = 0; x != kLength; ++x) {
+      for (int z = 0; z != kLength; ++z) {
+        auto block = blocks(x, y, z);
+        if (block == blocks::kAir) {
+          continue;
+        }
+        for (auto dir : kFaceDirections) {
+          if (IsFaceVisible(input, x, y, z, dir)) {
+            *faces++ = FaceInstance::Pack(
+                dir, registry_.GetFaceTextureId(block, dir), {x, y, z}, {1, 1}, input.slot
+            );
+          }
+        }
+      }
+    }
+  }
+
+  return faces - dst;
+}
+
+std::uint32_t ChunkMesher::GenerateGreedy(const ChunkMeshInput &input, FaceInstance *dst) const {
+  constexpr int n = kLength;
+
+  auto &blocks = input.blocks;
+  auto faces = dst;
+
+  // Texture id + 1 of the visible face in each cell of a slice, 0 for no face
+  std::array<std::uint32_t, n * n> mask;
+
+  for (auto dir : kFaceDirections) {
+    auto axes = kFaceAxes[std::uint32_t(dir)];
+
+    for (int slice = 0; slice != n; ++slice) {
+      glm::ivec3 pos;
+      pos[axes.n] = slice;
+      for (int v = 0; v != n; ++v) {
+        pos[axes.v] = v;
+        for (int u = 0; u != n; ++u) {
+          pos[axes.u] = u;
+          auto block = blocks(pos.x, pos.y, pos.z);
+          auto visible = block != blocks::kAir && IsFaceVisible(input, pos.x, pos.y, pos.z, dir);
+          mask[v * n + u] = visible ? registry_.GetFaceTextureId(block, dir) + 1 : 0;
+        }
+      }
+
+      for (int v = 0; v != n; ++v) {
+        for (int u = 0; u != n;) {
+          auto cell = mask[v * n + u];
+          if (cell == 0) {
+            ++u;
+            continue;
+          }
+
+          // Grow along u first, then extend the whole row along v
+          int w = 1;
+          while (u + w != n && mask[v * n + u + w] == cell) {
+            ++w;
+          }
+          int h = 1;
+          for (; v + h != n; ++h) {
+            auto row = mask.begin() + (v + h) * n + u;
+            if (!std::all_of(row, row + w, [cell](auto c) { return c == cell; })) {
+              break;
+            }
+          }
+
+          for (int dv = 0; dv != h; ++dv) {
+            auto row = mask.begin() + (v + dv) * n + u;
+            std::fill(row, row + w, 0);
+          }
+
+          pos[axes.u] = u;
+          pos[axes.v] = v;
+          *faces++ = FaceInstance::Pack(dir, cell - 1, pos, glm::uvec2(w, h), input.slot);
+
+          u += w;
+        }
+      }
+    }
+  }
+
+  return faces - dst;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#ifndef VKMC_MESH_MESHER_H_
+#define VKMC_MESH_MESHER_H_
+
+#include <array>
+#include <cstdint>
+
+#include "../block/registry.h"
+#include "../chunk/chunk.h"
+#include "face_instance.h"
+
+enum class MeshingMode {
+  /// One unit quad for each visible block face
+  kPerFace,
+  /// Merge coplanar visible faces with the same texture into rectangles
+  kGreedy,
+};
+
+/// A copy of the blocks touching a face of the meshed section, indexed by
+/// [y][x] for north and south, [y][z] for west and east, [x][z] for top
+/// and bottom.
+using ChunkBorderSlab = std::array<BlockId, ChunkSection::kLength * ChunkSection::kLength>;
+
+/// A snapshot of the section to build a mesh for and the border slabs of
+/// its six neighbours, so meshing can run off the main thread.
+struct ChunkMeshInput {
+  ChunkId id;
+  std::uint32_t section;
+  /// The slot of the section origin written to the faces, see FaceInstance
+  std::uint32_t slot;
+  ChunkSection blocks;
+  ChunkBorderSlab north;
+  ChunkBorderSlab south;
+  ChunkBorderSlab west;
+  ChunkBorderSlab east;
+  ChunkBorderSlab top;
+  ChunkBorderSlab bottom;
+
+  /// Copy the section of the chunk and the borders of its neighbours,
+  /// a null neighbour chunk is treated as air
+  void Capture(
+      ChunkId, std::uint32_t section, const Chunk &,
+      const Chunk *north, const Chunk *south,
+      const Chunk *west, const Chunk *east
+  );
+};
+
+class ChunkMesher {
+public:
+  /// The maximum number of faces a section mesh can have
+  static constexpr std::size_t kMaxFaces = ChunkSection::kVolume * 6;
+
+  ChunkMesher(const BlockRegistry &registry) noexcept : registry_(registry) {}
+
+  /// Write the visible faces of the section to dst, returns the number of faces.
+  /// The dst should be able to hold kMaxFaces faces.
+  std::uint32_t Generate(MeshingMode, const ChunkMeshInput &, FaceInstance *dst) const;
+
+private:
+  std::uint32_t GeneratePerFace(const ChunkMeshInput &, FaceInstance *dst) const;
+  std::uint32_t GenerateGreedy(const ChunkMeshInput &, FaceInstance *dst) const;
+
+  const BlockRegistry &registry_;
+};
+
+#endif // VKMC_MESH_MESHER_H_
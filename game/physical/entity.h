@@ -5,9 +5,12 @@
 #include <glm/vec3.hpp>
 
 struct Entity {
+  /// The size of the collision box, which is centered on the position
   glm::vec3 aabb;
   glm::vec3 position;
+  /// Blocks per physics step
   glm::vec3 velocity;
+  /// Added to the velocity in each physics step until the next update
   glm::vec3 acceleration;
 };
 
@@ -1,8 +1,38 @@
 #include <algorithm>
+#include <cmath>
 
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include "../chunk/neighborhood.h"
 #include "entity_chunk_system.h"
 
-void EntityChunkSystem::Update(Entity &entity, ChunkManager &chunks) {
+namespace {
+
+/// How far a box may overlap a block and still count as touching it,
+/// absorbs the rounding of positions after a stop
+constexpr float kEpsilon = 1e-3f;
+
+/// The axes swept in order, y first so an entity lands before it slides
+constexpr int kAxes[]{1, 0, 2};
+
+} // namespace
+
+int EntityChunkSystem::Update(Entity &entity, const ChunkManager &chunks, double elapsed) {
+  accumulator_ += elapsed;
+  int steps = 0;
+  for (; accumulator_ >= kStep && steps != kMaxSteps; ++steps) {
+    Step(entity, chunks);
+    accumulator_ -= kStep;
+  }
+  if (steps == kMaxSteps) {
+    accumulator_ = std::fmod(accumulator_, kStep);
+  }
+  entity.acceleration = glm::vec3(0);
+  return steps;
+}
+
+void EntityChunkSystem::Step(Entity &entity, const ChunkManager &chunks) {
   entity.velocity += entity.acceleration;
   if (glm::length(entity.velocity) > .5) {
     entity.velocity = glm::normalize(entity.velocity) * glm::vec3(0.5);
@@ -10,6 +40,59 @@ void EntityChunkSystem::Update(Entity &entity, ChunkManager &chunks) {
   if (glm::length(entity.acceleration) == 0) {
     entity.velocity = glm::vec3(0);
   }
-  entity.acceleration = glm::vec3(0);
-  entity.position += entity.velocity;
+  auto &move = entity.velocity;
+  if (move == glm::vec3(0)) {
+    return;
+  }
+
+  auto half = entity.aabb * .5f;
+  auto min = entity.position - half, max = entity.position + half;
+
+  // Broad phase, the solid blocks in the box swept by the whole move
+  glm::ivec3 first = glm::floor(glm::min(min, min + move));
+  glm::ivec3 last = glm::floor(glm::max(max, max + move));
+  first.y = std::max(first.y, 0);
+  last.y = std::min(last.y, std::int32_t(Chunk::kHeight) - 1);
+  ChunkNeighborhood around(chunks, Chunk::GetChunkIdFromWorldPosition(glm::floor(entity.position)));
+  blocks_.clear();
+  for (auto y = first.y; y <= last.y; ++y) {
+    for (auto x = first.x; x <= last.x; ++x) {
+      for (auto z = first.z; z <= last.z; ++z) {
+        if (around.GetBlock({x, y, z}) != blocks::kAir) {
+          blocks_.emplace_back(x, y, z);
+        }
+      }
+    }
+  }
+
+  // Narrow phase, clip the move on each axis by the blocks ahead which
+  // overlap the box on the other two axes. Blocks the box already
+  // overlaps are ignored so an entity inside a block can get out.
+  for (auto axis : kAxes) {
+    auto distance = move[axis];
+    if (distance == 0) {
+      continue;
+    }
+    auto a = (axis + 1) % 3, b = (axis + 2) % 3;
+    for (auto &block : blocks_) {
+      glm::vec3 lower = block, upper = lower + 1.f;
+      if (min[a] >= upper[a] - kEpsilon || max[a] <= lower[a] + kEpsilon ||
+          min[b] >= upper[b] - kEpsilon || max[b] <= lower[b] + kEpsilon) {
+        continue;
+      }
+      // A box already touching the block within kEpsilon stops there
+      // instead of moving back against its direction
+      if (distance > 0 && max[axis] <= lower[axis] + kEpsilon) {
+        distance = std::min(distance, std::max(0.f, lower[axis] - max[axis]));
+      } else if (distance < 0 && min[axis] >= upper[axis] - kEpsilon) {
+        distance = std::max(distance, std::min(0.f, upper[axis] - min[axis]));
+      }
+    }
+    min[axis] += distance;
+    max[axis] += distance;
+    entity.position[axis] += distance;
+    if (distance != move[axis]) {
+      move[axis] = 0;
+    }
+  }
 }
@@ -2,13 +2,39 @@
 #ifndef VKMC_PHYSICAL_ENTITY_CHUNK_SYSTEM_H_
 #define VKMC_PHYSICAL_ENTITY_CHUNK_SYSTEM_H_
 
+#include <vector>
+
+#include <glm/vec3.hpp>
+
 #include "entity.h"
 #include "../chunk/manager.h"
 
+/// Moves entities through the blocks at a fixed timestep. Each step
+/// gathers the solid blocks the entity may touch with one box query and
+/// sweeps its box along y, x and z in turn, stopping on the first block
+/// on each axis. A step depends only on the entity and the blocks, so
+/// the same steps give the same positions at any frame rate.
 class EntityChunkSystem {
-
 public:
-    void Update(Entity &, ChunkManager &);
+  /// The length of a physics step in seconds
+  static constexpr double kStep = 1. / 60;
+  /// The steps taken by one update at most, the rest of a long frame is
+  /// dropped instead of stalling the next frames
+  static constexpr int kMaxSteps = 8;
+
+  /// Advance the entity by whole steps in the elapsed seconds, the time
+  /// left is carried to the next update. The acceleration is applied in
+  /// each step and then cleared. Returns the number of steps taken.
+  int Update(Entity &, const ChunkManager &, double elapsed);
+
+  /// Advance the entity by one step
+  void Step(Entity &, const ChunkManager &);
+
+private:
+  /// Seconds not yet simulated
+  double accumulator_ = 0;
+  /// The solid blocks around the entity in the current step
+  std::vector<glm::ivec3> blocks_;
 };
 
 #endif // VKMC_PHYSICAL_ENTITY_CHUNK_SYSTEM_H_
@@ -0,0 +1,92 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include "raycast.h"
+
+namespace {
+
+ChunkId GetStartChunk(const Ray &ray) noexcept {
+  return Chunk::GetChunkIdFromWorldPosition(glm::floor(ray.origin));
+}
+
+} // namespace
+
+std::optional<RayHit> CastRay(ChunkNeighborhood &around, const Ray &ray) noexcept {
+  constexpr auto kInfinity = std::numeric_limits<float>::infinity();
+  auto direction = glm::normalize(ray.direction);
+
+  glm::ivec3 block = glm::floor(ray.origin);
+  glm::ivec3 step;
+  // The distance along the ray to the next boundary on each axis, and
+  // between two boundaries
+  glm::vec3 next, delta;
+  for (int axis = 0; axis != 3; ++axis) {
+    auto d = direction[axis];
+    step[axis] = d > 0 ? 1 : d < 0 ? -1 : 0;
+    if (step[axis] == 0) {
+      next[axis] = delta[axis] = kInfinity;
+      continue;
+    }
+    delta[axis] = std::abs(1 / d);
+    auto boundary = float(block[axis] + (step[axis] > 0));
+    next[axis] = (boundary - ray.origin[axis]) / d;
+  }
+
+  glm::ivec3 normal(0);
+  float distance = 0;
+  // The chunk the ray is in, resolved once when the ray enters it
+  const Chunk *chunk = nullptr;
+  ChunkId chunk_id{};
+  while (true) {
+    if (std::uint32_t(block.y) < Chunk::kHeight) {
+      if (auto id = Chunk::GetChunkIdFromWorldPosition(block); chunk == nullptr || id != chunk_id) {
+        if (!around.Contains(block)) {
+          around.Recenter(id);
+        }
+        chunk = &around.GetChunkAt(block);
+        chunk_id = id;
+      }
+      if (auto id = (*chunk)(Chunk::GetPositionInChunk(block)); id != blocks::kAir) {
+        return RayHit{.block = block, .normal = normal, .distance = distance, .id = id};
+      }
+    }
+
+    int axis = next.x < next.y ? (next.x < next.z ? 0 : 2) : (next.y < next.z ? 1 : 2);
+    distance = next[axis];
+    if (distance > ray.max_distance) {
+      return std::nullopt;
+    }
+    block[axis] += step[axis];
+    next[axis] += delta[axis];
+    normal = glm::ivec3(0);
+    normal[axis] = -step[axis];
+
+    // Nothing to hit once the ray leaves the world vertically
+    if ((block.y < 0 && step.y <= 0) || (block.y >= std::int32_t(Chunk::kHeight) && step.y >= 0)) {
+      return std::nullopt;
+    }
+  }
+}
+
+std::optional<RayHit> CastRay(const ChunkManager &chunks, const Ray &ray) noexcept {
+  ChunkNeighborhood around(chunks, GetStartChunk(ray));
+  return CastRay(around, ray);
+}
+
+void CastRays(const ChunkManager &chunks, std::span<const Ray> rays, std::span<std::optional<RayHit>> hits) {
+  assert(rays.size() == hits.size());
+  if (rays.empty()) {
+    return;
+  }
+
+  ChunkNeighborhood around(chunks, GetStartChunk(rays.front()));
+  for (std::size_t i = 0; i != rays.size(); ++i) {
+    around.Recenter(GetStartChunk(rays[i]));
+    hits[i] = CastRay(around, rays[i]);
+  }
+}
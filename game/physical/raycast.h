@@ -0,0 +1,45 @@
+#pragma once
+#ifndef VKMC_PHYSICAL_RAYCAST_H_
+#define VKMC_PHYSICAL_RAYCAST_H_
+
+#include <optional>
+#include <span>
+
+#include <glm/vec3.hpp>
+
+#include "../chunk/manager.h"
+#include "../chunk/neighborhood.h"
+
+struct Ray {
+  glm::vec3 origin;
+  /// Need not be normalized, must not be zero
+  glm::vec3 direction;
+  /// Must be finite
+  float max_distance;
+};
+
+struct RayHit {
+  /// The world position of the block hit
+  glm::ivec3 block;
+  /// The outward normal of the face entered, zero if the ray starts in
+  /// the block. The block placed against the face is block + normal.
+  glm::ivec3 normal;
+  /// The distance along the ray to the face
+  float distance;
+  BlockId id;
+};
+
+/// Walk the blocks along a ray with the Amanatides and Woo traversal,
+/// every block the ray touches is visited once, and return the first
+/// block which is not air. The neighbourhood is moved with the ray when
+/// it leaves the chunks around the current center.
+[[nodiscard]] std::optional<RayHit> CastRay(ChunkNeighborhood &around, const Ray &ray) noexcept;
+
+[[nodiscard]] std::optional<RayHit> CastRay(const ChunkManager &chunks, const Ray &ray) noexcept;
+
+/// Cast many rays, hits[i] is the result of rays[i]. The rays share one
+/// neighbourhood, consecutive rays starting in the same chunk like the
+/// rays of a light probe look up the chunks around it once.
+void CastRays(const ChunkManager &chunks, std::span<const Ray> rays, std::span<std::optional<RayHit>> hits);
+
+#endif // VKMC_PHYSICAL_RAYCAST_H_
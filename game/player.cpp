@@ -1,14 +1,15 @@
 #include <numbers>
-#include <optional>
 
 #include <event.h>
 #include <input.h>
 
 #include "window.h"
 
+#include "physical/raycast.h"
 #include "player.h"
 
-Player::Player(ChunkManager &chunks) noexcept : chunks_(chunks), first_mouse_(true), yaw_(0), pitch_(0) {
+Player::Player(ChunkManager &chunks, Entity &entity) noexcept
+    : entity_(entity), chunks_(chunks), first_mouse_(true), yaw_(0), pitch_(0) {
   camera_.aspect = float(window::GetWidth()) / window::GetHeight();
   camera_.near = 0.1;
   camera_.far = 128;
@@ -101,24 +102,9 @@ void Player::UpdateRotateByMouse(double x, double y) {
   camera_.gaze = gaze;
 }
 
-std::optional<glm::vec3> Player::RayMarch(
-    const glm::vec3 &start,
-    const glm::vec3 &gaze
-) {
-  auto dist = glm::length(gaze);
-  auto step = glm::normalize(gaze);
-  for (float k = 0; k < dist; k += std::min(1.f, dist - k)) {
-    auto center = glm::floor(start + step * glm::vec3(k));
-    if (chunks_.GetBlock(center) != blocks::kAir) {
-      return center;
-    }
-  }
-  return std::nullopt;
-}
-
 void Player::DestroyBlock() {
-  auto target = RayMarch(entity_.position, glm::normalize(camera_.gaze) * glm::vec3(10));
-  if (target.has_value()) {
-    chunks_.SetBlock(target.value(), blocks::kAir);
+  auto hit = CastRay(chunks_, {.origin = entity_.position, .direction = camera_.gaze, .max_distance = kReach});
+  if (hit.has_value()) {
+    chunks_.SetBlock(hit->block, blocks::kAir);
   }
 }
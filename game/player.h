@@ -2,8 +2,6 @@
 #ifndef VKMC_PLAYER_H_
 #define VKMC_PLAYER_H_
 
-#include <optional>
-
 #include <glm/vec3.hpp>
 
 #include <event/scope.h>
@@ -14,13 +12,15 @@
 
 class Player : EventScope {
 public:
-  static constexpr float kHeight = 2;
-  static constexpr float kWidth = 1;
+  static constexpr float kHeight = 1.8;
+  static constexpr float kWidth = 0.6;
   static constexpr float kMove = 0.1;
+  /// How far away blocks can be destroyed
+  static constexpr float kReach = 10;
 
 private:
   Camera camera_;
-  Entity entity_;
+  Entity &entity_;
 
   ChunkManager &chunks_;
 
@@ -31,7 +31,7 @@ private:
   float pitch_;
 
 public:
-  Player(ChunkManager &) noexcept;
+  Player(ChunkManager &, Entity &) noexcept;
 
   [[nodiscard]] Entity &GetEntity() noexcept {
     return entity_;
@@ -41,17 +41,16 @@ public:
     return camera_;
   }
 
+  void SetViewDistance(float distance) noexcept {
+    camera_.far = distance;
+  }
+
   void Update();
 
 private:
   void DestroyBlock();
 
   void UpdateRotateByMouse(double x, double y);
-
-  std::optional<glm::vec3> RayMarch(
-      const glm::vec3 &start,
-      const glm::vec3 &gaze
-  );
 };
 
 #endif // VKMC_PLAYER_H_
@@ -0,0 +1,96 @@
+#include <iterator>
+#include <stdexcept>
+
+#include "arena.h"
+
+ArenaAllocator::ArenaAllocator(std::size_t capacity) : capacity_(capacity), used_(0) {
+  if (capacity) {
+    InsertFree(0, capacity);
+  }
+}
+
+std::size_t ArenaAllocator::Allocate(std::size_t size) {
+  if (size == 0) {
+    throw std::runtime_error("Allocate zero bytes from arena!");
+  }
+
+  auto fit = free_by_size_.lower_bound({size, 0});
+  if (fit == free_by_size_.end()) {
+    return kInvalidOffset;
+  }
+
+  auto [range_size, offset] = *fit;
+  EraseFree(free_.find(offset));
+  if (range_size != size) {
+    InsertFree(offset + size, range_size - size);
+  }
+
+  allocated_.emplace(offset, size);
+  used_ += size;
+  return offset;
+}
+
+void ArenaAllocator::Free(std::size_t offset) {
+  auto it = allocated_.find(offset);
+  if (it == allocated_.end()) {
+    throw std::runtime_error("Free an unallocated range of arena!");
+  }
+  auto size = it->second;
+  allocated_.erase(it);
+  used_ -= size;
+
+  // Merge with the adjacent free ranges
+  auto next = free_.lower_bound(offset);
+  if (next != free_.end() && offset + size == next->first) {
+    size += next->second;
+    EraseFree(next++);
+  }
+  if (next != free_.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == offset) {
+      offset = prev->first;
+      size += prev->second;
+      EraseFree(prev);
+    }
+  }
+  InsertFree(offset, size);
+}
+
+std::vector<ArenaAllocator::Move> ArenaAllocator::Defragment() {
+  std::vector<Move> moves;
+  std::map<std::size_t, std::size_t> packed;
+  std::size_t cursor = 0;
+  for (auto [offset, size] : allocated_) {
+    if (offset != cursor) {
+      moves.push_back({.src = offset, .dst = cursor, .size = size});
+    }
+    packed.emplace_hint(packed.end(), cursor, size);
+    cursor += size;
+  }
+  allocated_.swap(packed);
+
+  free_.clear();
+  free_by_size_.clear();
+  if (cursor != capacity_) {
+    InsertFree(cursor, capacity_ - cursor);
+  }
+  return moves;
+}
+
+std::size_t ArenaAllocator::GetSize(std::size_t offset) const {
+  auto it = allocated_.find(offset);
+  if (it == allocated_.end()) {
+    throw std::runtime_error("Query an unallocated range of arena!");
+  }
+  return it->second;
+}
+
+void ArenaAllocator::InsertFree(std::size_t offset, std::size_t size) {
+  free_.emplace(offset, size);
+  free_by_size_.emplace(size, offset);
+}
+
+void ArenaAllocator::EraseFree(std::map<std::size_t, std::size_t>::iterator it) {
+  free_by_size_.erase({it->second, it->first});
+  free_.erase(it);
+}
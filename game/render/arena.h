@@ -0,0 +1,87 @@
+#pragma once
+#ifndef VKMC_RENDER_ARENA_H_
+#define VKMC_RENDER_ARENA_H_
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+/// Sub-allocator of a fixed range, such as a large buffer. It hands out
+/// offsets only and never touches the memory, so it can be used without a
+/// GPU. Free ranges are merged with their neighbours, allocations take the
+/// smallest free range that fits.
+class ArenaAllocator {
+public:
+  static constexpr std::size_t kInvalidOffset = ~std::size_t(0);
+
+  /// A range moved by defragmentation
+  struct Move {
+    std::size_t src;
+    std::size_t dst;
+    std::size_t size;
+  };
+
+  explicit ArenaAllocator(std::size_t capacity);
+
+  /// Allocate a range of non-zero size, returns kInvalidOffset if no free
+  /// range is large enough
+  [[nodiscard]] std::size_t Allocate(std::size_t size);
+
+  /// Free the range allocated at offset
+  void Free(std::size_t offset);
+
+  /// Pack all allocations to the front so the free space is a single range.
+  /// The moves are sorted by offset and never move a range backward, they
+  /// can be applied one by one with memmove.
+  std::vector<Move> Defragment();
+
+  /// Whether there is enough free space for the size, but not in one range
+  [[nodiscard]] bool IsFragmentedFor(std::size_t size) const noexcept {
+    return size <= GetFreeSize() && GetLargestFreeRange() < size;
+  }
+
+  /// The size of the range allocated at offset
+  [[nodiscard]] std::size_t GetSize(std::size_t offset) const;
+
+  [[nodiscard]] std::size_t GetCapacity() const noexcept {
+    return capacity_;
+  }
+
+  [[nodiscard]] std::size_t GetUsedSize() const noexcept {
+    return used_;
+  }
+
+  [[nodiscard]] std::size_t GetFreeSize() const noexcept {
+    return capacity_ - used_;
+  }
+
+  [[nodiscard]] std::size_t GetLargestFreeRange() const noexcept {
+    return free_by_size_.empty() ? 0 : free_by_size_.rbegin()->first;
+  }
+
+  [[nodiscard]] std::size_t GetAllocationCount() const noexcept {
+    return allocated_.size();
+  }
+
+  [[nodiscard]] std::size_t GetFreeRangeCount() const noexcept {
+    return free_.size();
+  }
+
+private:
+  void InsertFree(std::size_t offset, std::size_t size);
+  void EraseFree(std::map<std::size_t, std::size_t>::iterator);
+
+  std::size_t capacity_;
+  std::size_t used_;
+
+  /// offset -> size
+  std::map<std::size_t, std::size_t> free_;
+  /// (size, offset) for the best fit search
+  std::set<std::pair<std::size_t, std::size_t>> free_by_size_;
+  /// offset -> size
+  std::map<std::size_t, std::size_t> allocated_;
+};
+
+#endif // VKMC_RENDER_ARENA_H_
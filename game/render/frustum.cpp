@@ -0,0 +1,69 @@
+#include <cmath>
+
+#include <glm/matrix.hpp>
+
+#include "frustum.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define VKMC_FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
+
+Frustum::Frustum(const glm::mat4 &view_projection) noexcept {
+  // Rows of the matrix, glm is column major
+  auto m = glm::transpose(view_projection);
+  glm::vec4 planes[kPlanes]{
+      m[3] + m[0], // left
+      m[3] - m[0], // right
+      m[3] + m[1], // bottom
+      m[3] - m[1], // top
+      m[2],        // near
+      m[3] - m[2], // far
+      {0, 0, 0, 1},
+      {0, 0, 0, 1},
+  };
+
+  for (int i = 0; i != kPlanes; ++i) {
+    x_[i] = planes[i].x;
+    y_[i] = planes[i].y;
+    z_[i] = planes[i].z;
+    w_[i] = planes[i].w;
+  }
+}
+
+bool Frustum::IsBoxVisible(const glm::vec3 &min, const glm::vec3 &max) const noexcept {
+  // The box is outside if it is fully behind any plane. The farthest
+  // point of the box along the plane normal is c + |n| * e.
+  auto center = (min + max) * .5f;
+  auto extent = (max - min) * .5f;
+
+#ifdef VKMC_FRUSTUM_SSE
+  auto cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+  auto ex = _mm_set1_ps(extent.x), ey = _mm_set1_ps(extent.y), ez = _mm_set1_ps(extent.z);
+  auto sign = _mm_set1_ps(-0.f);
+
+  auto outside = _mm_setzero_ps();
+  for (int i = 0; i != kPlanes; i += 4) {
+    auto x = _mm_load_ps(x_ + i), y = _mm_load_ps(y_ + i), z = _mm_load_ps(z_ + i);
+    auto distance = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(x, cx), _mm_mul_ps(y, cy)),
+        _mm_add_ps(_mm_mul_ps(z, cz), _mm_load_ps(w_ + i))
+    );
+    auto radius = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign, x), ex), _mm_mul_ps(_mm_andnot_ps(sign, y), ey)),
+        _mm_mul_ps(_mm_andnot_ps(sign, z), ez)
+    );
+    outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+  }
+  return _mm_movemask_ps(outside) == 0;
+#else
+  for (int i = 0; i != kPlanes; ++i) {
+    auto distance = x_[i] * center.x + y_[i] * center.y + z_[i] * center.z + w_[i];
+    auto radius = std::abs(x_[i]) * extent.x + std::abs(y_[i]) * extent.y + std::abs(z_[i]) * extent.z;
+    if (distance + radius < 0) {
+      return false;
+    }
+  }
+  return true;
+#endif
+}
@@ -0,0 +1,37 @@
+#pragma once
+#ifndef VKMC_RENDER_FRUSTUM_H_
+#define VKMC_RENDER_FRUSTUM_H_
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+/// The six clip planes of a view projection matrix, for culling boxes
+/// before drawing. The planes are stored by component so a box is tested
+/// against four planes at once with SSE.
+class Frustum {
+public:
+  /// Extract the planes of a matrix projecting to 0 <= z <= w
+  explicit Frustum(const glm::mat4 &view_projection) noexcept;
+
+  /// Whether any part of the axis aligned box may be visible.
+  /// Boxes near a frustum corner may be reported visible conservatively.
+  [[nodiscard]] bool IsBoxVisible(const glm::vec3 &min, const glm::vec3 &max) const noexcept;
+
+  /// The plane of index 0 to 5: left, right, bottom, top, near and far.
+  /// A point p is on the inner side if dot(plane.xyz, p) + plane.w >= 0.
+  [[nodiscard]] glm::vec4 GetPlane(int index) const noexcept {
+    return {x_[index], y_[index], z_[index], w_[index]};
+  }
+
+private:
+  /// Six planes and two padding planes which accept everything
+  static constexpr int kPlanes = 8;
+
+  alignas(16) float x_[kPlanes];
+  alignas(16) float y_[kPlanes];
+  alignas(16) float z_[kPlanes];
+  alignas(16) float w_[kPlanes];
+};
+
+#endif // VKMC_RENDER_FRUSTUM_H_
@@ -0,0 +1,43 @@
+#include <algorithm>
+#include <tuple>
+
+#include "indirect.h"
+
+void IndirectDrawList::Clear() noexcept {
+  draws_.clear();
+  commands_.clear();
+  batches_.clear();
+}
+
+void IndirectDrawList::Add(std::uint32_t page, std::uint32_t offset, std::uint32_t count) {
+  if (count != 0) {
+    draws_.push_back({.page = page, .offset = offset, .count = count});
+  }
+}
+
+void IndirectDrawList::Build() {
+  std::ranges::sort(draws_, [](const Draw &a, const Draw &b) {
+    return std::tie(a.page, a.offset) < std::tie(b.page, b.offset);
+  });
+
+  commands_.clear();
+  batches_.clear();
+  for (auto &draw : draws_) {
+    if (batches_.empty() || batches_.back().page != draw.page) {
+      batches_.push_back({.page = draw.page, .first = std::uint32_t(commands_.size()), .count = 0});
+    } else {
+      auto &last = commands_.back();
+      if (last.first_instance + last.instance_count == draw.offset) {
+        last.instance_count += draw.count;
+        continue;
+      }
+    }
+    commands_.push_back({
+        .vertex_count = vertex_count_,
+        .instance_count = draw.count,
+        .first_vertex = 0,
+        .first_instance = draw.offset,
+    });
+    ++batches_.back().count;
+  }
+}
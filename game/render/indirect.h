@@ -0,0 +1,69 @@
+#pragma once
+#ifndef VKMC_RENDER_INDIRECT_H_
+#define VKMC_RENDER_INDIRECT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// Same layout as VkDrawIndirectCommand
+struct DrawIndirectCommand {
+  std::uint32_t vertex_count;
+  std::uint32_t instance_count;
+  std::uint32_t first_vertex;
+  std::uint32_t first_instance;
+};
+
+static_assert(sizeof(DrawIndirectCommand) == 16);
+
+/// Builds the indirect draw commands of instanced meshes stored in pages,
+/// each page is a vertex buffer drawn by one multi draw. Meshes next to
+/// each other in a page are merged into one command.
+class IndirectDrawList {
+public:
+  /// The commands drawing one page, a range of GetCommands()
+  struct Batch {
+    std::uint32_t page;
+    std::uint32_t first;
+    std::uint32_t count;
+  };
+
+  explicit IndirectDrawList(std::uint32_t vertex_count) noexcept : vertex_count_(vertex_count) {}
+
+  void Clear() noexcept;
+
+  /// Queue a draw of count instances starting at offset in the page
+  void Add(std::uint32_t page, std::uint32_t offset, std::uint32_t count);
+
+  /// Sort the draws by page and offset, merge adjacent ones and make the
+  /// commands and batches
+  void Build();
+
+  [[nodiscard]] std::span<const DrawIndirectCommand> GetCommands() const noexcept {
+    return commands_;
+  }
+
+  [[nodiscard]] std::span<const Batch> GetBatches() const noexcept {
+    return batches_;
+  }
+
+  /// The number of draws added before merging
+  [[nodiscard]] std::size_t GetDrawCount() const noexcept {
+    return draws_.size();
+  }
+
+private:
+  struct Draw {
+    std::uint32_t page;
+    std::uint32_t offset;
+    std::uint32_t count;
+  };
+
+  std::uint32_t vertex_count_;
+  std::vector<Draw> draws_;
+  std::vector<DrawIndirectCommand> commands_;
+  std::vector<Batch> batches_;
+};
+
+#endif // VKMC_RENDER_INDIRECT_H_
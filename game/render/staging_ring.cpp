@@ -0,0 +1,48 @@
+#include "staging_ring.h"
+
+StagingRing::StagingRing(std::size_t capacity) noexcept
+    : capacity_(capacity), head_(0), tail_(0), used_(0), open_(0) {}
+
+std::size_t StagingRing::Allocate(std::size_t size, std::size_t alignment) noexcept {
+  if (used_ == 0) {
+    // Empty, restart from the front for the largest contiguous range
+    head_ = tail_ = 0;
+  } else if (used_ == capacity_) {
+    return kInvalidOffset;
+  }
+
+  auto offset = (head_ + alignment - 1) / alignment * alignment;
+  if (head_ >= tail_) {
+    // The free space is [head, capacity) and [0, tail)
+    if (offset + size > capacity_) {
+      if (size > tail_) {
+        return kInvalidOffset;
+      }
+      offset = 0;
+    }
+  } else if (offset + size > tail_) {
+    return kInvalidOffset;
+  }
+
+  // The skipped bytes stay in use until the allocation is reclaimed
+  auto consumed = offset >= head_ ? offset + size - head_ : capacity_ - head_ + size;
+  used_ += consumed;
+  open_ += consumed;
+  head_ = offset + size;
+  return offset;
+}
+
+void StagingRing::Submit(std::uint64_t serial) {
+  if (open_ != 0) {
+    batches_.push_back({.serial = serial, .end = head_, .size = open_});
+    open_ = 0;
+  }
+}
+
+void StagingRing::Retire(std::uint64_t serial) noexcept {
+  while (!batches_.empty() && batches_.front().serial <= serial) {
+    tail_ = batches_.front().end;
+    used_ -= batches_.front().size;
+    batches_.pop_front();
+  }
+}
@@ -0,0 +1,58 @@
+#pragma once
+#ifndef VKMC_RENDER_STAGING_RING_H_
+#define VKMC_RENDER_STAGING_RING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+/// Offset bookkeeping of a persistent upload buffer used as a ring. The
+/// allocations of a frame are closed with the serial of its submission and
+/// reclaimed once the submission is known to be finished, so the ring
+/// never waits on the GPU. An allocation never wraps around the end.
+class StagingRing {
+public:
+  static constexpr std::size_t kInvalidOffset = ~std::size_t(0);
+
+  explicit StagingRing(std::size_t capacity) noexcept;
+
+  /// Allocate a contiguous range, returns kInvalidOffset if the ring has
+  /// no room until older submissions are retired
+  [[nodiscard]] std::size_t Allocate(std::size_t size, std::size_t alignment = 16) noexcept;
+
+  /// Close the allocations made since the last call, they are read by the
+  /// submission with the serial
+  void Submit(std::uint64_t serial);
+
+  /// Reclaim the allocations of all submissions up to the serial
+  void Retire(std::uint64_t serial) noexcept;
+
+  [[nodiscard]] std::size_t GetCapacity() const noexcept {
+    return capacity_;
+  }
+
+  /// The number of bytes not reclaimed yet, including alignment padding
+  [[nodiscard]] std::size_t GetUsedSize() const noexcept {
+    return used_;
+  }
+
+private:
+  struct Batch {
+    std::uint64_t serial;
+    /// The head when the batch was closed
+    std::size_t end;
+    std::size_t size;
+  };
+
+  std::size_t capacity_;
+  /// The end of the latest allocation
+  std::size_t head_;
+  /// The start of the oldest allocation not reclaimed
+  std::size_t tail_;
+  std::size_t used_;
+  /// The bytes allocated since the last submit
+  std::size_t open_;
+  std::deque<Batch> batches_;
+};
+
+#endif // VKMC_RENDER_STAGING_RING_H_
@@ -1,10 +1,21 @@
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <limits>
 #include <ranges>
+#include <sstream>
 #include <string_view>
+#include <tuple>
+#include <unordered_map>
 
+#include <glm/geometric.hpp>
 #include <glm/mat4x4.hpp>
 
+#include <assets/json.h>
 #include <assets/load.h>
 #include <assets/shader.h>
 #include <event.h>
@@ -32,6 +43,23 @@ static vk::SurfaceFormatKHR ChooseVkSurfaceFormat(
   return it != available.end() ? prefer : available.front();
 }
 
+/// The vertex attributes of FaceInstance, the locations are assigned by the pipeline
+static std::span<const vk::VertexInputAttributeDescription> GetFaceInputAttributes() noexcept {
+  static auto attributes = std::array{
+      // packed:
+      vk::VertexInputAttributeDescription{
+          .format = vk::Format::eR32Uint,
+          .offset = offsetof(FaceInstance, packed),
+      },
+      // texture_slot:
+      vk::VertexInputAttributeDescription{
+          .format = vk::Format::eR32Uint,
+          .offset = offsetof(FaceInstance, texture_slot),
+      },
+  };
+  return attributes;
+}
+
 static vk::Extent2D ChooseVkExtent(
     std::uint32_t width, std::uint32_t height,
     const vk::SurfaceCapabilitiesKHR &capabilities
@@ -51,10 +79,40 @@ static vk::Extent2D ChooseVkExtent(
 
 Renderer::Renderer(
     const ChunkManager &chunk_manager,
-    const BlockRegistry &block_registry
-) : chunk_manager_(chunk_manager),
+    const BlockRegistry &block_registry,
+    WorkerPool &workers
+) : current_frame_(0),
+    chunk_manager_(chunk_manager),
+    staging_(kStagingRingSize),
+    submit_serial_(0),
+    next_chunk_slot_(0),
     block_registry_(block_registry),
-    current_frame_(0) {
+    workers_(workers),
+    mesher_(block_registry),
+    meshing_mode_(MeshingMode::kPerFace),
+    mesh_version_(0),
+    meshing_(0),
+    report_mesh_stats_(false),
+    cull_stats_{},
+    draw_list_(4),
+    frame_time_(0) {
+  {
+    auto &config = assets::LoadJson("config.json");
+    auto &render = config["render"];
+    if (render.value("mesher", "face") == "greedy") {
+      meshing_mode_ = MeshingMode::kGreedy;
+    }
+    upload_budget_ = render.value("upload_budget", std::size_t(4096)) << 10;
+    // The culled commands keep their section offsets in first instance
+    gpu_culling_ = render.value("gpu_culling", false) &&
+                   vulkan::GetEnabledFeatures().drawIndirectFirstInstance;
+    assets::Unload("config.json");
+  }
+
+  if (block_registry_.GetTextureCount() > FaceInstance::kMaxTextures) {
+    throw std::runtime_error("Too many block textures to pack in faces!");
+  }
+
   graphics_queue_ = vulkan::device.getQueue(vulkan::GetGraphicsQueue(), 0);
   present_queue_ = vulkan::device.getQueue(vulkan::GetPresentQueue(), 0);
 
@@ -82,12 +140,18 @@ Renderer::Renderer(
   CreateCommandPool();
   CreateCommandBuffers();
   CreateUniformBuffers();
+  CreateStagingBuffer();
+  CreateSectionOriginBuffer();
   CreateDescriptorPool();
   CreateTextureImage();
   CreateTextureImageView();
   CreateTextureSampler();
   CreateDescriptorSet();
 
+  if (gpu_culling_) {
+    CreateCullPipeline();
+  }
+
   CreateSyncObjects();
 
   SubscribeInScope(
@@ -101,6 +165,8 @@ Renderer::Renderer(
       events::global, events::kChunkLoaded, this,
       +[](Renderer *renderer, ChunkId chunk, const Chunk *c) {
         renderer->GenerateChunkResources(chunk, c);
+        // Border faces of the neighbours may be hidden by the new chunk
+        renderer->RegenerateNeighborChunkMeshes(chunk);
       }
   );
 
@@ -108,14 +174,14 @@ Renderer::Renderer(
       events::global, events::kChunkUnloaded, this,
       +[](Renderer *renderer, ChunkId chunk) {
         renderer->ReleaseChunkResources(chunk);
+        renderer->RegenerateNeighborChunkMeshes(chunk);
       }
   );
 
   SubscribeInScope(
       events::global, events::kChunkUpdate, this,
-      +[](Renderer *renderer, ChunkId chunk, const Chunk *c) {
-        renderer->ReleaseChunkResources(chunk);
-        renderer->GenerateChunkResources(chunk, c);
+      +[](Renderer *renderer, ChunkId chunk, const Chunk *c, glm::ivec3 position) {
+        renderer->RegenerateBlockMeshes(chunk, position);
       }
   );
 
@@ -346,7 +412,14 @@ void Renderer::CreatePipelineLayout() {
       .stageFlags = vk::ShaderStageFlagBits::eFragment,
   };
 
-  auto bindings = std::array{ubo, texture};
+  vk::DescriptorSetLayoutBinding origins{
+      .binding = 2,
+      .descriptorType = vk::DescriptorType::eStorageBuffer,
+      .descriptorCount = 1,
+      .stageFlags = vk::ShaderStageFlagBits::eVertex,
+  };
+
+  auto bindings = std::array{ubo, texture, origins};
 
   vk::DescriptorSetLayoutCreateInfo desc_ci{
       .bindingCount = bindings.size(),
@@ -401,7 +474,7 @@ void Renderer::CreatePipeline() {
   std::vector<vk::VertexInputAttributeDescription> attributes;
   {
     std::uint32_t location = 0;
-    auto face_attributes = FaceInstance::GetInputAttributes();
+    auto face_attributes = GetFaceInputAttributes();
     for (auto &attr : face_attributes) {
       attributes.emplace_back(attr);
       attributes.back().location = location++;
@@ -551,7 +624,12 @@ void Renderer::CreateDescriptorPool() {
       .descriptorCount = kMaxFramesInFlight,
   };
 
-  auto sizes = std::array{mvp_size, texture_size};
+  vk::DescriptorPoolSize origins_size{
+      .type = vk::DescriptorType::eStorageBuffer,
+      .descriptorCount = kMaxFramesInFlight,
+  };
+
+  auto sizes = std::array{mvp_size, texture_size, origins_size};
 
   vk::DescriptorPoolCreateInfo pool_ci{
       .maxSets = kMaxFramesInFlight,
@@ -561,27 +639,46 @@ void Renderer::CreateDescriptorPool() {
   descriptor_pool_ = vulkan::device.createDescriptorPool(pool_ci);
 }
 
-MappingBuffer Renderer::CreateChunkMeshBufferForCPU() {
-  MappingBuffer mapping_buffer;
+void Renderer::CreateStagingBuffer() {
   auto buffer = CreateBuffer(
-      kChunkBufferSize, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferSrc,
+      kStagingRingSize, vk::BufferUsageFlagBits::eTransferSrc,
       vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
   );
 
-  mapping_buffer.buffer = buffer.buffer;
-  mapping_buffer.memory = buffer.memory;
-  mapping_buffer.mapping = vulkan::device.mapMemory(buffer.memory, 0, kChunkBufferSize);
+  staging_buffer_.buffer = buffer.buffer;
+  staging_buffer_.memory = buffer.memory;
+  staging_buffer_.mapping = vulkan::device.mapMemory(buffer.memory, 0, kStagingRingSize);
+}
+
+void Renderer::CreateSectionOriginBuffer() {
+  auto size = kMaxChunkSlots * Chunk::kSections * sizeof(glm::ivec4);
+  auto buffer = CreateBuffer(
+      size, vk::BufferUsageFlagBits::eStorageBuffer,
+      vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+  );
 
-  return mapping_buffer;
+  section_origins_.buffer = buffer.buffer;
+  section_origins_.memory = buffer.memory;
+  section_origins_.mapping = vulkan::device.mapMemory(buffer.memory, 0, size);
 }
 
-Buffer Renderer::CreateChunkMeshBufferForGPU() {
+Buffer Renderer::CreateChunkPageBuffer() {
   return CreateBuffer(
-      kChunkBufferSize, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+      kChunkPageFaces * sizeof(FaceInstance),
+      vk::BufferUsageFlagBits::eVertexBuffer |
+          vk::BufferUsageFlagBits::eTransferSrc |
+          vk::BufferUsageFlagBits::eTransferDst,
       vk::MemoryPropertyFlagBits::eDeviceLocal
   );
 }
 
+void Renderer::CreateChunkPage() {
+  chunk_pages_.push_back({
+      .allocator = ArenaAllocator(kChunkPageFaces),
+      .buffer = CreateChunkPageBuffer(),
+  });
+}
+
 Image Renderer::CreateImage(
     std::uint32_t width,
     std::uint32_t height,
@@ -760,7 +857,20 @@ void Renderer::CreateDescriptorSet() {
         .pImageInfo = &texture_img_info,
     };
 
-    vulkan::device.updateDescriptorSets({mvp_write, texture_write}, {});
+    vk::DescriptorBufferInfo origins_buf_info{
+        .buffer = section_origins_.buffer,
+        .range = VK_WHOLE_SIZE,
+    };
+    vk::WriteDescriptorSet origins_write{
+        .dstSet = frame.descriptor_set,
+        .dstBinding = 2,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = vk::DescriptorType::eStorageBuffer,
+        .pBufferInfo = &origins_buf_info,
+    };
+
+    vulkan::device.updateDescriptorSets({mvp_write, texture_write, origins_write}, {});
   }
 }
 
@@ -780,6 +890,9 @@ void Renderer::CreateSyncObjects() {
     frame.image_available_semaphore = vulkan::device.createSemaphore({});
     frame.render_finished_semaphore = vulkan::device.createSemaphore({});
     frame.flight_fence = vulkan::device.createFence(fence_ci);
+    frame.serial = 0;
+    frame.indirect_capacity = 0;
+    frame.cull_capacity = 0;
   }
 }
 
@@ -797,105 +910,406 @@ void Renderer::CreateCommandBuffers() {
   }
 }
 
-void Renderer::GenerateChunkResources(ChunkId chunk_id, const Chunk *chunk) {
-  std::uint32_t index;
-  if (free_chunk_buffer_index_.size()) {
-    index = free_chunk_buffer_index_.front();
-    free_chunk_buffer_index_.pop();
-    for (auto &frame : frames_) {
-      frame.chunk_buffer[index].second = true;
+void Renderer::AllocateSectionMesh(SectionMesh &mesh, std::uint32_t n_face) {
+  ReleaseSectionMesh(mesh);
+
+  std::uint32_t page = 0;
+  std::size_t offset = ArenaAllocator::kInvalidOffset;
+  for (; page != chunk_pages_.size(); ++page) {
+    auto &allocator = chunk_pages_[page].allocator;
+    if (allocator.IsFragmentedFor(n_face)) {
+      DefragmentChunkPage(page);
     }
-  } else {
-    index = chunk_buffer_.size();
-    chunk_buffer_.emplace_back(CreateChunkMeshBufferForCPU());
-    for (auto &frame : frames_) {
-      frame.chunk_buffer.emplace_back(CreateChunkMeshBufferForGPU(), true);
+    offset = allocator.Allocate(n_face);
+    if (offset != ArenaAllocator::kInvalidOffset) {
+      break;
     }
   }
-  auto &info = chunks_[*reinterpret_cast<std::uint64_t *>(&chunk_id)] = {
-      .index = index,
-  };
-  GenerateChunkMesh(chunk_id, chunk, info);
+
+  if (offset == ArenaAllocator::kInvalidOffset) {
+    CreateChunkPage();
+    offset = chunk_pages_.back().allocator.Allocate(n_face);
+  }
+
+  mesh.page = page;
+  mesh.offset = offset;
+  mesh.n_face = n_face;
+}
+
+void Renderer::ReleaseSectionMesh(SectionMesh &mesh) {
+  if (mesh.page != kNoPage) {
+    chunk_pages_[mesh.page].allocator.Free(mesh.offset);
+    mesh.page = kNoPage;
+  }
+  mesh.n_face = 0;
 }
 
-void Renderer::GenerateChunkMesh(ChunkId chunk_id, const Chunk *pointer, ChunkInfo &info) {
-  info.chunk = pointer;
-  auto &chunk = *pointer;
-  std::uint32_t index = 0;
+void Renderer::DefragmentChunkPage(std::uint32_t page) {
+  auto moves = chunk_pages_[page].allocator.Defragment();
+  if (moves.empty()) {
+    return;
+  }
+
+  std::unordered_map<std::uint32_t, std::uint32_t> moved;
+  for (auto &move : moves) {
+    moved.emplace(move.src, move.dst);
+  }
+
+  std::vector<vk::BufferCopy> copies;
+  for (auto &info : chunks_ | std::views::values) {
+    for (auto &mesh : info.sections) {
+      if (mesh.page != page) {
+        continue;
+      }
+      auto it = moved.find(mesh.offset);
+      auto offset = it != moved.end() ? it->second : mesh.offset;
+      copies.push_back({
+          .srcOffset = mesh.offset * sizeof(FaceInstance),
+          .dstOffset = offset * sizeof(FaceInstance),
+          .size = mesh.n_face * sizeof(FaceInstance),
+      });
+      mesh.offset = offset;
+    }
+  }
+
+  // Ranges of a buffer can not be copied onto themselves, so the page is
+  // packed into a new buffer. Frames in flight still draw from the old
+  // one, it is destroyed after this frame is finished.
+  auto &buffer = chunk_pages_[page].buffer;
+  auto new_buffer = CreateChunkPageBuffer();
+  for (auto &copy : copies) {
+    uploads_.push_back({
+        .src = buffer.buffer,
+        .dst = new_buffer.buffer,
+        .region = copy,
+        .barrier = &copy == &copies.front(),
+    });
+  }
+  retired_buffers_.emplace_back(submit_serial_, buffer);
+  buffer = new_buffer;
+}
 
-  auto faces = reinterpret_cast<FaceInstance *>(chunk_buffer_[info.index].mapping);
-  auto faces_begin = faces;
+bool Renderer::UploadSectionMesh(SectionMesh &mesh, const std::vector<FaceInstance> &faces) {
+  auto size = faces.size() * sizeof(FaceInstance);
+  auto staging = staging_.Allocate(size);
+  if (staging == StagingRing::kInvalidOffset) {
+    return false;
+  }
+  std::memcpy(static_cast<std::byte *>(staging_buffer_.mapping) + staging, faces.data(), size);
+
+  AllocateSectionMesh(mesh, faces.size());
+  uploads_.push_back({
+      .src = staging_buffer_.buffer,
+      .dst = chunk_pages_[mesh.page].buffer.buffer,
+      .region{
+          .srcOffset = staging,
+          .dstOffset = mesh.offset * sizeof(FaceInstance),
+          .size = size,
+      },
+      .barrier = false,
+  });
+  return true;
+}
 
-  auto offset = glm::ivec3(chunk_id.x * Chunk::kLength, 0, chunk_id.y * Chunk::kLength);
+void Renderer::RecordChunkUploads(vk::CommandBuffer cmd) {
+  if (uploads_.empty()) {
+    return;
+  }
 
-  auto add_face = [&](std::uint32_t block, FaceDirection dir, const glm::ivec3 &block_pos) {
-    auto texture_id = block_registry_.GetFaceTextureId(block, dir);
-    faces->face = dir;
-    faces->texture = texture_id;
-    faces->position = block_pos;
-    ++faces;
+  // Draws of the previous frames may still read the overwritten ranges
+  vk::MemoryBarrier before{
+      .dstAccessMask = vk::AccessFlagBits::eTransferWrite,
   };
+  cmd.pipelineBarrier(
+      vk::PipelineStageFlagBits::eVertexInput, vk::PipelineStageFlagBits::eTransfer,
+      {}, before, {}, {}
+  );
 
-  for (int y = 0; y != Chunk::kLength; ++y) {
-    for (int x = 0; x != Chunk::kLength; ++x) {
-      for (int z = 0; z != Chunk::kLength; ++z) {
-        auto block = chunk(x, y, z);
-        if (block == blocks::kAir) {
-          continue;
-        }
-        auto block_pos = glm::ivec3(x, y, z) + offset;
+  // Copies between barriers do not overlap, they are grouped by buffers
+  // so the copies between the same buffers are merged into one command
+  auto by_buffers = [](const ChunkUpload &a, const ChunkUpload &b) {
+    return std::tie(a.src, a.dst) < std::tie(b.src, b.dst);
+  };
+  std::vector<vk::BufferCopy> regions;
+  for (auto begin = uploads_.begin(); begin != uploads_.end();) {
+    if (begin->barrier) {
+      vk::MemoryBarrier transfer{
+          .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+          .dstAccessMask = vk::AccessFlagBits::eTransferRead,
+      };
+      cmd.pipelineBarrier(
+          vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer,
+          {}, transfer, {}, {}
+      );
+    }
 
-        add_face(block, FaceDirection::kNorth, block_pos);
-        add_face(block, FaceDirection::kSouth, block_pos);
-        add_face(block, FaceDirection::kWest, block_pos);
-        add_face(block, FaceDirection::kEast, block_pos);
-        add_face(block, FaceDirection::kTop, block_pos);
-        add_face(block, FaceDirection::kBottom, block_pos);
+    auto end = std::find_if(std::next(begin), uploads_.end(), [](auto &upload) { return upload.barrier; });
+    std::stable_sort(begin, end, by_buffers);
+    for (auto it = begin; it != end;) {
+      regions.clear();
+      auto first = it;
+      do {
+        regions.push_back(it->region);
+        ++it;
+      } while (it != end && it->src == first->src && it->dst == first->dst);
+      cmd.copyBuffer(first->src, first->dst, regions);
+    }
+    begin = end;
+  }
+  uploads_.clear();
 
-        /* if (chunk_manager_.GetBlock(block_pos + glm::ivec3(0, 0, 1)) == blocks::kAir) {
-          
-        }
+  vk::MemoryBarrier after{
+      .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+      .dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead,
+  };
+  cmd.pipelineBarrier(
+      vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eVertexInput,
+      {}, after, {}, {}
+  );
+}
 
-        if (chunk_manager_.GetBlock(block_pos + glm::ivec3(0, 0, -1)) == blocks::kAir) {
-          
-        }
+void Renderer::RetireSubmissions(std::uint64_t serial) {
+  staging_.Retire(serial);
+  std::erase_if(retired_buffers_, [serial](auto &retired) {
+    if (retired.first > serial) {
+      return false;
+    }
+    vulkan::device.destroyBuffer(retired.second.buffer);
+    vulkan::device.freeMemory(retired.second.memory);
+    return true;
+  });
+  std::erase_if(retired_chunk_slots_, [this, serial](auto &retired) {
+    if (retired.first > serial) {
+      return false;
+    }
+    free_chunk_slots_.push_back(retired.second);
+    return true;
+  });
+}
 
-        if (chunk_manager_.GetBlock(block_pos + glm::ivec3(1, 0, 0)) == blocks::kAir) {
-          
-        }
+std::uint32_t Renderer::AcquireChunkSlot(ChunkId chunk_id) {
+  std::uint32_t slot;
+  if (!free_chunk_slots_.empty()) {
+    slot = free_chunk_slots_.back();
+    free_chunk_slots_.pop_back();
+  } else if (next_chunk_slot_ != kMaxChunkSlots) {
+    slot = next_chunk_slot_++;
+  } else {
+    throw std::runtime_error("Too many chunks for the section origin table!");
+  }
 
-        if (chunk_manager_.GetBlock(block_pos + glm::ivec3(-1, 0, 0)) == blocks::kAir) {
-          
-        }
+  constexpr int n = ChunkSection::kLength;
+  auto origins = static_cast<glm::ivec4 *>(section_origins_.mapping) + slot * Chunk::kSections;
+  for (std::uint32_t section = 0; section != Chunk::kSections; ++section) {
+    origins[section] = {chunk_id.x * n, int(section) * n, chunk_id.y * n, 0};
+  }
+  return slot;
+}
 
-        if (chunk_manager_.GetBlock(block_pos + glm::ivec3(0, 1, 0)) == blocks::kAir) {
-          
-        }
+void Renderer::GenerateChunkResources(ChunkId chunk_id, const Chunk *chunk) {
+  // Arena space is allocated when the section meshes come back from
+  // workers, sections without any face take no space
+  auto &info = chunks_[*reinterpret_cast<std::uint64_t *>(&chunk_id)];
+  info.chunk = chunk;
+  info.sections.fill({.page = kNoPage, .offset = 0, .n_face = 0, .version = 0});
+  info.slot = AcquireChunkSlot(chunk_id);
+  RegenerateChunkMesh(chunk_id);
+}
+
+void Renderer::GenerateSectionMesh(ChunkId chunk_id, std::uint32_t section, ChunkInfo &info) {
+  auto &mesh = info.sections[section];
+  mesh.version = ++mesh_version_;
+
+  // The sky costs nothing, no snapshot and no job
+  auto &blocks = info.chunk->GetSection(section);
+  if (blocks.IsUniform() && blocks.GetUniformBlock() == blocks::kAir) {
+    ReleaseSectionMesh(mesh);
+    return;
+  }
+
+  // Workers read a snapshot, the chunks may be modified on the main thread
+  // while meshing. Border faces are culled against the neighbours' slabs.
+  auto input = std::make_shared<ChunkMeshInput>();
+  input->Capture(
+      chunk_id, section, *info.chunk,
+      chunk_manager_.GetChunk({chunk_id.x, chunk_id.y + 1}),
+      chunk_manager_.GetChunk({chunk_id.x, chunk_id.y - 1}),
+      chunk_manager_.GetChunk({chunk_id.x + 1, chunk_id.y}),
+      chunk_manager_.GetChunk({chunk_id.x - 1, chunk_id.y})
+  );
+  input->slot = info.slot * Chunk::kSections + section;
+
+  ++meshing_;
+  workers_.Submit([this, input, mode = meshing_mode_, version = mesh.version] {
+    thread_local std::vector<FaceInstance> faces(ChunkMesher::kMaxFaces);
+    auto n_face = mesher_.Generate(mode, *input, faces.data());
+
+    ChunkMeshResult result{
+        .chunk = input->id,
+        .section = input->section,
+        .version = version,
+        .faces = {faces.begin(), faces.begin() + n_face},
+    };
+    std::lock_guard lock(meshed_mutex_);
+    meshed_.emplace_back(std::move(result));
+  });
+}
+
+void Renderer::IntegrateChunkMeshes(const glm::vec3 &position) {
+  for (auto [key, section] : dirty_meshes_) {
+    auto it = chunks_.find(key);
+    if (it != chunks_.end()) {
+      GenerateSectionMesh(*reinterpret_cast<const ChunkId *>(&key), section, it->second);
+    }
+  }
+  dirty_meshes_.clear();
 
-        if (chunk_manager_.GetBlock(block_pos + glm::ivec3(0, -1, 0)) == blocks::kAir) {
-          
-        } */
+  {
+    std::lock_guard lock(meshed_mutex_);
+    meshing_ -= meshed_.size();
+    std::ranges::move(meshed_, std::back_inserter(unstaged_meshes_));
+    meshed_.clear();
+  }
+
+  // Drop the meshes of unloaded or remeshed sections, empty meshes need
+  // no upload
+  std::erase_if(unstaged_meshes_, [this](const ChunkMeshResult &result) {
+    auto mesh = FindSectionMesh(result.chunk, result.section);
+    if (mesh == nullptr || mesh->version != result.version) {
+      return true;
+    }
+    if (result.faces.empty()) {
+      ReleaseSectionMesh(*mesh);
+      return true;
+    }
+    return false;
+  });
+
+  // Upload the nearest sections first within the budget, the rest waits
+  // for the next frames. The first one always goes so a mesh larger than
+  // the budget is not starved.
+  std::ranges::sort(unstaged_meshes_, {}, [&position](const ChunkMeshResult &result) {
+    glm::vec3 center{
+        result.chunk.x * Chunk::kLength,
+        result.section * ChunkSection::kLength,
+        result.chunk.y * Chunk::kLength,
+    };
+    auto delta = center + ChunkSection::kLength * .5f - position;
+    return glm::dot(delta, delta);
+  });
+
+  std::size_t uploaded = 0;
+  auto it = unstaged_meshes_.begin();
+  for (; it != unstaged_meshes_.end(); ++it) {
+    auto size = it->faces.size() * sizeof(FaceInstance);
+    if (uploaded != 0 && uploaded + size > upload_budget_) {
+      break;
+    }
+    if (!UploadSectionMesh(*FindSectionMesh(it->chunk, it->section), it->faces)) {
+      break;
+    }
+    uploaded += size;
+  }
+  unstaged_meshes_.erase(unstaged_meshes_.begin(), it);
+
+  if (report_mesh_stats_ && meshing_ == 0 && unstaged_meshes_.empty()) {
+    report_mesh_stats_ = false;
+    std::size_t n_face = 0, n_section = 0;
+    for (auto &info : chunks_ | std::views::values) {
+      for (auto &mesh : info.sections) {
+        n_face += mesh.n_face;
+        n_section += mesh.n_face != 0;
       }
     }
+    // Release builds have no console, the window title shows the stats
+    std::ostringstream status;
+    status << (meshing_mode_ == MeshingMode::kGreedy ? "greedy" : "per face")
+           << " meshing, " << n_face << " faces in " << n_section << " sections of "
+           << chunks_.size() << " chunks, " << chunk_pages_.size() << " arena pages, "
+           << cull_stats_.drawn_sections << " sections drawn and "
+           << cull_stats_.culled_chunks << " chunks culled, "
+           << frame_time_ * 1000 << " ms per frame";
+    window::SetStatus(status.str());
+  }
+}
+
+Renderer::SectionMesh *Renderer::FindSectionMesh(ChunkId chunk_id, std::uint32_t section) {
+  auto it = chunks_.find(*reinterpret_cast<std::uint64_t *>(&chunk_id));
+  return it != chunks_.end() ? &it->second.sections[section] : nullptr;
+}
+
+void Renderer::RegenerateSectionMesh(ChunkId chunk_id, std::uint32_t section) {
+  auto key = *reinterpret_cast<std::uint64_t *>(&chunk_id);
+  if (section < Chunk::kSections && chunks_.contains(key)) {
+    dirty_meshes_.emplace(key, section);
+  }
+}
+
+void Renderer::RegenerateChunkMesh(ChunkId chunk_id) {
+  for (std::uint32_t section = 0; section != Chunk::kSections; ++section) {
+    RegenerateSectionMesh(chunk_id, section);
+  }
+}
+
+void Renderer::RegenerateBlockMeshes(ChunkId chunk_id, const glm::ivec3 &position) {
+  constexpr int last = Chunk::kLength - 1;
+
+  auto section = std::uint32_t(position.y) / Chunk::kLength;
+  RegenerateSectionMesh(chunk_id, section);
+
+  // The block may cover a face of the adjacent sections
+  auto y = position.y & last;
+  if (y == 0 && section != 0) {
+    RegenerateSectionMesh(chunk_id, section - 1);
+  }
+  if (y == last) {
+    RegenerateSectionMesh(chunk_id, section + 1);
   }
+  if (position.z == last) {
+    RegenerateSectionMesh({chunk_id.x, chunk_id.y + 1}, section);
+  }
+  if (position.z == 0) {
+    RegenerateSectionMesh({chunk_id.x, chunk_id.y - 1}, section);
+  }
+  if (position.x == last) {
+    RegenerateSectionMesh({chunk_id.x + 1, chunk_id.y}, section);
+  }
+  if (position.x == 0) {
+    RegenerateSectionMesh({chunk_id.x - 1, chunk_id.y}, section);
+  }
+}
+
+void Renderer::SetMeshingMode(MeshingMode mode) {
+  meshing_mode_ = mode;
+  for (auto key : chunks_ | std::views::keys) {
+    RegenerateChunkMesh(*reinterpret_cast<const ChunkId *>(&key));
+  }
+  report_mesh_stats_ = true;
+}
 
-  info.n_face = faces - faces_begin;
+void Renderer::RegenerateNeighborChunkMeshes(ChunkId chunk_id) {
+  RegenerateChunkMesh({chunk_id.x, chunk_id.y + 1});
+  RegenerateChunkMesh({chunk_id.x, chunk_id.y - 1});
+  RegenerateChunkMesh({chunk_id.x + 1, chunk_id.y});
+  RegenerateChunkMesh({chunk_id.x - 1, chunk_id.y});
 }
 
 void Renderer::ReleaseChunkResources(glm::ivec2 chunk_id) {
   auto it = chunks_.find(*reinterpret_cast<std::uint64_t *>(&chunk_id));
   if (it != chunks_.end()) {
-    free_chunk_buffer_index_.emplace(it->second.index);
+    for (auto &mesh : it->second.sections) {
+      ReleaseSectionMesh(mesh);
+    }
+    retired_chunk_slots_.emplace_back(submit_serial_, it->second.slot);
     chunks_.erase(it);
   }
 }
 
-void Renderer::UpdateUniformBuffer(const glm::vec3 &position, void *dst) {
-  auto &camera = *camera_;
-  new (dst) glm::mat4(camera.CreateProjectionMatrix() * camera.CreateViewMatrix(position));
+void Renderer::UpdateUniformBuffer(const glm::mat4 &view_projection, void *dst) {
+  new (dst) glm::mat4(view_projection);
 }
 
-void Renderer::RecordCommandBuffer(std::uint32_t image_id) {
+void Renderer::RecordCommandBuffer(std::uint32_t image_id, const Frustum &frustum) {
   auto &frame = frames_[current_frame_];
 
   auto cmd = frame.cmd;
@@ -904,6 +1318,12 @@ void Renderer::RecordCommandBuffer(std::uint32_t image_id) {
   vk::CommandBufferBeginInfo bi{};
   cmd.begin(bi);
 
+  RecordChunkUploads(cmd);
+
+  if (gpu_culling_) {
+    RecordCullDispatch(cmd, frame);
+  }
+
   auto c = std::array{.1875f, .3320f, .5352f, 1.f};
   vk::ClearValue color_clear{
       .color{c},
@@ -938,21 +1358,346 @@ void Renderer::RecordCommandBuffer(std::uint32_t image_id) {
   };
   cmd.pushConstants(pipeline_layout_, vk::ShaderStageFlagBits::eVertex, 0, sizeof(PushConstants), &push_constants);
   cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline_layout_, 0, frame.descriptor_set, {});
-  for (auto &chunk_info : chunks_ | std::views::values) {
-    auto chunk_buffer = frame.chunk_buffer[chunk_info.index].first.buffer;
-    cmd.bindVertexBuffers(0, {chunk_buffer}, {0});
-    cmd.draw(4, chunk_info.n_face, 0, 0);
+
+  if (gpu_culling_) {
+    RecordCulledChunkDraws(cmd, frame);
+    cmd.endRenderPass();
+    cmd.end();
+    return;
+  }
+
+  // Test the whole chunk first, most chunks are fully in or out.
+  // Visible sections are drawn together by the indirect draws of pages.
+  cull_stats_ = {};
+  for (auto &[key, chunk_info] : chunks_) {
+    auto &id = *reinterpret_cast<const ChunkId *>(&key);
+    glm::vec3 min{id.x * Chunk::kLength, 0, id.y * Chunk::kLength};
+    glm::vec3 max = min + glm::vec3(Chunk::kLength, Chunk::kHeight, Chunk::kLength);
+    if (!frustum.IsBoxVisible(min, max)) {
+      ++cull_stats_.culled_chunks;
+      continue;
+    }
+    ++cull_stats_.drawn_chunks;
+
+    for (std::uint32_t section = 0; section != Chunk::kSections; ++section) {
+      auto &mesh = chunk_info.sections[section];
+      if (mesh.n_face == 0) {
+        continue;
+      }
+      min.y = float(section * ChunkSection::kLength);
+      max.y = min.y + ChunkSection::kLength;
+      if (!frustum.IsBoxVisible(min, max)) {
+        ++cull_stats_.culled_sections;
+        continue;
+      }
+      ++cull_stats_.drawn_sections;
+      draw_list_.Add(mesh.page, mesh.offset, mesh.n_face);
+    }
   }
+
+  draw_list_.Build();
+  RecordChunkDraws(cmd, frame);
+  draw_list_.Clear();
   cmd.endRenderPass();
   cmd.end();
 }
 
+void Renderer::RecordChunkDraws(vk::CommandBuffer cmd, Frame &frame) {
+  auto &features = vulkan::GetEnabledFeatures();
+  auto commands = draw_list_.GetCommands();
+
+  // Without first instance the offset goes to the vertex buffer binding
+  if (!features.drawIndirectFirstInstance) {
+    for (auto &batch : draw_list_.GetBatches()) {
+      auto page = chunk_pages_[batch.page].buffer.buffer;
+      for (auto &command : commands.subspan(batch.first, batch.count)) {
+        cmd.bindVertexBuffers(0, {page}, {command.first_instance * sizeof(FaceInstance)});
+        cmd.draw(command.vertex_count, command.instance_count, 0, 0);
+      }
+    }
+    return;
+  }
+
+  if (frame.indirect_capacity < commands.size()) {
+    // The frame fence was waited, its old buffer is not in use
+    if (frame.indirect_capacity) {
+      vulkan::device.unmapMemory(frame.indirect_buffer.memory);
+      vulkan::device.destroyBuffer(frame.indirect_buffer.buffer);
+      vulkan::device.freeMemory(frame.indirect_buffer.memory);
+    }
+    frame.indirect_capacity = std::bit_ceil(std::max<std::size_t>(commands.size(), 1024));
+    auto size = frame.indirect_capacity * sizeof(DrawIndirectCommand);
+    auto buffer = CreateBuffer(
+        size, vk::BufferUsageFlagBits::eIndirectBuffer,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+    );
+    frame.indirect_buffer.buffer = buffer.buffer;
+    frame.indirect_buffer.memory = buffer.memory;
+    frame.indirect_buffer.mapping = vulkan::device.mapMemory(buffer.memory, 0, size);
+  }
+  std::ranges::copy(commands, static_cast<DrawIndirectCommand *>(frame.indirect_buffer.mapping));
+
+  constexpr auto stride = sizeof(DrawIndirectCommand);
+  for (auto &batch : draw_list_.GetBatches()) {
+    cmd.bindVertexBuffers(0, {chunk_pages_[batch.page].buffer.buffer}, {0});
+    if (features.multiDrawIndirect) {
+      cmd.drawIndirect(frame.indirect_buffer.buffer, batch.first * stride, batch.count, stride);
+    } else {
+      for (auto i = batch.first; i != batch.first + batch.count; ++i) {
+        cmd.drawIndirect(frame.indirect_buffer.buffer, i * stride, 1, stride);
+      }
+    }
+  }
+}
+
+void Renderer::CreateCullPipeline() {
+  auto binding = [](std::uint32_t binding, vk::DescriptorType type) {
+    return vk::DescriptorSetLayoutBinding{
+        .binding = binding,
+        .descriptorType = type,
+        .descriptorCount = 1,
+        .stageFlags = vk::ShaderStageFlagBits::eCompute,
+    };
+  };
+  auto bindings = std::array{
+      binding(0, vk::DescriptorType::eUniformBuffer),
+      binding(1, vk::DescriptorType::eStorageBuffer),
+      binding(2, vk::DescriptorType::eStorageBuffer),
+      binding(3, vk::DescriptorType::eStorageBuffer),
+  };
+  vk::DescriptorSetLayoutCreateInfo set_ci{
+      .bindingCount = bindings.size(),
+      .pBindings = bindings.data(),
+  };
+  cull_set_layout_ = vulkan::device.createDescriptorSetLayout(set_ci);
+
+  vk::PushConstantRange push_constants{
+      .stageFlags = vk::ShaderStageFlagBits::eCompute,
+      .size = sizeof(std::uint32_t),
+  };
+  vk::PipelineLayoutCreateInfo layout_ci{
+      .setLayoutCount = 1,
+      .pSetLayouts = &cull_set_layout_,
+      .pushConstantRangeCount = 1,
+      .pPushConstantRanges = &push_constants,
+  };
+  cull_pipeline_layout_ = vulkan::device.createPipelineLayout(layout_ci);
+
+  auto shader = assets::LoadShader("shaders/cull.comp.spv");
+  vk::ComputePipelineCreateInfo ci{
+      .stage{
+          .stage = vk::ShaderStageFlagBits::eCompute,
+          .module = shader,
+          .pName = "main",
+      },
+      .layout = cull_pipeline_layout_,
+  };
+  auto result = vulkan::device.createComputePipeline({}, ci);
+  if (result.result != vk::Result::eSuccess) {
+    throw std::runtime_error("Failed to create culling pipeline!");
+  }
+  cull_pipeline_ = result.value;
+  assets::Unload("shaders/cull.comp.spv");
+
+  vk::DescriptorPoolSize ubo_size{
+      .type = vk::DescriptorType::eUniformBuffer,
+      .descriptorCount = kMaxFramesInFlight,
+  };
+  vk::DescriptorPoolSize storage_size{
+      .type = vk::DescriptorType::eStorageBuffer,
+      .descriptorCount = 3 * kMaxFramesInFlight,
+  };
+  auto sizes = std::array{ubo_size, storage_size};
+  vk::DescriptorPoolCreateInfo pool_ci{
+      .maxSets = kMaxFramesInFlight,
+      .poolSizeCount = sizes.size(),
+      .pPoolSizes = sizes.data(),
+  };
+  cull_descriptor_pool_ = vulkan::device.createDescriptorPool(pool_ci);
+
+  std::vector<vk::DescriptorSetLayout> layouts(kMaxFramesInFlight, cull_set_layout_);
+  vk::DescriptorSetAllocateInfo ai{
+      .descriptorPool = cull_descriptor_pool_,
+      .descriptorSetCount = std::uint32_t(layouts.size()),
+      .pSetLayouts = layouts.data(),
+  };
+  auto sets = vulkan::device.allocateDescriptorSets(ai);
+  for (std::uint32_t i = 0; i != kMaxFramesInFlight; ++i) {
+    frames_[i].cull_descriptor_set = sets[i];
+  }
+}
+
+void Renderer::ReserveCullBuffers(Frame &frame, std::size_t count) {
+  if (count <= frame.cull_capacity) {
+    return;
+  }
+  // The frame fence was waited, its old buffers are not in use
+  if (frame.cull_capacity) {
+    DestroyCullBuffers(frame);
+  }
+  frame.cull_capacity = std::bit_ceil(std::max<std::size_t>(count, 1024));
+
+  auto candidates_size = frame.cull_capacity * sizeof(CullCandidate);
+  auto commands_size = frame.cull_capacity * sizeof(DrawIndirectCommand);
+  // Pages never outnumber the candidates
+  auto counters_size = frame.cull_capacity * sizeof(std::uint32_t);
+
+  auto candidates = CreateBuffer(
+      candidates_size, vk::BufferUsageFlagBits::eStorageBuffer,
+      vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+  );
+  frame.cull_candidates.buffer = candidates.buffer;
+  frame.cull_candidates.memory = candidates.memory;
+  frame.cull_candidates.mapping = vulkan::device.mapMemory(candidates.memory, 0, candidates_size);
+  frame.cull_commands = CreateBuffer(
+      commands_size,
+      vk::BufferUsageFlagBits::eStorageBuffer |
+          vk::BufferUsageFlagBits::eIndirectBuffer |
+          vk::BufferUsageFlagBits::eTransferDst,
+      vk::MemoryPropertyFlagBits::eDeviceLocal
+  );
+  frame.cull_counters = CreateBuffer(
+      counters_size,
+      vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+      vk::MemoryPropertyFlagBits::eDeviceLocal
+  );
+
+  vk::DescriptorBufferInfo ubo_info{
+      .buffer = frame.uniform_buffer.buffer,
+      .range = sizeof(glm::mat4),
+  };
+  vk::DescriptorBufferInfo storage_infos[]{
+      {.buffer = frame.cull_candidates.buffer, .range = candidates_size},
+      {.buffer = frame.cull_commands.buffer, .range = commands_size},
+      {.buffer = frame.cull_counters.buffer, .range = counters_size},
+  };
+  vk::WriteDescriptorSet ubo_write{
+      .dstSet = frame.cull_descriptor_set,
+      .dstBinding = 0,
+      .descriptorCount = 1,
+      .descriptorType = vk::DescriptorType::eUniformBuffer,
+      .pBufferInfo = &ubo_info,
+  };
+  vk::WriteDescriptorSet storage_write{
+      .dstSet = frame.cull_descriptor_set,
+      .dstBinding = 1,
+      .descriptorCount = 3,
+      .descriptorType = vk::DescriptorType::eStorageBuffer,
+      .pBufferInfo = storage_infos,
+  };
+  vulkan::device.updateDescriptorSets({ubo_write, storage_write}, {});
+}
+
+void Renderer::DestroyCullBuffers(Frame &frame) {
+  vulkan::device.unmapMemory(frame.cull_candidates.memory);
+  for (auto &buffer : {Buffer(frame.cull_candidates), frame.cull_commands, frame.cull_counters}) {
+    vulkan::device.destroyBuffer(buffer.buffer);
+    vulkan::device.freeMemory(buffer.memory);
+  }
+}
+
+void Renderer::RecordCullDispatch(vk::CommandBuffer cmd, Frame &frame) {
+  // Every section with faces is a candidate, grouped by page so the
+  // visible ones of a page are compacted to one range of commands
+  cull_candidates_.clear();
+  for (auto &[key, chunk_info] : chunks_) {
+    auto &id = *reinterpret_cast<const ChunkId *>(&key);
+    for (std::uint32_t section = 0; section != Chunk::kSections; ++section) {
+      auto &mesh = chunk_info.sections[section];
+      if (mesh.n_face == 0) {
+        continue;
+      }
+      glm::vec3 min{id.x * Chunk::kLength, section * ChunkSection::kLength, id.y * Chunk::kLength};
+      cull_candidates_.push_back({
+          .min{min, 1},
+          .max{min + float(ChunkSection::kLength), 1},
+          .command{
+              .vertex_count = 4,
+              .instance_count = mesh.n_face,
+              .first_vertex = 0,
+              .first_instance = mesh.offset,
+          },
+          .page = mesh.page,
+      });
+    }
+  }
+  std::ranges::stable_sort(cull_candidates_, {}, &CullCandidate::page);
+
+  cull_batches_.clear();
+  for (std::uint32_t i = 0; i != cull_candidates_.size(); ++i) {
+    auto &candidate = cull_candidates_[i];
+    if (cull_batches_.empty() || cull_batches_.back().page != candidate.page) {
+      cull_batches_.push_back({.page = candidate.page, .first = i, .count = 0});
+    }
+    ++cull_batches_.back().count;
+    candidate.output_base = cull_batches_.back().first;
+    // Counters are indexed by batch, pages without sections have none
+    candidate.page = cull_batches_.size() - 1;
+  }
+
+  if (cull_candidates_.empty()) {
+    return;
+  }
+  ReserveCullBuffers(frame, cull_candidates_.size());
+  std::ranges::copy(cull_candidates_, static_cast<CullCandidate *>(frame.cull_candidates.mapping));
+
+  // Culled commands are left with zero instances
+  cmd.fillBuffer(frame.cull_commands.buffer, 0, VK_WHOLE_SIZE, 0);
+  cmd.fillBuffer(frame.cull_counters.buffer, 0, VK_WHOLE_SIZE, 0);
+  vk::MemoryBarrier cleared{
+      .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+      .dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+  };
+  cmd.pipelineBarrier(
+      vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader,
+      {}, cleared, {}, {}
+  );
+
+  std::uint32_t count = cull_candidates_.size();
+  cmd.bindPipeline(vk::PipelineBindPoint::eCompute, cull_pipeline_);
+  cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, cull_pipeline_layout_, 0, frame.cull_descriptor_set, {});
+  cmd.pushConstants(cull_pipeline_layout_, vk::ShaderStageFlagBits::eCompute, 0, sizeof(count), &count);
+  cmd.dispatch((count + 63) / 64, 1, 1);
+
+  vk::MemoryBarrier culled{
+      .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+      .dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead,
+  };
+  cmd.pipelineBarrier(
+      vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eDrawIndirect,
+      {}, culled, {}, {}
+  );
+}
+
+void Renderer::RecordCulledChunkDraws(vk::CommandBuffer cmd, Frame &frame) {
+  auto multi_draw = vulkan::GetEnabledFeatures().multiDrawIndirect;
+  constexpr auto stride = sizeof(DrawIndirectCommand);
+  for (auto &batch : cull_batches_) {
+    cmd.bindVertexBuffers(0, {chunk_pages_[batch.page].buffer.buffer}, {0});
+    if (multi_draw) {
+      cmd.drawIndirect(frame.cull_commands.buffer, batch.first * stride, batch.count, stride);
+    } else {
+      for (auto i = batch.first; i != batch.first + batch.count; ++i) {
+        cmd.drawIndirect(frame.cull_commands.buffer, i * stride, 1, stride);
+      }
+    }
+  }
+}
+
 void Renderer::Render(const glm::vec3 &position) {
   // Is required to draw?
   if (extent_.width * extent_.height == 0) {
     return;
   }
 
+  // Exponential moving average of the frame time
+  {
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<float> delta = now - last_frame_;
+    frame_time_ = frame_time_ * .95f + delta.count() * .05f;
+    last_frame_ = now;
+  }
+
   auto &frame = frames_[current_frame_];
 
   // Wait the frame will to draw
@@ -964,6 +1709,10 @@ void Renderer::Render(const glm::vec3 &position) {
     vulkan::device.resetFences(frame.flight_fence);
   }
 
+  // All submissions up to the last one of the frame are finished
+  RetireSubmissions(frame.serial);
+  frame.serial = ++submit_serial_;
+
   // Acquire next image from swapchain
   std::uint32_t image_index;
   {
@@ -974,27 +1723,12 @@ void Renderer::Render(const glm::vec3 &position) {
     image_index = index.value;
   }
 
-  UpdateUniformBuffer(position, frame.uniform_buffer.mapping);
+  auto view_projection = camera_->CreateProjectionMatrix() * camera_->CreateViewMatrix(position);
+  UpdateUniformBuffer(view_projection, frame.uniform_buffer.mapping);
 
-  vku::OneTimeSubmit(
-      vulkan::device, cmd_pool_, [&](vk::CommandBuffer cmd) {
-        for (auto &chunk_info : chunks_ | std::views::values) {
-          auto &[gpu_buffer, invalidate] = frame.chunk_buffer[chunk_info.index];
-          if (invalidate) {
-            invalidate = false;
-            vk::BufferCopy copy{.size = chunk_info.n_face * sizeof(FaceInstance)};
-            cmd.copyBuffer(
-                chunk_buffer_[chunk_info.index].buffer,
-                gpu_buffer.buffer,
-                copy
-            );
-          }
-        }
-      },
-      graphics_queue_
-  );
+  IntegrateChunkMeshes(position);
 
-  RecordCommandBuffer(image_index);
+  RecordCommandBuffer(image_index, Frustum(view_projection));
 
   vk::PipelineStageFlags stages[]{vk::PipelineStageFlagBits::eColorAttachmentOutput};
   vk::SubmitInfo submit{
@@ -1007,6 +1741,7 @@ void Renderer::Render(const glm::vec3 &position) {
       .pSignalSemaphores = &frame.render_finished_semaphore,
   };
   graphics_queue_.submit(submit, frame.flight_fence);
+  staging_.Submit(frame.serial);
 
   vk::PresentInfoKHR present{
       .waitSemaphoreCount = 1,
@@ -1024,12 +1759,22 @@ void Renderer::Render(const glm::vec3 &position) {
 }
 
 Renderer::~Renderer() {
+  // Meshing jobs write to the result list of the renderer
+  workers_.Wait();
+
   vulkan::device.waitIdle();
 
-  for (auto &buffer : chunk_buffer_) {
-    vulkan::device.unmapMemory(buffer.memory);
-    vulkan::device.destroyBuffer(buffer.buffer);
-    vulkan::device.freeMemory(buffer.memory);
+  RetireSubmissions(submit_serial_);
+  vulkan::device.unmapMemory(staging_buffer_.memory);
+  vulkan::device.destroyBuffer(staging_buffer_.buffer);
+  vulkan::device.freeMemory(staging_buffer_.memory);
+  vulkan::device.unmapMemory(section_origins_.memory);
+  vulkan::device.destroyBuffer(section_origins_.buffer);
+  vulkan::device.freeMemory(section_origins_.memory);
+
+  for (auto &page : chunk_pages_) {
+    vulkan::device.destroyBuffer(page.buffer.buffer);
+    vulkan::device.freeMemory(page.buffer.memory);
   }
 
   for (auto &frame : frames_) {
@@ -1038,13 +1783,24 @@ Renderer::~Renderer() {
     vulkan::device.destroyFence(frame.flight_fence);
     vulkan::device.destroyBuffer(frame.uniform_buffer.buffer);
     vulkan::device.freeMemory(frame.uniform_buffer.memory);
-    for (auto &buffer : frame.chunk_buffer | std::views::keys) {
-      vulkan::device.destroyBuffer(buffer.buffer);
-      vulkan::device.freeMemory(buffer.memory);
+    if (frame.indirect_capacity) {
+      vulkan::device.unmapMemory(frame.indirect_buffer.memory);
+      vulkan::device.destroyBuffer(frame.indirect_buffer.buffer);
+      vulkan::device.freeMemory(frame.indirect_buffer.memory);
+    }
+    if (frame.cull_capacity) {
+      DestroyCullBuffers(frame);
     }
     vulkan::device.freeCommandBuffers(cmd_pool_, frame.cmd);
   }
 
+  if (gpu_culling_) {
+    vulkan::device.destroyPipeline(cull_pipeline_);
+    vulkan::device.destroyPipelineLayout(cull_pipeline_layout_);
+    vulkan::device.destroyDescriptorPool(cull_descriptor_pool_);
+    vulkan::device.destroyDescriptorSetLayout(cull_set_layout_);
+  }
+
   DestroySwapchain();
 
   vulkan::device.destroySampler(block_texture_sampler_);
@@ -2,11 +2,14 @@
 #ifndef VKMC_RENDER_MOD_H_
 #define VKMC_RENDER_MOD_H_
 
+#include <array>
 #include <bitset>
+#include <chrono>
 #include <cstdint>
 #include <map>
+#include <mutex>
+#include <set>
 #include <span>
-#include <queue>
 #include <utility>
 #include <vector>
 
@@ -15,19 +18,33 @@
 #include <vulkan.h>
 
 #include "chunk/manager.h"
+#include "render/arena.h"
 #include "render/camera.h"
+#include "render/frustum.h"
+#include "render/indirect.h"
 #include "render/buffer.h"
+#include "render/staging_ring.h"
 #include "mesh/face_instance.h"
+#include "job/worker_pool.h"
+#include "mesh/mesher.h"
 #include "block/registry.h"
 
 class Renderer : NonCopyMove, EventScope {
 private:
   static constexpr std::uint32_t kMaxFramesInFlight = 2;
-  static constexpr auto kChunkBufferSize =
-      Chunk::kLength * Chunk::kLength * Chunk::kLength * 6 * sizeof(FaceInstance);
+  /// The number of faces a page of the chunk mesh arena holds
+  static constexpr std::size_t kChunkPageFaces = std::size_t(1) << 22;
+  static_assert(ChunkMesher::kMaxFaces <= kChunkPageFaces);
+  /// The size of the staging ring for mesh uploads
+  static constexpr std::size_t kStagingRingSize = std::size_t(32) << 20;
+  static_assert(ChunkMesher::kMaxFaces * sizeof(FaceInstance) <= kStagingRingSize);
+  /// The number of chunks the section origin table holds, each chunk owns
+  /// one slot per section
+  static constexpr std::uint32_t kMaxChunkSlots = 8192;
+  static_assert(kMaxChunkSlots * Chunk::kSections <= FaceInstance::kMaxSlots);
 
 public:
-  Renderer(const ChunkManager &chunks, const BlockRegistry &);
+  Renderer(const ChunkManager &chunks, const BlockRegistry &, WorkerPool &);
 
   ~Renderer();
 
@@ -37,6 +54,26 @@ public:
 
   void Render(const glm::vec3 &position);
 
+  [[nodiscard]] MeshingMode GetMeshingMode() const noexcept {
+    return meshing_mode_;
+  }
+
+  /// Switch the mesher and rebuild all chunk meshes, prints the face count
+  void SetMeshingMode(MeshingMode);
+
+  /// The numbers of chunks and sections drawn or culled by the frustum
+  struct CullStats {
+    std::uint32_t drawn_chunks;
+    std::uint32_t culled_chunks;
+    std::uint32_t drawn_sections;
+    std::uint32_t culled_sections;
+  };
+
+  /// The CPU culling result of the latest frame, not counted with GPU culling
+  [[nodiscard]] const CullStats &GetCullStats() const noexcept {
+    return cull_stats_;
+  }
+
 private:
   void RecreateSwapchain(std::uint32_t width, std::uint32_t height);
 
@@ -70,26 +107,114 @@ private:
 
   void CreateCommandPool();
   void CreateCommandBuffers();
-  void RecordCommandBuffer(std::uint32_t image_id);
+  void RecordCommandBuffer(std::uint32_t image_id, const Frustum &);
+  struct Frame;
+  /// Record the draws of the draw list, by multi draw indirect if supported
+  void RecordChunkDraws(vk::CommandBuffer, Frame &);
+
+  /// A section mesh for the culling shader, same layout as Candidate in
+  /// cull.comp
+  struct CullCandidate {
+    glm::vec4 min;
+    glm::vec4 max;
+    DrawIndirectCommand command;
+    /// The first output command of the page
+    std::uint32_t output_base;
+    /// The page, then the counter of the page in the shader
+    std::uint32_t page;
+    std::uint32_t padding[2];
+  };
+  static_assert(sizeof(CullCandidate) == 64);
+
+  void CreateCullPipeline();
+  /// Make sure the culling buffers of the frame hold count candidates
+  void ReserveCullBuffers(Frame &, std::size_t count);
+  void DestroyCullBuffers(Frame &);
+  /// Upload all section meshes as candidates and cull them by compute
+  void RecordCullDispatch(vk::CommandBuffer, Frame &);
+  /// Draw the commands compacted by the culling shader
+  void RecordCulledChunkDraws(vk::CommandBuffer, Frame &);
   void CreateSyncObjects();
 
-  void UpdateUniformBuffer(const glm::vec3 &position, void *);
+  void UpdateUniformBuffer(const glm::mat4 &view_projection, void *);
 
   void DestroySwapchain();
 
-  MappingBuffer CreateChunkMeshBufferForCPU();
-  Buffer CreateChunkMeshBufferForGPU();
+  static constexpr std::uint32_t kNoPage = ~std::uint32_t(0);
+
+  struct SectionMesh {
+    /// The arena page holding the mesh, kNoPage if the section has no face
+    std::uint32_t page;
+    /// The offset in faces of the mesh in the page
+    std::uint32_t offset;
+    /// The number of block faces in the section
+    std::uint32_t n_face;
+    /// The version of the latest requested mesh
+    std::uint64_t version;
+  };
+
+  /// A large device buffer shared by many section meshes and by all frames
+  struct ChunkPage {
+    ArenaAllocator allocator;
+    Buffer buffer;
+  };
+
+  /// A copy recorded to the next frame before drawing
+  struct ChunkUpload {
+    vk::Buffer src;
+    vk::Buffer dst;
+    vk::BufferCopy region;
+    /// Whether the copy reads the result of former copies
+    bool barrier;
+  };
+
+  void CreateStagingBuffer();
+  void CreateSectionOriginBuffer();
+  Buffer CreateChunkPageBuffer();
+  void CreateChunkPage();
 
   struct ChunkInfo {
     const Chunk *chunk;
-    /// The index of vertex buffer for the chunk
-    std::uint32_t index;
-    /// The number of block faces in the chunk
-    std::uint32_t n_face;
+    std::array<SectionMesh, Chunk::kSections> sections;
+    /// The slot of the chunk in the section origin table
+    std::uint32_t slot;
+  };
+
+  struct ChunkMeshResult {
+    ChunkId chunk;
+    std::uint32_t section;
+    std::uint64_t version;
+    std::vector<FaceInstance> faces;
   };
 
+  /// Allocate arena space for n_face faces, the old space of the mesh is freed
+  void AllocateSectionMesh(SectionMesh &, std::uint32_t n_face);
+  void ReleaseSectionMesh(SectionMesh &);
+  /// Pack the meshes of a page and update the offsets of moved sections
+  void DefragmentChunkPage(std::uint32_t page);
+  /// Stage the faces and queue the copies to the device pages, returns
+  /// false if the staging ring is full
+  bool UploadSectionMesh(SectionMesh &, const std::vector<FaceInstance> &faces);
+  void RecordChunkUploads(vk::CommandBuffer);
+  /// Reclaim the staging space and buffers used by submissions up to serial
+  void RetireSubmissions(std::uint64_t serial);
+
+  /// Take a free slot of the section origin table and write the origins
+  /// of the chunk sections to it
+  std::uint32_t AcquireChunkSlot(ChunkId);
   void GenerateChunkResources(ChunkId, const Chunk *);
-  void GenerateChunkMesh(ChunkId, const Chunk *, ChunkInfo &);
+  /// Snapshot the section and mesh it on a worker
+  void GenerateSectionMesh(ChunkId, std::uint32_t section, ChunkInfo &);
+  /// Mark the section mesh as outdated, it will be regenerated next frame
+  void RegenerateSectionMesh(ChunkId, std::uint32_t section);
+  void RegenerateChunkMesh(ChunkId);
+  /// Regenerate the sections whose faces may be changed by the block
+  void RegenerateBlockMeshes(ChunkId, const glm::ivec3 &position);
+  void RegenerateNeighborChunkMeshes(ChunkId);
+  /// Submit outdated meshes and upload finished meshes nearest to the
+  /// position first, within the upload budget
+  void IntegrateChunkMeshes(const glm::vec3 &position);
+  [[nodiscard]] SectionMesh *FindSectionMesh(ChunkId, std::uint32_t section);
   void ReleaseChunkResources(ChunkId);
 
   std::uint32_t current_frame_;
@@ -122,10 +247,26 @@ private:
   vk::CommandPool cmd_pool_;
 
   std::map<std::uint64_t, ChunkInfo> chunks_;
-  std::vector<MappingBuffer> chunk_buffer_;
-  std::queue<std::uint32_t> free_chunk_buffer_index_;
-
-  struct : NonCopy {
+  std::vector<ChunkPage> chunk_pages_;
+  std::vector<ChunkUpload> uploads_;
+
+  StagingRing staging_;
+  MappingBuffer staging_buffer_;
+  /// The serial of the latest frame submission
+  std::uint64_t submit_serial_;
+  /// Buffers to destroy after the submission of the serial is finished
+  std::vector<std::pair<std::uint64_t, Buffer>> retired_buffers_;
+
+  /// The origins of the sections indexed by the face slot, read by the
+  /// vertex shader
+  MappingBuffer section_origins_;
+  std::vector<std::uint32_t> free_chunk_slots_;
+  std::uint32_t next_chunk_slot_;
+  /// Chunk slots to free after the submission of the serial is finished,
+  /// the faces drawn by in flight frames still read their origins
+  std::vector<std::pair<std::uint64_t, std::uint32_t>> retired_chunk_slots_;
+
+  struct Frame : NonCopy {
     vk::CommandBuffer cmd;
     vk::DescriptorSet descriptor_set;
     MappingBuffer uniform_buffer;
@@ -133,8 +274,23 @@ private:
     vk::Semaphore image_available_semaphore;
     vk::Semaphore render_finished_semaphore;
     vk::Fence flight_fence;
+    /// The serial of the latest submission of the frame
+    std::uint64_t serial;
+
+    /// Indirect draw commands of the frame, written each frame
+    MappingBuffer indirect_buffer;
+    /// The number of commands the indirect buffer holds
+    std::size_t indirect_capacity;
+
+    vk::DescriptorSet cull_descriptor_set;
+    MappingBuffer cull_candidates;
+    /// The draw commands written by the culling shader
+    Buffer cull_commands;
+    /// The number of visible commands of each page
+    Buffer cull_counters;
+    /// The number of candidates the culling buffers hold
+    std::size_t cull_capacity;
 
-    std::vector<std::pair<Buffer, bool>> chunk_buffer;
   } frames_[kMaxFramesInFlight];
 
   Image block_texture_;
@@ -142,6 +298,38 @@ private:
 
   const BlockRegistry &block_registry_;
 
+  WorkerPool &workers_;
+
+  ChunkMesher mesher_;
+  MeshingMode meshing_mode_;
+
+  std::set<std::pair<std::uint64_t, std::uint32_t>> dirty_meshes_;
+  std::uint64_t mesh_version_;
+  /// The number of meshes are being generated by workers
+  std::uint32_t meshing_;
+  bool report_mesh_stats_;
+  std::vector<ChunkMeshResult> meshed_;
+  std::mutex meshed_mutex_;
+  /// Finished meshes waiting for the upload budget or the staging ring
+  std::vector<ChunkMeshResult> unstaged_meshes_;
+  /// The maximum bytes of meshes uploaded in a frame
+  std::size_t upload_budget_;
+
+  CullStats cull_stats_;
+  IndirectDrawList draw_list_;
+
+  /// Cull by the compute shader instead of the CPU
+  bool gpu_culling_;
+  vk::DescriptorSetLayout cull_set_layout_;
+  vk::PipelineLayout cull_pipeline_layout_;
+  vk::Pipeline cull_pipeline_;
+  vk::DescriptorPool cull_descriptor_pool_;
+  std::vector<CullCandidate> cull_candidates_;
+  std::vector<IndirectDrawList::Batch> cull_batches_;
+
+  float frame_time_;
+  std::chrono::steady_clock::time_point last_frame_;
+
   struct PushConstants {
     std::uint32_t texture_count;
   };
@@ -0,0 +1,28 @@
+#include <filesystem>
+#include <string>
+
+#include <assets/json.h>
+#include <assets/load.h>
+
+#include "world.h"
+
+World::World(std::uint64_t seed) : chunks_(seed, workers_), player_{} {
+  auto &config = assets::LoadJson("config.json")["chunk"];
+  render_distance_ = config.value("render_distance", 8);
+  chunks_.SetRenderDistance(render_distance_, config.value("unload_margin", 2));
+  chunks_.SetLoadBudget(config.value("load_budget", 8));
+  // Each seed has its own directory, an empty path disables saving
+  auto save_directory = config.value("save_directory", std::string("saves"));
+  if (!save_directory.empty()) {
+    storage_ = std::make_unique<ChunkStorage>(std::filesystem::path(save_directory) / std::to_string(seed));
+    chunks_.SetStorage(storage_.get());
+    chunks_.Recover(block_registry_);
+  }
+  assets::Unload("config.json");
+}
+
+void World::Tick(double elapsed) {
+  chunks_.LoadAutomatic(block_registry_, player_.position);
+  chunks_.Integrate();
+  entity_chunk_system_.Update(player_, chunks_, elapsed);
+}
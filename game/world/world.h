@@ -0,0 +1,61 @@
+#pragma once
+#ifndef VKMC_WORLD_WORLD_H_
+#define VKMC_WORLD_WORLD_H_
+
+#include <cstdint>
+#include <memory>
+
+#include <common/classes.h>
+
+#include "../block/registry.h"
+#include "../chunk/manager.h"
+#include "../job/worker_pool.h"
+#include "../physical/entity.h"
+#include "../physical/entity_chunk_system.h"
+
+/// The simulation of the world without any window or GPU. It owns the
+/// blocks, the chunks loaded around the player and the player entity.
+class World : NonCopyMove {
+public:
+  explicit World(std::uint64_t seed);
+
+  [[nodiscard]] ChunkManager &GetChunks() noexcept {
+    return chunks_;
+  }
+
+  [[nodiscard]] const BlockRegistry &GetBlockRegistry() const noexcept {
+    return block_registry_;
+  }
+
+  [[nodiscard]] WorkerPool &GetWorkers() noexcept {
+    return workers_;
+  }
+
+  [[nodiscard]] Entity &GetPlayerEntity() noexcept {
+    return player_;
+  }
+
+  /// The radius of loaded chunks around the player
+  [[nodiscard]] std::int32_t GetRenderDistance() const noexcept {
+    return render_distance_;
+  }
+
+  /// Load the chunks around the player and move the player by the
+  /// physics steps in the elapsed seconds, the chunk events are emitted
+  /// here
+  void Tick(double elapsed);
+
+private:
+  /// Declared first, the jobs of the chunks read it until the chunks are
+  /// destroyed
+  BlockRegistry block_registry_;
+  WorkerPool workers_;
+  /// Destroyed after the chunks, which save into it
+  std::unique_ptr<ChunkStorage> storage_;
+  ChunkManager chunks_;
+  EntityChunkSystem entity_chunk_system_;
+  Entity player_;
+  std::int32_t render_distance_;
+};
+
+#endif // VKMC_WORLD_WORLD_H_
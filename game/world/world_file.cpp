@@ -0,0 +1,60 @@
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#include "world_file.h"
+
+static_assert(std::endian::native == std::endian::little, "World files are little endian");
+
+WorldFileWriter::WorldFileWriter(
+    const std::filesystem::path &path, std::uint64_t seed, ChunkId min, ChunkId max
+)
+    : out_(path, std::ios::binary), size_(0), checksum_(14695981039346656037ull) {
+  if (min.x > max.x || min.y > max.y) {
+    throw std::runtime_error("The world file region is empty!");
+  }
+  if (!out_.is_open()) {
+    throw std::runtime_error("Could not write the world file " + path.string() + "!");
+  }
+  count_ = std::size_t(max.x - min.x + 1) * std::size_t(max.y - min.y + 1);
+  offsets_.reserve(count_ + 1);
+
+  WorldFileHeader header{};
+  std::memcpy(header.magic, WorldFileHeader::kMagic, sizeof(header.magic));
+  header.version = WorldFileHeader::kVersion;
+  header.seed = seed;
+  header.min_x = min.x;
+  header.min_z = min.y;
+  header.max_x = max.x;
+  header.max_z = max.y;
+  WriteBytes(&header, sizeof(header));
+}
+
+void WorldFileWriter::Write(std::span<const std::uint8_t> chunk) {
+  if (offsets_.size() == count_) {
+    throw std::runtime_error("Too many chunks for the world file!");
+  }
+  offsets_.push_back(size_);
+  WriteBytes(chunk.data(), chunk.size());
+}
+
+void WorldFileWriter::Finish() {
+  if (offsets_.size() != count_) {
+    throw std::runtime_error("The world file is missing chunks!");
+  }
+  offsets_.push_back(size_);
+  WriteBytes(offsets_.data(), offsets_.size() * sizeof(std::uint64_t));
+  out_.flush();
+  if (!out_) {
+    throw std::runtime_error("Failed to write the world file!");
+  }
+}
+
+void WorldFileWriter::WriteBytes(const void *data, std::size_t size) {
+  auto bytes = static_cast<const std::uint8_t *>(data);
+  for (std::size_t i = 0; i != size; ++i) {
+    checksum_ = (checksum_ ^ bytes[i]) * 1099511628211ull;
+  }
+  out_.write(static_cast<const char *>(data), std::streamsize(size));
+  size_ += size;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#ifndef VKMC_WORLD_WORLD_FILE_H_
+#define VKMC_WORLD_WORLD_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <vector>
+
+#include <common/classes.h>
+
+#include "../chunk/chunk.h"
+
+/// The header of a pre-generated world file. The file holds the chunks of
+/// the rectangle [min, max] encoded by EncodeChunk, in rows of z then x,
+/// followed by count + 1 offsets of the chunks from the file start.
+/// All numbers are little endian.
+struct WorldFileHeader {
+  static constexpr char kMagic[8] = {'V', 'K', 'M', 'C', 'W', 'R', 'L', 'D'};
+  static constexpr std::uint32_t kVersion = 2;
+
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t reserved;
+  std::uint64_t seed;
+  std::int32_t min_x;
+  std::int32_t min_z;
+  std::int32_t max_x;
+  std::int32_t max_z;
+};
+
+static_assert(sizeof(WorldFileHeader) == 40);
+
+/// Writes a world file sequentially, the chunks must be written in the
+/// order of the file
+class WorldFileWriter : NonCopyMove {
+public:
+  /// Create the file and write the header, throws if it can't be opened
+  WorldFileWriter(const std::filesystem::path &path, std::uint64_t seed, ChunkId min, ChunkId max);
+
+  /// Append the next encoded chunk
+  void Write(std::span<const std::uint8_t> chunk);
+
+  /// Write the offset table after all chunks were written
+  void Finish();
+
+  /// The number of chunks in the rectangle
+  [[nodiscard]] std::size_t GetChunkCount() const noexcept {
+    return count_;
+  }
+
+  /// The bytes written so far
+  [[nodiscard]] std::uint64_t GetSize() const noexcept {
+    return size_;
+  }
+
+  /// FNV-1a of the bytes written so far, equal files have equal checksums
+  [[nodiscard]] std::uint64_t GetChecksum() const noexcept {
+    return checksum_;
+  }
+
+private:
+  void WriteBytes(const void *data, std::size_t size);
+
+  std::ofstream out_;
+  std::size_t count_;
+  std::vector<std::uint64_t> offsets_;
+  std::uint64_t size_;
+  std::uint64_t checksum_;
+};
+
+#endif // VKMC_WORLD_WORLD_FILE_H_
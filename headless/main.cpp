@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <glm/geometric.hpp>
+#include <nlohmann/json.hpp>
+
+#include "../base/sources/internal/assets.h"
+#include "../game/world/world.h"
+
+namespace {
+
+/// The same acceleration as a player holding a move key
+constexpr float kMove = .1f;
+
+struct Options {
+  std::string assets = "default.assets";
+  std::string json;
+  std::size_t ticks = 1200;
+  /// Ticks per second like the frame rate of the game. 0 runs unpaced,
+  /// each tick waits for the chunks the last one requested.
+  double tick_rate = 60;
+  std::uint64_t seed = 114514;
+};
+
+Options ParseOptions(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    auto value = [&] {
+      if (i + 1 == argc) {
+        throw std::runtime_error("Missing value of " + std::string(arg));
+      }
+      return std::string(argv[++i]);
+    };
+    if (arg == "--assets") {
+      options.assets = value();
+    } else if (arg == "--json") {
+      options.json = value();
+    } else if (arg == "--ticks") {
+      options.ticks = std::stoull(value());
+    } else if (arg == "--tick-rate") {
+      options.tick_rate = std::stod(value());
+    } else if (arg == "--seed") {
+      options.seed = std::stoull(value());
+    } else {
+      throw std::runtime_error(
+          "Usage: vkmc_headless [--assets file] [--json file] [--ticks n] [--tick-rate hz] [--seed n]"
+      );
+    }
+  }
+  return options;
+}
+
+/// The heading of the scripted flight, forward along x while weaving
+/// along z so chunks are loaded and unloaded on both axes
+glm::vec3 GetFlightDirection(std::size_t tick) noexcept {
+  auto t = float(tick) / 256;
+  return glm::normalize(glm::vec3(1, std::sin(t * .5f) * .1f, std::sin(t)));
+}
+
+/// The tick time below which the given fraction of ticks are
+double GetPercentile(const std::vector<double> &sorted, double p) noexcept {
+  auto index = std::size_t(p * double(sorted.size() - 1) + .5);
+  return sorted[index];
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  try {
+    auto options = ParseOptions(argc, argv);
+    if (options.ticks == 0) {
+      throw std::runtime_error("No tick to simulate!");
+    }
+    assets::internal::LoadAssetsFile(options.assets);
+
+    {
+      World world(options.seed);
+      auto &player = world.GetPlayerEntity();
+      // Above the terrain, the flight only rises from there and never
+      // stops at a hill
+      glm::vec3 origin{0, ChunkGenerator::kMaxHeight + 1, 0};
+      player.position = origin;
+
+      using Clock = std::chrono::steady_clock;
+      std::vector<double> tick_ms;
+      tick_ms.reserve(options.ticks);
+      auto start = Clock::now();
+      for (std::size_t tick = 0; tick != options.ticks; ++tick) {
+        // Chunks are generated by workers between ticks as in the game
+        if (options.tick_rate > 0) {
+          std::this_thread::sleep_until(
+              start + std::chrono::duration_cast<Clock::duration>(
+                          std::chrono::duration<double>(double(tick) / options.tick_rate)
+                      )
+          );
+        } else {
+          // Without the pause nothing would be generated in time, the tick
+          // integrates every requested chunk instead
+          world.GetWorkers().Wait();
+        }
+        auto tick_start = Clock::now();
+        player.acceleration = GetFlightDirection(tick) * kMove;
+        // One physics step per tick whatever the tick rate
+        world.Tick(EntityChunkSystem::kStep);
+        tick_ms.push_back(std::chrono::duration<double, std::milli>(Clock::now() - tick_start).count());
+      }
+      auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+      double total_ms = 0;
+      for (auto ms : tick_ms) {
+        total_ms += ms;
+      }
+      auto mean = total_ms / double(tick_ms.size());
+      std::ranges::sort(tick_ms);
+      auto pool = world.GetChunks().GetPoolStats();
+      nlohmann::json report{
+          {"ticks", options.ticks},
+          {"tick_rate", options.tick_rate},
+          {"seconds", seconds},
+          {"mean_ms", mean},
+          {"p50_ms", GetPercentile(tick_ms, .5)},
+          {"p90_ms", GetPercentile(tick_ms, .9)},
+          {"p99_ms", GetPercentile(tick_ms, .99)},
+          {"p999_ms", GetPercentile(tick_ms, .999)},
+          {"max_ms", tick_ms.back()},
+          {"distance", glm::length(player.position - origin)},
+          {"workers", world.GetWorkers().GetWorkerCount()},
+          {"pool_hits", pool.hits},
+          {"pool_misses", pool.misses},
+          {"pool_high_water", pool.high_water},
+          {"pool_capacity", pool.capacity},
+      };
+
+      std::printf(
+          "%zu ticks in %.2f s, %.1f blocks flown\n"
+          "tick ms: mean %.3f p50 %.3f p90 %.3f p99 %.3f p99.9 %.3f max %.3f\n"
+          "chunk pool: %llu hits, %llu misses, high water %zu of %zu\n",
+          options.ticks, seconds, double(report["distance"]),
+          mean, double(report["p50_ms"]), double(report["p90_ms"]),
+          double(report["p99_ms"]), double(report["p999_ms"]), tick_ms.back(),
+          static_cast<unsigned long long>(pool.hits), static_cast<unsigned long long>(pool.misses),
+          pool.high_water, pool.capacity
+      );
+      if (!options.json.empty()) {
+        std::ofstream(options.json) << report.dump(2) << '\n';
+      }
+    }
+
+    assets::internal::UnloadAssetsFile();
+  } catch (std::exception &e) {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+  return 0;
+}
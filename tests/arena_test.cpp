@@ -0,0 +1,150 @@
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "../game/render/arena.h"
+#include "test.h"
+
+VKMC_TEST(ArenaAllocatesBestFit) {
+  ArenaAllocator arena(100);
+  auto a = arena.Allocate(10), b = arena.Allocate(30), c = arena.Allocate(20), d = arena.Allocate(40);
+  VKMC_CHECK(a == 0 && b == 10 && c == 40 && d == 60);
+  VKMC_CHECK(arena.GetFreeSize() == 0);
+  VKMC_CHECK(arena.Allocate(1) == ArenaAllocator::kInvalidOffset);
+
+  // Free ranges of 30 at 10 and 40 at 60, each request takes the smallest
+  // range it fits in and leaves the rest free
+  arena.Free(b);
+  arena.Free(d);
+  VKMC_CHECK(arena.Allocate(25) == 10);
+  VKMC_CHECK(arena.Allocate(35) == 60);
+  VKMC_CHECK(arena.GetFreeRangeCount() == 2);
+  VKMC_CHECK(arena.Allocate(5) == 35);
+  VKMC_CHECK(arena.Allocate(5) == 95);
+  VKMC_CHECK(arena.GetSize(95) == 5);
+  VKMC_CHECK(arena.GetUsedSize() == 100);
+}
+
+VKMC_TEST(ArenaCoalescesFreeRanges) {
+  ArenaAllocator arena(40);
+  std::size_t offsets[4];
+  for (auto &offset : offsets) {
+    offset = arena.Allocate(10);
+  }
+
+  // Free the second and fourth, then the third joins both neighbours
+  arena.Free(offsets[1]);
+  arena.Free(offsets[3]);
+  VKMC_CHECK(arena.GetFreeRangeCount() == 2);
+  VKMC_CHECK(arena.GetLargestFreeRange() == 10);
+  arena.Free(offsets[2]);
+  VKMC_CHECK(arena.GetFreeRangeCount() == 1);
+  VKMC_CHECK(arena.GetLargestFreeRange() == 30);
+  arena.Free(offsets[0]);
+  VKMC_CHECK(arena.GetFreeRangeCount() == 1);
+  VKMC_CHECK(arena.GetLargestFreeRange() == 40);
+  VKMC_CHECK(arena.GetUsedSize() == 0);
+}
+
+VKMC_TEST(ArenaRejectsInvalidRanges) {
+  ArenaAllocator arena(16);
+  VKMC_CHECK_THROWS((void)arena.Allocate(0), std::runtime_error);
+  VKMC_CHECK_THROWS(arena.Free(3), std::runtime_error);
+  VKMC_CHECK_THROWS((void)arena.GetSize(0), std::runtime_error);
+  VKMC_CHECK(arena.Allocate(17) == ArenaAllocator::kInvalidOffset);
+}
+
+VKMC_TEST(ArenaDefragmentsFragmentedSpace) {
+  ArenaAllocator arena(100);
+  std::vector<std::size_t> offsets;
+  for (int i = 0; i != 10; ++i) {
+    offsets.push_back(arena.Allocate(10));
+  }
+  for (int i = 0; i != 10; i += 2) {
+    arena.Free(offsets[i]);
+  }
+  VKMC_CHECK(arena.GetFreeSize() == 50);
+  VKMC_CHECK(arena.IsFragmentedFor(20));
+  VKMC_CHECK(!arena.IsFragmentedFor(10));
+  VKMC_CHECK(!arena.IsFragmentedFor(60));
+
+  auto moves = arena.Defragment();
+  VKMC_CHECK(moves.size() == 5);
+  for (std::size_t i = 0; i != moves.size(); ++i) {
+    VKMC_CHECK(moves[i].src == offsets[2 * i + 1]);
+    VKMC_CHECK(moves[i].dst == 10 * i);
+    VKMC_CHECK(moves[i].size == 10);
+    VKMC_CHECK(moves[i].dst <= moves[i].src);
+  }
+  VKMC_CHECK(arena.GetFreeRangeCount() == 1);
+  VKMC_CHECK(arena.GetLargestFreeRange() == 50);
+  VKMC_CHECK(arena.Allocate(50) == 50);
+}
+
+VKMC_TEST(ArenaKeepsRandomAllocationsApart) {
+  // Allocations are filled with a tag in a shadow memory and moved with
+  // the moves of defragmentation, no tag may ever be overwritten
+  constexpr std::size_t capacity = 10000;
+  ArenaAllocator arena(capacity);
+  std::vector<unsigned char> memory(capacity);
+  std::map<std::size_t, std::pair<std::size_t, unsigned char>> live;
+  std::mt19937 random(1);
+  std::size_t defragments = 0;
+  for (int step = 0; step != 100000; ++step) {
+    if (random() % 3 != 0) {
+      std::size_t size = 1 + random() % 300;
+      auto offset = arena.Allocate(size);
+      if (offset == ArenaAllocator::kInvalidOffset) {
+        if (!arena.IsFragmentedFor(size)) {
+          continue;
+        }
+        for (auto &move : arena.Defragment()) {
+          std::memmove(&memory[move.dst], &memory[move.src], move.size);
+        }
+        ++defragments;
+        std::map<std::size_t, std::pair<std::size_t, unsigned char>> packed;
+        std::size_t cursor = 0;
+        for (auto &[_, allocation] : live) {
+          packed[cursor] = allocation;
+          cursor += allocation.first;
+        }
+        live.swap(packed);
+        VKMC_CHECK(arena.GetFreeRangeCount() <= 1);
+        offset = arena.Allocate(size);
+        VKMC_CHECK(offset != ArenaAllocator::kInvalidOffset);
+      }
+      VKMC_CHECK(offset + size <= capacity);
+      auto tag = static_cast<unsigned char>(random());
+      std::memset(&memory[offset], tag, size);
+      live[offset] = {size, tag};
+    } else if (!live.empty()) {
+      auto it = std::next(live.begin(), std::ptrdiff_t(random() % live.size()));
+      arena.Free(it->first);
+      live.erase(it);
+    }
+
+    if (step % 100 == 0) {
+      std::size_t used = 0;
+      for (auto &[offset, allocation] : live) {
+        auto [size, tag] = allocation;
+        used += size;
+        for (std::size_t i = 0; i != size; ++i) {
+          VKMC_CHECK(memory[offset + i] == tag);
+        }
+      }
+      VKMC_CHECK(used == arena.GetUsedSize());
+      VKMC_CHECK(live.size() == arena.GetAllocationCount());
+    }
+  }
+  VKMC_CHECK(defragments != 0);
+
+  for (auto &[offset, _] : live) {
+    arena.Free(offset);
+  }
+  VKMC_CHECK(arena.GetFreeRangeCount() == 1);
+  VKMC_CHECK(arena.GetLargestFreeRange() == capacity);
+}
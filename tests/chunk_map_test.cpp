@@ -0,0 +1,91 @@
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "../game/chunk/chunk_map.h"
+#include "test.h"
+
+VKMC_TEST(ChunkMapMatchesUnorderedMap) {
+  std::mt19937 random(5);
+  ChunkMap<std::unique_ptr<int>> map;
+  std::unordered_map<ChunkId, int, ChunkIdHash> reference;
+  std::size_t mismatches = 0;
+  for (int step = 0; step != 300000; ++step) {
+    // Mostly a small area so entries collide and are erased often
+    ChunkId id{int(random() % 64) - 32, int(random() % 64) - 32};
+    if (step % 7 == 0) {
+      id = {int(random()), int(random())};
+    }
+
+    switch (random() % 3) {
+    case 0: {
+      auto [value, inserted] = map.TryEmplace(id, std::make_unique<int>(step));
+      auto [it, reference_inserted] = reference.try_emplace(id, step);
+      mismatches += inserted != reference_inserted || **value != it->second;
+      break;
+    }
+    case 1:
+      mismatches += map.Erase(id) != (reference.erase(id) == 1);
+      break;
+    default: {
+      auto value = map.Find(id);
+      auto it = reference.find(id);
+      mismatches += (value == nullptr) != (it == reference.end()) || (value && **value != it->second);
+      break;
+    }
+    }
+    mismatches += map.GetSize() != reference.size();
+
+    if (step % 10000 == 0) {
+      std::size_t count = 0;
+      for (auto [entry_id, value] : map) {
+        auto it = reference.find(entry_id);
+        mismatches += it == reference.end() || it->second != *value;
+        ++count;
+      }
+      mismatches += count != reference.size();
+    }
+  }
+  VKMC_CHECK(mismatches == 0);
+}
+
+VKMC_TEST(ChunkMapErasesInWrappedProbeSequence) {
+  // Ids whose home is the last slot of the smallest map, their probe
+  // sequence wraps to the front
+  ChunkMap<int> map;
+  std::vector<ChunkId> ids;
+  for (int x = 0; ids.size() != 5; ++x) {
+    ChunkId id{x, -x};
+    if ((ChunkIdHash{}(id) & 15) == 15) {
+      ids.push_back(id);
+    }
+  }
+  // An id at home in the first slot, displaced by the wrapped ones
+  ChunkId front{0, 0};
+  for (int x = 1; (ChunkIdHash{}(front) & 15) != 0; ++x) {
+    front = {x, x};
+  }
+
+  for (int i = 0; i != 5; ++i) {
+    map.TryEmplace(ids[i], i);
+  }
+  map.TryEmplace(front, 100);
+
+  // The entries after each hole move back, the displaced one too
+  VKMC_CHECK(map.Erase(ids[0]));
+  VKMC_CHECK(map.Erase(ids[3]));
+  VKMC_CHECK(!map.Erase(ids[3]));
+  VKMC_CHECK(map.GetSize() == 4);
+  for (int i : {1, 2, 4}) {
+    VKMC_CHECK(map.Find(ids[i]) != nullptr && *map.Find(ids[i]) == i);
+  }
+  VKMC_CHECK(map.Find(front) != nullptr && *map.Find(front) == 100);
+  VKMC_CHECK(!map.Contains(ids[0]) && !map.Contains(ids[3]));
+
+  std::size_t count = 0;
+  for ([[maybe_unused]] auto entry : map) {
+    ++count;
+  }
+  VKMC_CHECK(count == 4);
+}
@@ -0,0 +1,99 @@
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "../game/chunk/codec.h"
+#include "../game/chunk/generator.h"
+#include "test.h"
+
+namespace {
+
+bool IsSameChunk(const Chunk &a, const Chunk &b) {
+  for (int y = 0; y != int(Chunk::kHeight); ++y) {
+    for (int z = 0; z != int(Chunk::kLength); ++z) {
+      for (int x = 0; x != int(Chunk::kLength); ++x) {
+        if (a(x, y, z) != b(x, y, z)) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/// Generated terrain with random blocks scattered over it, more edits give
+/// larger palettes and shorter runs
+void MakeChunk(const BlockRegistry &registry, ChunkGenerator &generator, int index, Chunk &chunk) {
+  std::mt19937 random(index);
+  generator.Generate(registry, chunk, index * 5 - 40, index * 3);
+  for (int i = 0; i != index * 50; ++i) {
+    chunk.Set(int(random() % 32), int(random() % 256), int(random() % 32), BlockId(random() % 300));
+  }
+}
+
+} // namespace
+
+VKMC_TEST(CodecRoundTrips) {
+  test::AssetsScope assets;
+  BlockRegistry registry;
+  ChunkGenerator generator(7);
+  for (int i = 0; i != 20; ++i) {
+    Chunk chunk, decoded;
+    MakeChunk(registry, generator, i, chunk);
+    std::vector<std::uint8_t> data;
+    EncodeChunk(chunk, data);
+    DecodeChunk(data, decoded);
+    VKMC_CHECK(IsSameChunk(chunk, decoded));
+
+    // The same blocks encode to the same bytes
+    std::vector<std::uint8_t> again;
+    EncodeChunk(decoded, again);
+    VKMC_CHECK(again == data);
+  }
+
+  Chunk empty, decoded;
+  decoded.Fill(2);
+  std::vector<std::uint8_t> data;
+  EncodeChunk(empty, data);
+  DecodeChunk(data, decoded);
+  VKMC_CHECK(IsSameChunk(empty, decoded));
+}
+
+VKMC_TEST(CodecRejectsTruncatedInput) {
+  test::AssetsScope assets;
+  BlockRegistry registry;
+  ChunkGenerator generator(7);
+  Chunk chunk;
+  MakeChunk(registry, generator, 4, chunk);
+  std::vector<std::uint8_t> data;
+  EncodeChunk(chunk, data);
+
+  for (auto size : {std::size_t(0), std::size_t(1), data.size() / 2, data.size() - 1}) {
+    VKMC_CHECK_THROWS(DecodeChunk(std::span(data).first(size), chunk), std::runtime_error);
+  }
+}
+
+VKMC_TEST(CodecSurvivesCorruptInput) {
+  test::AssetsScope assets;
+  BlockRegistry registry;
+  ChunkGenerator generator(7);
+  Chunk chunk;
+  MakeChunk(registry, generator, 6, chunk);
+  std::vector<std::uint8_t> data;
+  EncodeChunk(chunk, data);
+
+  // A flipped bit either decodes to some blocks or throws, it never reads
+  // or writes out of bounds, which the sanitizers would catch
+  std::mt19937 random(19);
+  std::size_t rejected = 0;
+  for (int i = 0; i != 2000; ++i) {
+    auto corrupt = data;
+    corrupt[random() % corrupt.size()] ^= std::uint8_t(1 << random() % 8);
+    try {
+      DecodeChunk(corrupt, chunk);
+    } catch (std::runtime_error &) {
+      ++rejected;
+    }
+  }
+  VKMC_CHECK(rejected != 0);
+}
@@ -0,0 +1,385 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/geometric.hpp>
+
+#include "../game/render/frustum.h"
+#include "../game/render/indirect.h"
+#include "test.h"
+
+namespace {
+
+/// Same layout as Renderer::CullCandidate and Candidate in cull.comp
+struct Candidate {
+  glm::vec4 min;
+  glm::vec4 max;
+  DrawIndirectCommand command;
+  std::uint32_t output_base;
+  std::uint32_t page;
+  std::uint32_t padding[2];
+};
+
+static_assert(sizeof(Candidate) == 64);
+
+std::vector<std::uint32_t> ReadShader() {
+  std::ifstream file(VKMC_CULL_SHADER, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    throw std::runtime_error("Could not open " VKMC_CULL_SHADER);
+  }
+  std::vector<std::uint32_t> code(std::size_t(file.tellg()) / sizeof(std::uint32_t));
+  file.seekg(0);
+  file.read(reinterpret_cast<char *>(code.data()), std::streamsize(code.size() * sizeof(std::uint32_t)));
+  return code;
+}
+
+struct HostBuffer {
+  vk::Buffer buffer;
+  vk::DeviceMemory memory;
+  void *mapping;
+};
+
+/// A compute queue on the first device which has one, e.g. lavapipe, and
+/// the culling pipeline of the renderer
+class CullContext {
+public:
+  /// Whether a device was found, the test is skipped otherwise
+  bool Create() {
+    try {
+      vk::ApplicationInfo app_info{.apiVersion = VK_API_VERSION_1_0};
+      instance_ = vk::createInstance(vk::InstanceCreateInfo{.pApplicationInfo = &app_info});
+    } catch (vk::SystemError &) {
+      return false;
+    }
+    for (auto physical : instance_.enumeratePhysicalDevices()) {
+      auto families = physical.getQueueFamilyProperties();
+      for (std::uint32_t i = 0; i != families.size(); ++i) {
+        if (families[i].queueFlags & vk::QueueFlagBits::eCompute) {
+          physical_ = physical;
+          family_ = i;
+          break;
+        }
+      }
+      if (physical_) {
+        break;
+      }
+    }
+    if (!physical_) {
+      return false;
+    }
+
+    float priority = 1;
+    vk::DeviceQueueCreateInfo queue_ci{
+        .queueFamilyIndex = family_,
+        .queueCount = 1,
+        .pQueuePriorities = &priority,
+    };
+    device_ = physical_.createDevice(vk::DeviceCreateInfo{
+        .queueCreateInfoCount = 1,
+        .pQueueCreateInfos = &queue_ci,
+    });
+    queue_ = device_.getQueue(family_, 0);
+    CreatePipeline();
+    return true;
+  }
+
+  ~CullContext() {
+    if (device_) {
+      device_.waitIdle();
+      for (auto &buffer : buffers_) {
+        device_.destroyBuffer(buffer.buffer);
+        device_.freeMemory(buffer.memory);
+      }
+      device_.destroyCommandPool(command_pool_);
+      device_.destroyDescriptorPool(descriptor_pool_);
+      device_.destroyPipeline(pipeline_);
+      device_.destroyPipelineLayout(pipeline_layout_);
+      device_.destroyDescriptorSetLayout(set_layout_);
+      device_.destroy();
+    }
+    if (instance_) {
+      instance_.destroy();
+    }
+  }
+
+  /// Run the shader on the candidates, the batches index the counters
+  void Cull(
+      const glm::mat4 &view_projection, const std::vector<Candidate> &candidates, std::size_t batch_count,
+      std::vector<DrawIndirectCommand> &commands, std::vector<std::uint32_t> &counters
+  ) {
+    auto ubo = CreateBuffer(sizeof(glm::mat4), vk::BufferUsageFlagBits::eUniformBuffer);
+    auto input = CreateBuffer(candidates.size() * sizeof(Candidate), vk::BufferUsageFlagBits::eStorageBuffer);
+    auto output = CreateBuffer(
+        candidates.size() * sizeof(DrawIndirectCommand), vk::BufferUsageFlagBits::eStorageBuffer
+    );
+    auto counter = CreateBuffer(batch_count * sizeof(std::uint32_t), vk::BufferUsageFlagBits::eStorageBuffer);
+    std::memcpy(ubo.mapping, &view_projection, sizeof(glm::mat4));
+    std::memcpy(input.mapping, candidates.data(), candidates.size() * sizeof(Candidate));
+    std::memset(output.mapping, 0, candidates.size() * sizeof(DrawIndirectCommand));
+    std::memset(counter.mapping, 0, batch_count * sizeof(std::uint32_t));
+
+    auto set = device_.allocateDescriptorSets(vk::DescriptorSetAllocateInfo{
+        .descriptorPool = descriptor_pool_,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &set_layout_,
+    })[0];
+    std::array infos{
+        vk::DescriptorBufferInfo{.buffer = ubo.buffer, .range = VK_WHOLE_SIZE},
+        vk::DescriptorBufferInfo{.buffer = input.buffer, .range = VK_WHOLE_SIZE},
+        vk::DescriptorBufferInfo{.buffer = output.buffer, .range = VK_WHOLE_SIZE},
+        vk::DescriptorBufferInfo{.buffer = counter.buffer, .range = VK_WHOLE_SIZE},
+    };
+    std::array<vk::WriteDescriptorSet, 4> writes;
+    for (std::uint32_t i = 0; i != writes.size(); ++i) {
+      writes[i] = vk::WriteDescriptorSet{
+          .dstSet = set,
+          .dstBinding = i,
+          .descriptorCount = 1,
+          .descriptorType = i == 0 ? vk::DescriptorType::eUniformBuffer : vk::DescriptorType::eStorageBuffer,
+          .pBufferInfo = &infos[i],
+      };
+    }
+    device_.updateDescriptorSets(writes, {});
+
+    auto cmd = device_.allocateCommandBuffers(vk::CommandBufferAllocateInfo{
+        .commandPool = command_pool_,
+        .level = vk::CommandBufferLevel::ePrimary,
+        .commandBufferCount = 1,
+    })[0];
+    cmd.begin(vk::CommandBufferBeginInfo{.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+    std::uint32_t count = candidates.size();
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline_);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipeline_layout_, 0, set, {});
+    cmd.pushConstants(pipeline_layout_, vk::ShaderStageFlagBits::eCompute, 0, sizeof(count), &count);
+    cmd.dispatch((count + 63) / 64, 1, 1);
+    vk::MemoryBarrier written{
+        .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+        .dstAccessMask = vk::AccessFlagBits::eHostRead,
+    };
+    cmd.pipelineBarrier(
+        vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eHost, {}, written, {}, {}
+    );
+    cmd.end();
+    queue_.submit(vk::SubmitInfo{.commandBufferCount = 1, .pCommandBuffers = &cmd});
+    queue_.waitIdle();
+
+    auto commands_begin = static_cast<const DrawIndirectCommand *>(output.mapping);
+    commands.assign(commands_begin, commands_begin + candidates.size());
+    auto counters_begin = static_cast<const std::uint32_t *>(counter.mapping);
+    counters.assign(counters_begin, counters_begin + batch_count);
+
+    device_.freeCommandBuffers(command_pool_, cmd);
+    device_.resetDescriptorPool(descriptor_pool_);
+  }
+
+private:
+  void CreatePipeline() {
+    auto binding = [](std::uint32_t binding, vk::DescriptorType type) {
+      return vk::DescriptorSetLayoutBinding{
+          .binding = binding,
+          .descriptorType = type,
+          .descriptorCount = 1,
+          .stageFlags = vk::ShaderStageFlagBits::eCompute,
+      };
+    };
+    auto bindings = std::array{
+        binding(0, vk::DescriptorType::eUniformBuffer),
+        binding(1, vk::DescriptorType::eStorageBuffer),
+        binding(2, vk::DescriptorType::eStorageBuffer),
+        binding(3, vk::DescriptorType::eStorageBuffer),
+    };
+    set_layout_ = device_.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo{
+        .bindingCount = bindings.size(),
+        .pBindings = bindings.data(),
+    });
+    vk::PushConstantRange push_constants{
+        .stageFlags = vk::ShaderStageFlagBits::eCompute,
+        .size = sizeof(std::uint32_t),
+    };
+    pipeline_layout_ = device_.createPipelineLayout(vk::PipelineLayoutCreateInfo{
+        .setLayoutCount = 1,
+        .pSetLayouts = &set_layout_,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &push_constants,
+    });
+
+    auto code = ReadShader();
+    auto shader = device_.createShaderModule(vk::ShaderModuleCreateInfo{
+        .codeSize = code.size() * sizeof(std::uint32_t),
+        .pCode = code.data(),
+    });
+    vk::ComputePipelineCreateInfo ci{
+        .stage{
+            .stage = vk::ShaderStageFlagBits::eCompute,
+            .module = shader,
+            .pName = "main",
+        },
+        .layout = pipeline_layout_,
+    };
+    auto result = device_.createComputePipeline({}, ci);
+    device_.destroyShaderModule(shader);
+    if (result.result != vk::Result::eSuccess) {
+      throw std::runtime_error("Failed to create culling pipeline!");
+    }
+    pipeline_ = result.value;
+
+    auto sizes = std::array{
+        vk::DescriptorPoolSize{.type = vk::DescriptorType::eUniformBuffer, .descriptorCount = 1},
+        vk::DescriptorPoolSize{.type = vk::DescriptorType::eStorageBuffer, .descriptorCount = 3},
+    };
+    descriptor_pool_ = device_.createDescriptorPool(vk::DescriptorPoolCreateInfo{
+        .maxSets = 1,
+        .poolSizeCount = sizes.size(),
+        .pPoolSizes = sizes.data(),
+    });
+    command_pool_ = device_.createCommandPool(vk::CommandPoolCreateInfo{.queueFamilyIndex = family_});
+  }
+
+  HostBuffer CreateBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage) {
+    auto buffer = device_.createBuffer(vk::BufferCreateInfo{.size = size, .usage = usage});
+    auto requirements = device_.getBufferMemoryRequirements(buffer);
+    auto properties = physical_.getMemoryProperties();
+    auto wanted = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+    std::uint32_t type = 0;
+    while (type != properties.memoryTypeCount &&
+           (!(requirements.memoryTypeBits >> type & 1) || (properties.memoryTypes[type].propertyFlags & wanted) != wanted)) {
+      ++type;
+    }
+    if (type == properties.memoryTypeCount) {
+      throw std::runtime_error("No host visible memory!");
+    }
+    auto memory = device_.allocateMemory(vk::MemoryAllocateInfo{
+        .allocationSize = requirements.size,
+        .memoryTypeIndex = type,
+    });
+    device_.bindBufferMemory(buffer, memory, 0);
+    return buffers_.emplace_back(HostBuffer{buffer, memory, device_.mapMemory(memory, 0, size)});
+  }
+
+  vk::Instance instance_;
+  vk::PhysicalDevice physical_;
+  std::uint32_t family_ = 0;
+  vk::Device device_;
+  vk::Queue queue_;
+  vk::DescriptorSetLayout set_layout_;
+  vk::PipelineLayout pipeline_layout_;
+  vk::Pipeline pipeline_;
+  vk::DescriptorPool descriptor_pool_;
+  vk::CommandPool command_pool_;
+  std::vector<HostBuffer> buffers_;
+};
+
+/// The distance of the box to its closest plane relative to the size of
+/// the terms, the GPU and the CPU may round a box this close differently
+float GetPlaneMargin(const Frustum &frustum, const glm::vec3 &min, const glm::vec3 &max) {
+  auto center = (min + max) * .5f, extent = (max - min) * .5f;
+  auto margin = INFINITY;
+  for (int i = 0; i != 6; ++i) {
+    auto plane = frustum.GetPlane(i);
+    auto normal = glm::vec3(plane);
+    auto outside = glm::dot(normal, center) + plane.w + glm::dot(glm::abs(normal), extent);
+    auto magnitude = glm::dot(glm::abs(normal), glm::abs(center) + extent) + std::abs(plane.w);
+    margin = std::min(margin, std::abs(outside) / magnitude);
+  }
+  return margin;
+}
+
+} // namespace
+
+VKMC_TEST(CullShaderMatchesCpuFrustum) {
+  CullContext context;
+  if (!context.Create()) {
+    test::Skip("no Vulkan device with a compute queue");
+    return;
+  }
+
+  // Sections of 32 blocks around the camera in 4 pages, grouped by page
+  // and counted per page like Renderer::RecordCullDispatch
+  constexpr std::uint32_t pages = 4;
+  std::mt19937 random(4);
+  std::uniform_int_distribution<std::int32_t> chunk(-12, 11), section(0, 7);
+  std::vector<Candidate> candidates(20000);
+  for (std::uint32_t i = 0; i != candidates.size(); ++i) {
+    glm::vec3 min(chunk(random) * 32, section(random) * 32, chunk(random) * 32);
+    candidates[i] = {
+        .min{min, 1},
+        .max{min + 32.f, 1},
+        .command{.vertex_count = 4, .instance_count = 1 + i % 7, .first_vertex = 0, .first_instance = 0},
+        .page = std::uint32_t(random() % pages),
+    };
+  }
+  std::ranges::stable_sort(candidates, {}, &Candidate::page);
+  std::vector<IndirectDrawList::Batch> batches;
+  for (std::uint32_t i = 0; i != candidates.size(); ++i) {
+    auto &candidate = candidates[i];
+    if (batches.empty() || batches.back().page != candidate.page) {
+      batches.push_back({.page = candidate.page, .first = i, .count = 0});
+    }
+    ++batches.back().count;
+    // The first instance tells the candidates apart in the output
+    candidate.command.first_instance = i;
+    candidate.output_base = batches.back().first;
+    candidate.page = std::uint32_t(batches.size() - 1);
+  }
+
+  std::uniform_real_distribution<float> direction(-1, 1);
+  std::vector<DrawIndirectCommand> commands;
+  std::vector<std::uint32_t> counters;
+  for (int view = 0; view != 8; ++view) {
+    auto gaze = glm::normalize(glm::vec3(direction(random), direction(random) * .5f, direction(random)));
+    glm::vec3 position(direction(random) * 16, 80, direction(random) * 16);
+    auto projection = glm::perspectiveRH_ZO(1.2f, 1.5f, .1f, 256.f);
+    projection[1][1] = -projection[1][1];
+    auto view_projection = projection * glm::lookAt(position, position + gaze, {0, 1, 0});
+    Frustum frustum(view_projection);
+    context.Cull(view_projection, candidates, batches.size(), commands, counters);
+
+    for (std::size_t b = 0; b != batches.size(); ++b) {
+      auto &batch = batches[b];
+      // The CPU decides every candidate except the ones on a plane
+      std::vector<char> expected(batch.count), undecided(batch.count), written(batch.count);
+      std::uint32_t visible = 0, uncertain = 0;
+      for (std::uint32_t i = 0; i != batch.count; ++i) {
+        auto &candidate = candidates[batch.first + i];
+        undecided[i] = GetPlaneMargin(frustum, candidate.min, candidate.max) < 1e-4f;
+        expected[i] = frustum.IsBoxVisible(candidate.min, candidate.max);
+        visible += expected[i] && !undecided[i];
+        uncertain += undecided[i];
+      }
+
+      // The compacted count is the CPU count, and the commands at the
+      // front of the page are the visible candidates, each once
+      auto count = counters[b];
+      VKMC_CHECK(count >= visible && count <= visible + uncertain);
+      for (std::uint32_t i = 0; i != batch.count; ++i) {
+        auto &command = commands[batch.first + i];
+        if (i >= count) {
+          VKMC_CHECK(command.instance_count == 0);
+          continue;
+        }
+        auto index = command.first_instance - batch.first;
+        VKMC_CHECK(index < batch.count);
+        if (index >= batch.count) {
+          continue;
+        }
+        VKMC_CHECK(!written[index]);
+        written[index] = true;
+        VKMC_CHECK(expected[index] || undecided[index]);
+        VKMC_CHECK(command.instance_count == candidates[batch.first + index].command.instance_count);
+      }
+      for (std::uint32_t i = 0; i != batch.count; ++i) {
+        VKMC_CHECK(written[i] || !expected[i] || undecided[i]);
+      }
+    }
+  }
+}
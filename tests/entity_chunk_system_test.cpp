@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include "../game/block/registry.h"
+#include "../game/job/worker_pool.h"
+#include "../game/physical/entity_chunk_system.h"
+#include "test.h"
+
+namespace {
+
+constexpr glm::vec3 kPlayerBox{.6f, 1.8f, .6f};
+constexpr float kTolerance = 2e-3f;
+
+/// Generated terrain around the origin. The area x, z in [0, 16) is made
+/// flat, stone up to kFloor and air above.
+class Terrain {
+public:
+  static constexpr int kFloor = 100;
+
+  Terrain() : workers_(2), chunks_(7, workers_) {
+    for (int x = -2; x <= 2; ++x) {
+      for (int z = -2; z <= 2; ++z) {
+        chunks_.Load(registry_, {x, z});
+      }
+    }
+    for (int x = 0; x != 16; ++x) {
+      for (int z = 0; z != 16; ++z) {
+        for (int y = 0; y != int(Chunk::kHeight); ++y) {
+          chunks_.SetBlock({x, y, z}, y <= kFloor ? 2 : blocks::kAir);
+        }
+      }
+    }
+  }
+
+  [[nodiscard]] ChunkManager &GetChunks() noexcept {
+    return chunks_;
+  }
+
+  /// The highest solid block of the column, -1 if there is none
+  [[nodiscard]] int GetTop(int x, int z) const noexcept {
+    for (auto y = int(Chunk::kHeight) - 1; y >= 0; --y) {
+      if (chunks_.GetBlock({x, y, z}) != blocks::kAir) {
+        return y;
+      }
+    }
+    return -1;
+  }
+
+  /// Whether the box of the entity is inside a block by more than the
+  /// tolerance
+  [[nodiscard]] bool Overlaps(const Entity &entity) const noexcept {
+    glm::ivec3 first = glm::floor(entity.position - entity.aabb * .5f + kTolerance);
+    glm::ivec3 last = glm::floor(entity.position + entity.aabb * .5f - kTolerance);
+    for (auto x = first.x; x <= last.x; ++x) {
+      for (auto y = first.y; y <= last.y; ++y) {
+        for (auto z = first.z; z <= last.z; ++z) {
+          if (chunks_.GetBlock({x, y, z}) != blocks::kAir) {
+            return true;
+          }
+        }
+      }
+    }
+    return false;
+  }
+
+private:
+  test::AssetsScope assets_;
+  BlockRegistry registry_;
+  WorkerPool workers_;
+  ChunkManager chunks_;
+};
+
+/// Push the entity with the acceleration for a number of steps
+void Push(EntityChunkSystem &system, Entity &entity, const ChunkManager &chunks, glm::vec3 acceleration, int steps) {
+  for (int i = 0; i != steps; ++i) {
+    entity.acceleration = acceleration;
+    system.Update(entity, chunks, EntityChunkSystem::kStep);
+  }
+}
+
+/// An entity standing on the floor of the flat area
+Entity MakeStanding(Terrain &terrain, EntityChunkSystem &system, glm::vec3 position) {
+  Entity entity{.aabb = kPlayerBox, .position = position, .velocity = {}, .acceleration = {}};
+  Push(system, entity, terrain.GetChunks(), {0, -.1f, 0}, 200);
+  return entity;
+}
+
+} // namespace
+
+VKMC_TEST(EntityLandsOnTheFloor) {
+  Terrain terrain;
+  EntityChunkSystem system;
+  auto entity = MakeStanding(terrain, system, {5.5f, Terrain::kFloor + 10, 5.5f});
+  auto bottom = entity.position.y - kPlayerBox.y * .5f;
+  VKMC_CHECK(std::abs(bottom - float(Terrain::kFloor + 1)) < kTolerance);
+  VKMC_CHECK(!terrain.Overlaps(entity));
+}
+
+VKMC_TEST(EntityStopsAtWallAndSlides) {
+  Terrain terrain;
+  auto &chunks = terrain.GetChunks();
+  for (int y = Terrain::kFloor + 1; y != Terrain::kFloor + 5; ++y) {
+    for (int z = 3; z != 12; ++z) {
+      chunks.SetBlock({8, y, z}, 2);
+    }
+  }
+  EntityChunkSystem system;
+  auto entity = MakeStanding(terrain, system, {5.5f, Terrain::kFloor + 2, 5.5f});
+  entity.position.y += .01f;
+
+  Push(system, entity, chunks, {.1f, 0, 0}, 100);
+  VKMC_CHECK(std::abs(entity.position.x + kPlayerBox.x * .5f - 8) < kTolerance);
+
+  // Moving diagonally into the wall only moves along it
+  auto z = entity.position.z;
+  Push(system, entity, chunks, glm::normalize(glm::vec3(.1f, 0, .05f)) * .1f, 10);
+  VKMC_CHECK(std::abs(entity.position.x + kPlayerBox.x * .5f - 8) < kTolerance);
+  VKMC_CHECK(entity.position.z > z + .5f);
+  VKMC_CHECK(!terrain.Overlaps(entity));
+}
+
+VKMC_TEST(EntityTouchingBlockDoesNotMoveBack) {
+  Terrain terrain;
+  auto &chunks = terrain.GetChunks();
+  for (int y = Terrain::kFloor + 1; y != Terrain::kFloor + 5; ++y) {
+    chunks.SetBlock({8, y, 5}, 2);
+    chunks.SetBlock({2, y, 5}, 2);
+  }
+  EntityChunkSystem system;
+
+  // Inside the wall by less than the contact tolerance of the system
+  for (auto direction : {1.f, -1.f}) {
+    auto face = direction > 0 ? 8.f : 3.f;
+    Entity entity{
+        .aabb = kPlayerBox,
+        .position = {face - direction * (kPlayerBox.x * .5f - 5e-4f), Terrain::kFloor + 2, 5.5f},
+        .velocity = {},
+        .acceleration = {},
+    };
+    auto x = entity.position.x;
+    Push(system, entity, chunks, {direction * .1f, 0, 0}, 5);
+    VKMC_CHECK(entity.position.x == x);
+  }
+}
+
+VKMC_TEST(EntityStepsAreDeterministic) {
+  Terrain terrain;
+  auto &chunks = terrain.GetChunks();
+  std::mt19937 random(3);
+  std::uniform_real_distribution<float> component(-1, 1);
+  std::vector<glm::vec3> accelerations(3000);
+  for (auto &acceleration : accelerations) {
+    acceleration = glm::normalize(glm::vec3(component(random), component(random) - .3f, component(random))) * .1f;
+  }
+
+  Entity updated{.aabb = kPlayerBox, .position = {.5f, 120, .5f}, .velocity = {}, .acceleration = {}};
+  auto stepped = updated;
+  EntityChunkSystem update_system, step_system;
+  for (auto &acceleration : accelerations) {
+    updated.acceleration = acceleration;
+    update_system.Update(updated, chunks, EntityChunkSystem::kStep);
+    stepped.acceleration = acceleration;
+    step_system.Step(stepped, chunks);
+  }
+  VKMC_CHECK(updated.position == stepped.position);
+}
+
+VKMC_TEST(EntityUpdateTakesWholeSteps) {
+  Terrain terrain;
+  auto &chunks = terrain.GetChunks();
+
+  // A second of 144 Hz frames is 60 steps, give or take the rounding
+  Entity entity{.aabb = kPlayerBox, .position = {.5f, 120, .5f}, .velocity = {}, .acceleration = {}};
+  EntityChunkSystem system;
+  int steps = 0;
+  for (int frame = 0; frame != 144; ++frame) {
+    entity.acceleration = {0, -.1f, 0};
+    steps += system.Update(entity, chunks, 1. / 144);
+  }
+  VKMC_CHECK(steps >= 59 && steps <= 60);
+
+  // A long frame is cut to kMaxSteps and the rest is dropped
+  EntityChunkSystem stalled;
+  VKMC_CHECK(stalled.Update(entity, chunks, 10.) == EntityChunkSystem::kMaxSteps);
+  VKMC_CHECK(stalled.Update(entity, chunks, 0.) == 0);
+}
+
+VKMC_TEST(EntityNeverEntersBlocks) {
+  Terrain terrain;
+  auto &chunks = terrain.GetChunks();
+  std::mt19937 random(9);
+  std::uniform_real_distribution<float> component(-1, 1);
+  std::size_t overlaps = 0;
+  for (int run = 0; run != 20; ++run) {
+    Entity entity{.aabb = kPlayerBox, .position = {component(random) * 30, 0, component(random) * 30}, .velocity = {}, .acceleration = {}};
+    // Above the highest of the columns under the box
+    auto top = 0;
+    for (auto dx : {-.3f, .3f}) {
+      for (auto dz : {-.3f, .3f}) {
+        top = std::max(top, terrain.GetTop(int(std::floor(entity.position.x + dx)), int(std::floor(entity.position.z + dz))));
+      }
+    }
+    entity.position.y = float(top + 2);
+    VKMC_CHECK(!terrain.Overlaps(entity));
+
+    EntityChunkSystem system;
+    glm::vec3 acceleration{};
+    for (int i = 0; i != 2000; ++i) {
+      if (i % 30 == 0) {
+        acceleration = glm::normalize(glm::vec3(component(random), component(random) - .5f, component(random))) * .1f;
+      }
+      entity.acceleration = acceleration;
+      system.Step(entity, chunks);
+      // The loaded chunks end at 80 blocks
+      if (std::abs(entity.position.x) > 60 || std::abs(entity.position.z) > 60) {
+        break;
+      }
+      if (terrain.Overlaps(entity)) {
+        ++overlaps;
+        break;
+      }
+    }
+  }
+  VKMC_CHECK(overlaps == 0);
+}
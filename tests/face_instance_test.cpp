@@ -0,0 +1,135 @@
+#include <memory>
+#include <random>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "../game/mesh/face_instance.h"
+#include "../game/mesh/mesher.h"
+#include "test.h"
+
+namespace {
+
+/// The decode of assets/shaders/block.vert, written with the same masks
+/// and shifts so a change to FaceInstance without the shader fails here
+struct ShaderFace {
+  glm::uvec3 position;
+  std::uint32_t direction;
+  glm::uvec2 extent;
+  std::uint32_t texture_id;
+  std::uint32_t slot;
+};
+
+ShaderFace DecodeAsShader(const FaceInstance &face) {
+  auto packed = face.packed;
+  auto texture_slot = face.texture_slot;
+  return {
+      .position = {packed & 31u, (packed >> 5) & 31u, (packed >> 10) & 31u},
+      .direction = (packed >> 15) & 7u,
+      .extent = glm::uvec2((packed >> 18) & 31u, (packed >> 23) & 31u) + 1u,
+      .texture_id = texture_slot & 0xfffu,
+      .slot = texture_slot >> 12,
+  };
+}
+
+/// The two axes each face spans, face_axes of block.vert
+constexpr glm::ivec2 kFaceAxes[6] = {{0, 1}, {0, 1}, {2, 1}, {2, 1}, {0, 2}, {0, 2}};
+
+using UnitFace = std::tuple<int, int, int, std::uint32_t, TextureId>;
+
+/// Split the faces into unit faces, fails on a face leaving the section
+/// or a unit face covered twice
+std::set<UnitFace> ExpandFaces(const std::vector<FaceInstance> &faces) {
+  constexpr int kLength = ChunkSection::kLength;
+  std::set<UnitFace> units;
+  for (auto &face : faces) {
+    auto position = face.GetPosition();
+    auto extent = face.GetExtent();
+    auto axes = kFaceAxes[std::uint32_t(face.GetFace())];
+    VKMC_CHECK(position[axes.x] + int(extent.x) <= kLength);
+    VKMC_CHECK(position[axes.y] + int(extent.y) <= kLength);
+    for (int i = 0; i != int(extent.x); ++i) {
+      for (int j = 0; j != int(extent.y); ++j) {
+        auto unit = position;
+        unit[axes.x] += i;
+        unit[axes.y] += j;
+        auto [it, added] = units.emplace(unit.x, unit.y, unit.z, std::uint32_t(face.GetFace()), face.GetTexture());
+        VKMC_CHECK(added);
+      }
+    }
+  }
+  return units;
+}
+
+} // namespace
+
+VKMC_TEST(FaceInstanceRoundTrips) {
+  std::mt19937 random(13);
+  std::uniform_int_distribution<int> position(0, 31);
+  std::uniform_int_distribution<std::uint32_t> extent(1, 32);
+  std::uniform_int_distribution<std::uint32_t> direction(0, 5);
+  std::uniform_int_distribution<std::uint32_t> texture(0, FaceInstance::kMaxTextures - 1);
+  std::uniform_int_distribution<std::uint32_t> slot(0, FaceInstance::kMaxSlots - 1);
+  for (int i = 0; i != 10000; ++i) {
+    auto face = FaceDirection(direction(random));
+    glm::ivec3 p(position(random), position(random), position(random));
+    glm::uvec2 e(extent(random), extent(random));
+    auto t = texture(random);
+    auto s = slot(random);
+    // The extremes of every field
+    if (i == 0) {
+      p = glm::ivec3(31), e = glm::uvec2(32), t = FaceInstance::kMaxTextures - 1, s = FaceInstance::kMaxSlots - 1;
+    } else if (i == 1) {
+      p = glm::ivec3(0), e = glm::uvec2(1), t = 0, s = 0;
+    }
+
+    auto packed = FaceInstance::Pack(face, t, p, e, s);
+    VKMC_CHECK(packed.GetFace() == face);
+    VKMC_CHECK(packed.GetPosition() == p);
+    VKMC_CHECK(packed.GetExtent() == e);
+    VKMC_CHECK(packed.GetTexture() == t);
+    VKMC_CHECK(packed.GetSlot() == s);
+
+    auto shader = DecodeAsShader(packed);
+    VKMC_CHECK(shader.direction == std::uint32_t(face));
+    VKMC_CHECK(glm::ivec3(shader.position) == p);
+    VKMC_CHECK(shader.extent == e);
+    VKMC_CHECK(shader.texture_id == t);
+    VKMC_CHECK(shader.slot == s);
+  }
+}
+
+VKMC_TEST(FaceInstanceGreedyCoversPerFace) {
+  test::AssetsScope assets;
+  BlockRegistry registry;
+  ChunkMesher mesher(registry);
+
+  // Layers of stone and sand with holes, so there are both long merged
+  // faces and faces cut by neighbours
+  std::mt19937 random(2);
+  std::bernoulli_distribution hole(0.05);
+  Chunk chunk;
+  for (int y = 32; y != 64; ++y) {
+    for (int z = 0; z != 32; ++z) {
+      for (int x = 0; x != 32; ++x) {
+        if (!hole(random)) {
+          chunk.Set(x, y, z, y % 3 == 0 ? 3 : 2);
+        }
+      }
+    }
+  }
+
+  auto input = std::make_unique<ChunkMeshInput>();
+  input->Capture({0, 0}, 1, chunk, nullptr, nullptr, nullptr, nullptr);
+  input->slot = 7;
+
+  std::vector<FaceInstance> per_face(ChunkMesher::kMaxFaces), greedy(ChunkMesher::kMaxFaces);
+  per_face.resize(mesher.Generate(MeshingMode::kPerFace, *input, per_face.data()));
+  greedy.resize(mesher.Generate(MeshingMode::kGreedy, *input, greedy.data()));
+  VKMC_CHECK(!per_face.empty());
+  VKMC_CHECK(greedy.size() < per_face.size());
+  for (auto &face : greedy) {
+    VKMC_CHECK(face.GetSlot() == 7);
+  }
+  VKMC_CHECK(ExpandFaces(greedy) == ExpandFaces(per_face));
+}
@@ -0,0 +1,128 @@
+#include <cmath>
+#include <random>
+
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/geometric.hpp>
+
+#include "../game/render/frustum.h"
+#include "test.h"
+
+namespace {
+
+/// The view projection of Camera, built here with the [0, 1] depth the
+/// game is compiled with
+glm::mat4 CreateViewProjection(const glm::vec3 &position, const glm::vec3 &gaze, float aspect) {
+  auto projection = glm::perspectiveRH_ZO(1.2f, aspect, .1f, 128.f);
+  projection[1][1] = -projection[1][1];
+  return projection * glm::lookAt(position, position + gaze, {0, 1, 0});
+}
+
+/// The culling test done plane by plane without SIMD, and the smallest
+/// distance to a plane relative to the magnitude of its terms
+bool IsBoxVisibleScalar(const Frustum &frustum, const glm::vec3 &min, const glm::vec3 &max, float &margin) {
+  auto center = (min + max) * .5f, extent = (max - min) * .5f;
+  margin = INFINITY;
+  bool visible = true;
+  for (int i = 0; i != 6; ++i) {
+    auto plane = frustum.GetPlane(i);
+    auto normal = glm::vec3(plane);
+    auto outside = glm::dot(normal, center) + plane.w + glm::dot(glm::abs(normal), extent);
+    auto magnitude = glm::dot(glm::abs(normal), glm::abs(center) + extent) + std::abs(plane.w);
+    margin = std::min(margin, std::abs(outside) / magnitude);
+    visible = visible && outside >= 0;
+  }
+  return visible;
+}
+
+/// Whether the point is in the view volume by its clip coordinates
+bool IsPointInClipSpace(const glm::mat4 &view_projection, const glm::vec3 &point) {
+  auto clip = view_projection * glm::vec4(point, 1);
+  return clip.w > 0 && std::abs(clip.x) <= clip.w && std::abs(clip.y) <= clip.w && clip.z >= 0 && clip.z <= clip.w;
+}
+
+} // namespace
+
+VKMC_TEST(FrustumPlanesMatchClipSpace) {
+  // Each plane is a combination of clip coordinates: w + x, w - x,
+  // w + y, w - y, z and w - z
+  std::mt19937 random(2);
+  std::uniform_real_distribution<float> coordinate(-100, 100), direction(-1, 1);
+  for (int i = 0; i != 100; ++i) {
+    auto gaze = glm::normalize(glm::vec3(direction(random), direction(random) * .5f, direction(random)));
+    auto view_projection = CreateViewProjection({coordinate(random), 70, coordinate(random)}, gaze, 1.5f);
+    Frustum frustum(view_projection);
+    for (int j = 0; j != 100; ++j) {
+      glm::vec4 point(coordinate(random), coordinate(random), coordinate(random), 1);
+      auto clip = view_projection * point;
+      float expected[6]{clip.w + clip.x, clip.w - clip.x, clip.w + clip.y, clip.w - clip.y, clip.z, clip.w - clip.z};
+      for (int k = 0; k != 6; ++k) {
+        auto distance = glm::dot(frustum.GetPlane(k), point);
+        VKMC_CHECK(std::abs(distance - expected[k]) <= 1e-3f * (1 + std::abs(expected[k])));
+      }
+    }
+  }
+}
+
+VKMC_TEST(FrustumMatchesScalarReference) {
+  std::mt19937 random(1);
+  std::uniform_real_distribution<float> coordinate(-200, 200), size(1, 40), direction(-1, 1);
+  std::size_t visible = 0, undecided = 0;
+  for (int i = 0; i != 20; ++i) {
+    auto gaze = glm::normalize(glm::vec3(direction(random), direction(random) * .5f, direction(random)));
+    Frustum frustum(CreateViewProjection({coordinate(random), 70, coordinate(random)}, gaze, 1.3f));
+    for (int j = 0; j != 10000; ++j) {
+      glm::vec3 min(coordinate(random), coordinate(random) * .5f + 70, coordinate(random));
+      auto max = min + glm::vec3(size(random), size(random), size(random));
+      float margin;
+      auto expected = IsBoxVisibleScalar(frustum, min, max, margin);
+      // The SIMD sums round differently, a box on a plane may go either way
+      if (margin < 1e-5f) {
+        ++undecided;
+        continue;
+      }
+      VKMC_CHECK(frustum.IsBoxVisible(min, max) == expected);
+      visible += expected;
+    }
+  }
+  // Both outcomes are covered
+  VKMC_CHECK(visible > 1000 && visible < 190000);
+  VKMC_CHECK(undecided < 200);
+}
+
+VKMC_TEST(FrustumNeverCullsVisibleBoxes) {
+  // A box with any point inside the view volume must be kept
+  glm::vec3 position(5, 70, 3);
+  auto view_projection = CreateViewProjection(position, glm::normalize(glm::vec3(.3f, -.2f, -1)), 1.3f);
+  Frustum frustum(view_projection);
+  std::mt19937 random(3);
+  std::uniform_real_distribution<float> coordinate(-200, 200);
+  std::size_t culled = 0;
+  for (int i = 0; i != 50000; ++i) {
+    glm::vec3 min(coordinate(random), coordinate(random) * .5f + 70, coordinate(random));
+    auto max = min + glm::vec3(32);
+    auto visible = frustum.IsBoxVisible(min, max);
+    culled += !visible;
+    for (int k = 0; k != 64 && !visible; ++k) {
+      auto sample = min + glm::vec3(k & 3, k >> 2 & 3, k >> 4) / 3.f * 32.f;
+      VKMC_CHECK(!IsPointInClipSpace(view_projection, sample));
+    }
+  }
+  VKMC_CHECK(culled > 10000);
+}
+
+VKMC_TEST(FrustumCullsBoxesAroundTheView) {
+  glm::vec3 position(0, 70, 0);
+  Frustum frustum(CreateViewProjection(position, {0, 0, -1}, 1));
+  auto box = [&](glm::vec3 center, float half) {
+    return frustum.IsBoxVisible(center - half, center + half);
+  };
+  VKMC_CHECK(box(position, .5f));
+  VKMC_CHECK(box(position + glm::vec3(0, 0, -20), 1));
+  // Behind, beyond the far plane, and far to the side, above and below
+  VKMC_CHECK(!box(position + glm::vec3(0, 0, 20), 1));
+  VKMC_CHECK(!box(position + glm::vec3(0, 0, -200), 1));
+  VKMC_CHECK(!box(position + glm::vec3(100, 0, -20), 1));
+  VKMC_CHECK(!box(position + glm::vec3(0, 100, -20), 1));
+  VKMC_CHECK(!box(position + glm::vec3(0, -100, -20), 1));
+}
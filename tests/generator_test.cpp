@@ -0,0 +1,32 @@
+#include <algorithm>
+#include <cstdint>
+
+#include "../game/block/registry.h"
+#include "../game/chunk/generator.h"
+#include "test.h"
+
+VKMC_TEST(GeneratorStaysBelowMaxHeight) {
+  test::AssetsScope assets;
+  BlockRegistry registry;
+  ChunkGenerator generator(114514);
+  // Chunks far apart to meet plains and mountains
+  std::int32_t highest = 0;
+  for (std::int32_t x = -40; x <= 40; x += 8) {
+    for (std::int32_t z = -40; z <= 40; z += 8) {
+      Chunk chunk;
+      generator.Generate(registry, chunk, x, z);
+      for (std::int32_t bx = 0; bx != std::int32_t(Chunk::kLength); ++bx) {
+        for (std::int32_t bz = 0; bz != std::int32_t(Chunk::kLength); ++bz) {
+          for (auto y = std::int32_t(Chunk::kHeight) - 1; y > highest; --y) {
+            if (chunk(bx, y, bz) != blocks::kAir) {
+              highest = y;
+              break;
+            }
+          }
+        }
+      }
+    }
+  }
+  VKMC_CHECK(highest > ChunkGenerator::kMaxHeight / 2);
+  VKMC_CHECK(highest < ChunkGenerator::kMaxHeight);
+}
@@ -0,0 +1,53 @@
+#include "../game/render/indirect.h"
+#include "test.h"
+
+VKMC_TEST(IndirectMergesAdjacentDrawsPerPage) {
+  IndirectDrawList list(4);
+  list.Add(1, 100, 10);
+  list.Add(0, 50, 5);
+  list.Add(0, 0, 50);
+  list.Add(1, 110, 3);
+  list.Add(0, 60, 1);
+  list.Add(1, 0, 0);
+  VKMC_CHECK(list.GetDrawCount() == 5);
+  list.Build();
+
+  // Page 0: [0, 55) merged and [60, 61) apart, page 1: [100, 113) merged
+  auto batches = list.GetBatches();
+  VKMC_CHECK(batches.size() == 2);
+  VKMC_CHECK(batches[0].page == 0 && batches[0].first == 0 && batches[0].count == 2);
+  VKMC_CHECK(batches[1].page == 1 && batches[1].first == 2 && batches[1].count == 1);
+
+  auto commands = list.GetCommands();
+  VKMC_CHECK(commands.size() == 3);
+  VKMC_CHECK(commands[0].first_instance == 0 && commands[0].instance_count == 55);
+  VKMC_CHECK(commands[1].first_instance == 60 && commands[1].instance_count == 1);
+  VKMC_CHECK(commands[2].first_instance == 100 && commands[2].instance_count == 13);
+  for (auto &command : commands) {
+    VKMC_CHECK(command.vertex_count == 4 && command.first_vertex == 0);
+  }
+}
+
+VKMC_TEST(IndirectDoesNotMergeAcrossPages) {
+  // The end of a range in page 0 is the start of one in page 1
+  IndirectDrawList list(4);
+  list.Add(0, 0, 10);
+  list.Add(1, 10, 10);
+  list.Build();
+  VKMC_CHECK(list.GetBatches().size() == 2);
+  VKMC_CHECK(list.GetCommands().size() == 2);
+}
+
+VKMC_TEST(IndirectClearsAndRebuilds) {
+  IndirectDrawList list(4);
+  list.Add(2, 0, 8);
+  list.Build();
+  list.Build();
+  VKMC_CHECK(list.GetCommands().size() == 1);
+  VKMC_CHECK(list.GetBatches().size() == 1);
+
+  list.Clear();
+  VKMC_CHECK(list.GetDrawCount() == 0);
+  list.Build();
+  VKMC_CHECK(list.GetCommands().empty() && list.GetBatches().empty());
+}
@@ -0,0 +1,202 @@
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "../game/chunk/journal.h"
+#include "../game/chunk/manager.h"
+#include "../game/chunk/storage.h"
+#include "test.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/// What a crash would leave on the disk, the storage must be flushed
+void CopySaves(const fs::path &from, const fs::path &to) {
+  fs::remove_all(to);
+  fs::copy(from, to, fs::copy_options::recursive);
+}
+
+} // namespace
+
+VKMC_TEST(JournalSavesOnlyEditedChunks) {
+  test::AssetsScope assets;
+  test::TemporaryDirectory directory("vkmc_journal_edited");
+  BlockRegistry registry;
+  WorkerPool workers(2);
+  {
+    ChunkStorage storage(directory.GetPath());
+    ChunkManager manager(7, workers);
+    manager.SetStorage(&storage);
+    for (int x = 0; x != 4; ++x) {
+      manager.Load(registry, {x, 0});
+    }
+    manager.SetBlock({40, 100, 5}, 2);
+    manager.SetBlock({41, 100, 5}, 3);
+    manager.Unload({0, 0});
+    manager.Unload({1, 0});
+    storage.Flush();
+    VKMC_CHECK(storage.GetJournalSize() == 2 * 24);
+  }
+
+  // The manager saved the edited chunk and emptied the journal
+  std::size_t regions = 0;
+  for (auto &entry : fs::directory_iterator(directory.GetPath())) {
+    regions += entry.path().extension() == ".vkr";
+  }
+  VKMC_CHECK(regions == 1);
+  VKMC_CHECK(fs::file_size(directory.GetPath() / "journal.log") == 0);
+
+  ChunkStorage storage(directory.GetPath());
+  ChunkManager manager(7, workers);
+  manager.SetStorage(&storage);
+  manager.Recover(registry);
+  manager.Load(registry, {1, 0});
+  VKMC_CHECK(manager.GetBlock({40, 100, 5}) == 2);
+  VKMC_CHECK(manager.GetBlock({41, 100, 5}) == 3);
+}
+
+VKMC_TEST(JournalReplaysAfterCrash) {
+  test::AssetsScope assets;
+  test::TemporaryDirectory directory("vkmc_journal_crash");
+  test::TemporaryDirectory crashed("vkmc_journal_crashed");
+  BlockRegistry registry;
+  WorkerPool workers(2);
+  {
+    ChunkStorage storage(directory.GetPath());
+    ChunkManager manager(7, workers);
+    manager.SetStorage(&storage);
+    manager.Load(registry, {1, 0});
+    manager.SetBlock({40, 100, 5}, 2);
+    manager.SetBlock({41, 100, 5}, 3);
+    manager.Checkpoint();
+
+    // Only in the journal, the last edit of a position wins
+    manager.Load(registry, {5, 5});
+    manager.SetBlock({165, 10, 170}, 3);
+    manager.SetBlock({165, 10, 170}, 1);
+    manager.SetBlock({40, 100, 5}, 0);
+    storage.Flush();
+    CopySaves(directory.GetPath(), crashed.GetPath());
+  }
+  // A record torn by the crash
+  std::ofstream(crashed.GetPath() / "journal.log", std::ios::app | std::ios::binary) << "torn";
+
+  ChunkStorage storage(crashed.GetPath());
+  ChunkManager manager(7, workers);
+  manager.SetStorage(&storage);
+  manager.Recover(registry);
+  VKMC_CHECK(fs::file_size(crashed.GetPath() / "journal.log") == 0);
+  manager.Load(registry, {5, 5});
+  manager.Load(registry, {1, 0});
+  VKMC_CHECK(manager.GetBlock({165, 10, 170}) == 1);
+  VKMC_CHECK(manager.GetBlock({40, 100, 5}) == 0);
+  VKMC_CHECK(manager.GetBlock({41, 100, 5}) == 3);
+}
+
+VKMC_TEST(JournalKeepsEditsAfterCheckpointRequest) {
+  test::AssetsScope assets;
+  test::TemporaryDirectory directory("vkmc_journal_request");
+  test::TemporaryDirectory crashed("vkmc_journal_requested");
+  BlockRegistry registry;
+  WorkerPool workers(2);
+
+  // Edits cycling over a box of positions until the journal is full
+  constexpr int kPositions = 32 * 32 * 32;
+  auto get_position = [](int i) {
+    i %= kPositions;
+    return glm::ivec3(i & 31, 100 + (i >> 5 & 31), i >> 10);
+  };
+  std::vector<BlockId> expected(kPositions, blocks::kAir);
+  {
+    ChunkStorage storage(directory.GetPath());
+    ChunkManager manager(7, workers);
+    manager.SetStorage(&storage);
+    manager.Load(registry, {0, 0});
+    for (int i = 0; i != kPositions; ++i) {
+      expected[i] = manager.GetBlock(get_position(i));
+    }
+
+    int edits = 0;
+    while (!storage.IsCheckpointPending() && edits != 1 << 20) {
+      auto block = BlockId(edits / kPositions % 3);
+      manager.SetBlock(get_position(edits), block);
+      expected[edits % kPositions] = block;
+      ++edits;
+    }
+    VKMC_CHECK(storage.IsCheckpointPending());
+
+    // Recorded while the writer does the checkpoint, they must outlive
+    // the emptied journal
+    for (int i = 0; i != 10; ++i) {
+      manager.SetBlock(get_position(i), 3);
+      expected[i] = 3;
+    }
+    storage.Flush();
+    VKMC_CHECK(!storage.IsCheckpointPending());
+    VKMC_CHECK(storage.GetJournalSize() == 10 * 24);
+    CopySaves(directory.GetPath(), crashed.GetPath());
+  }
+
+  ChunkStorage storage(crashed.GetPath());
+  ChunkManager manager(7, workers);
+  manager.SetStorage(&storage);
+  manager.Recover(registry);
+  manager.Load(registry, {0, 0});
+  std::size_t wrong = 0;
+  for (int i = 0; i != kPositions; ++i) {
+    wrong += manager.GetBlock(get_position(i)) != expected[i];
+  }
+  VKMC_CHECK(wrong == 0);
+}
+
+#ifndef _WIN32
+VKMC_TEST(JournalKeepsFileWhenClearFails) {
+  test::TemporaryDirectory directory("vkmc_journal_clear");
+  auto path = directory.GetPath() / "journal.log";
+  BlockEdit edit{.chunk = {1, -2}, .position = {3, 4, 5}, .old_block = 0, .new_block = 2};
+  {
+    BlockJournal journal(path);
+    journal.Append({&edit, 1});
+
+    // A directory in place of the file can not be opened for writing
+    fs::remove(path);
+    fs::create_directory(path);
+    VKMC_CHECK_THROWS(journal.Clear(), std::runtime_error);
+    VKMC_CHECK(journal.GetSize() == 24);
+    journal.Append({&edit, 1});
+    VKMC_CHECK(journal.GetSize() == 2 * 24);
+  }
+  fs::remove(path);
+
+  BlockJournal journal(path);
+  journal.Append({&edit, 1});
+  journal.Clear();
+  journal.Append({&edit, 1});
+  VKMC_CHECK(journal.GetSize() == 24);
+  VKMC_CHECK(fs::file_size(path) == 24);
+}
+#endif
+
+VKMC_TEST(JournalCheckpointCopiesFromPool) {
+  test::AssetsScope assets;
+  test::TemporaryDirectory directory("vkmc_journal_pool");
+  BlockRegistry registry;
+  WorkerPool workers(2);
+  ChunkStorage storage(directory.GetPath());
+  ChunkManager manager(7, workers);
+  manager.SetStorage(&storage);
+  manager.Load(registry, {0, 0});
+  manager.Load(registry, {1, 0});
+  manager.SetBlock({5, 100, 5}, 2);
+  manager.SetBlock({40, 100, 5}, 3);
+
+  // A copy of each edited chunk, returned once written
+  auto before = manager.GetPoolStats();
+  manager.Checkpoint();
+  auto after = manager.GetPoolStats();
+  VKMC_CHECK(after.hits == before.hits + 2 && after.misses == before.misses);
+  VKMC_CHECK(after.in_use == before.in_use);
+  VKMC_CHECK(manager.GetBlock({5, 100, 5}) == 2 && manager.GetBlock({40, 100, 5}) == 3);
+}
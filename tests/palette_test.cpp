@@ -0,0 +1,143 @@
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "../game/chunk/palette.h"
+#include "test.h"
+
+namespace {
+
+/// The number of blocks the storage reads differently from the reference
+std::size_t CountMismatches(const PaletteStorage &storage, const std::vector<BlockId> &reference) {
+  std::size_t mismatches = storage.GetSize() != reference.size();
+  for (std::size_t i = 0; i != reference.size(); ++i) {
+    mismatches += storage.Get(i) != reference[i];
+  }
+  return mismatches;
+}
+
+/// The narrowest index width for a palette size
+std::uint32_t GetNarrowestBits(std::size_t palette_size) {
+  std::uint32_t bits = 0;
+  while ((std::size_t(1) << bits) < palette_size) {
+    bits = bits == 0 ? 1 : bits * 2;
+  }
+  return bits;
+}
+
+} // namespace
+
+VKMC_TEST(PaletteSetMatchesVectorThroughEveryWidth) {
+  // Not a multiple of the indices in a word at any width too
+  for (std::size_t size : {4096, 1001}) {
+    std::mt19937 random{std::uint32_t(size)};
+    PaletteStorage storage(size);
+    std::vector<BlockId> reference(size, blocks::kAir);
+    std::vector<BlockId> used{blocks::kAir};
+    VKMC_CHECK(storage.GetBitsPerIndex() == 0 && storage.IsUniform());
+
+    // A new block at a time through 1, 2, 4, 8 and 16 bits, with blocks of
+    // the palette set in between
+    std::vector<std::uint32_t> widths{0};
+    std::size_t mismatches = 0, wrong_bits = 0;
+    for (BlockId block = 0; block != 300; ++block) {
+      auto position = random() % size;
+      storage.Set(position, block);
+      reference[position] = block;
+      used.push_back(block);
+      if (storage.GetBitsPerIndex() != widths.back()) {
+        // Every index is read back right after the repack
+        widths.push_back(storage.GetBitsPerIndex());
+        mismatches += CountMismatches(storage, reference);
+      }
+
+      for (int i = 0; i != 50; ++i) {
+        position = random() % size;
+        auto id = used[random() % used.size()];
+        storage.Set(position, id);
+        reference[position] = id;
+      }
+      wrong_bits += storage.GetBitsPerIndex() != GetNarrowestBits(storage.GetPaletteSize());
+    }
+    VKMC_CHECK((widths == std::vector<std::uint32_t>{0, 1, 2, 4, 8, 16}));
+    VKMC_CHECK(storage.GetPaletteSize() == 301);
+    VKMC_CHECK(wrong_bits == 0);
+    VKMC_CHECK(mismatches == 0);
+    VKMC_CHECK(CountMismatches(storage, reference) == 0);
+  }
+}
+
+VKMC_TEST(PaletteSetOfKnownBlockKeepsWidth) {
+  PaletteStorage storage(100, 7);
+  storage.Set(3, 7);
+  VKMC_CHECK(storage.IsUniform() && storage.GetBitsPerIndex() == 0);
+  storage.Set(3, 8);
+  storage.Set(3, 7);
+  storage.Set(4, 8);
+  VKMC_CHECK(storage.GetPaletteSize() == 2 && storage.GetBitsPerIndex() == 1);
+  VKMC_CHECK(storage.Get(3) == 7 && storage.Get(4) == 8 && storage.Get(99) == 7);
+
+  storage.Fill(9);
+  VKMC_CHECK(storage.IsUniform() && storage.GetBitsPerIndex() == 0 && storage.Get(50) == 9);
+}
+
+VKMC_TEST(PaletteRestoresFromWords) {
+  std::mt19937 random(3);
+  PaletteStorage storage(1001);
+  std::vector<BlockId> reference(1001, blocks::kAir);
+  for (int i = 0; i != 2000; ++i) {
+    auto position = random() % reference.size();
+    auto block = BlockId(random() % 20);
+    storage.Set(position, block);
+    reference[position] = block;
+  }
+
+  auto palette = storage.GetPalette();
+  auto words = storage.GetWords();
+  PaletteStorage restored(
+      storage.GetSize(), {palette.begin(), palette.end()},
+      storage.GetBitsPerIndex(), {words.begin(), words.end()}
+  );
+  VKMC_CHECK(restored.GetBitsPerIndex() == 8);
+  VKMC_CHECK(CountMismatches(restored, reference) == 0);
+
+  // Then grows like any other storage
+  for (BlockId block = 100; block != 400; ++block) {
+    auto position = random() % reference.size();
+    restored.Set(position, block);
+    reference[position] = block;
+  }
+  VKMC_CHECK(restored.GetBitsPerIndex() == 16);
+  VKMC_CHECK(CountMismatches(restored, reference) == 0);
+
+  std::vector<BlockId> two{1, 2};
+  VKMC_CHECK_THROWS(PaletteStorage(64, two, 3, std::vector<std::uint64_t>(3)), std::runtime_error);
+  VKMC_CHECK_THROWS(PaletteStorage(64, two, 1, std::vector<std::uint64_t>(2)), std::runtime_error);
+  VKMC_CHECK_THROWS(PaletteStorage(64, {1, 2, 3}, 1, std::vector<std::uint64_t>(1)), std::runtime_error);
+  VKMC_CHECK_THROWS(PaletteStorage(64, {1}, 1, std::vector<std::uint64_t>(1)), std::runtime_error);
+}
+
+VKMC_TEST(PaletteThrowsPastSixteenBits) {
+  // A full 16 bit palette, restored as Set would take long to fill it
+  std::vector<BlockId> palette(PaletteStorage::kMaxPaletteSize);
+  for (std::size_t i = 0; i != palette.size(); ++i) {
+    palette[i] = BlockId(i);
+  }
+  std::vector<std::uint64_t> words(4096 * 16 / 64);
+  for (std::size_t i = 0; i != words.size(); ++i) {
+    // Indices 4i to 4i + 3
+    auto index = std::uint64_t(i * 4);
+    words[i] = index | (index + 1) << 16 | (index + 2) << 32 | (index + 3) << 48;
+  }
+  PaletteStorage storage(4096, std::move(palette), 16, std::move(words));
+  VKMC_CHECK(storage.Get(4095) == 4095);
+
+  VKMC_CHECK_THROWS(storage.Set(0, BlockId(PaletteStorage::kMaxPaletteSize)), std::runtime_error);
+  VKMC_CHECK(storage.GetPaletteSize() == PaletteStorage::kMaxPaletteSize);
+  VKMC_CHECK(storage.Get(0) == 0);
+  // Blocks of the palette can still be set
+  storage.Set(0, 60000);
+  VKMC_CHECK(storage.Get(0) == 60000 && storage.Get(1) == 1);
+}
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "../game/math/perlin.h"
+#include "test.h"
+
+namespace {
+
+/// Points the vector floor and hash get wrong most easily: signed zeros,
+/// lattice points and their neighbours, negative and random coordinates
+std::vector<float> MakeCoordinates() {
+  std::vector<float> coordinates{0.f, -0.f, .5f, -.5f, 1e-30f, -1e-30f, 1e6f, -1e6f, 16777216.f, -16777216.f};
+  for (int k = -600; k <= 600; k += 37) {
+    auto lattice = float(k);
+    coordinates.push_back(lattice);
+    coordinates.push_back(std::nextafter(lattice, -std::numeric_limits<float>::infinity()));
+    coordinates.push_back(std::nextafter(lattice, std::numeric_limits<float>::infinity()));
+  }
+  std::mt19937 random(11);
+  std::uniform_real_distribution<float> small(-4, 4), large(-3e4f, 3e4f);
+  for (int i = 0; i != 200; ++i) {
+    coordinates.push_back(small(random));
+    coordinates.push_back(large(random));
+  }
+  return coordinates;
+}
+
+/// The number of points whose batch result differs in any bit from the
+/// single point one, n points from the start
+std::size_t CountDifferences(const Perlin<512> &perlin, const std::vector<float> &x, const std::vector<float> &y, std::size_t start, std::size_t n) {
+  // One past the end stays untouched
+  constexpr float kGuard = 12345.f;
+  std::vector<float> dst(n + 1, kGuard);
+  perlin(x.data() + start, y.data() + start, dst.data(), n);
+  std::size_t differences = dst[n] != kGuard;
+  for (std::size_t i = 0; i != n; ++i) {
+    auto single = perlin(glm::vec2(x[start + i], y[start + i]));
+    differences += std::bit_cast<std::uint32_t>(dst[i]) != std::bit_cast<std::uint32_t>(single);
+  }
+  return differences;
+}
+
+} // namespace
+
+VKMC_TEST(PerlinBatchMatchesSingleBitForBit) {
+  std::mt19937 random(7);
+  Perlin<512> perlin(random);
+
+  // Every pair of the special coordinates, shuffled so a batch mixes them
+  auto coordinates = MakeCoordinates();
+  std::vector<float> x, y;
+  for (auto a : coordinates) {
+    for (auto b : coordinates) {
+      x.push_back(a);
+      y.push_back(b);
+    }
+  }
+  std::vector<std::size_t> order(x.size());
+  for (std::size_t i = 0; i != order.size(); ++i) {
+    order[i] = i;
+  }
+  std::shuffle(order.begin(), order.end(), random);
+  std::vector<float> shuffled_x(x.size()), shuffled_y(y.size());
+  for (std::size_t i = 0; i != order.size(); ++i) {
+    shuffled_x[i] = x[order[i]];
+    shuffled_y[i] = y[order[i]];
+  }
+
+  VKMC_CHECK(CountDifferences(perlin, x, y, 0, x.size()) == 0);
+  VKMC_CHECK(CountDifferences(perlin, shuffled_x, shuffled_y, 0, x.size()) == 0);
+}
+
+VKMC_TEST(PerlinBatchHandlesTails) {
+  std::mt19937 random(13);
+  Perlin<512> perlin(random);
+  auto coordinates = MakeCoordinates();
+  std::vector<float> x(coordinates.begin(), coordinates.end());
+  std::vector<float> y(coordinates.rbegin(), coordinates.rend());
+
+  // Below, at and past the widths of SSE2 and AVX2, at unaligned starts
+  std::size_t differences = 0;
+  for (std::size_t n : {0, 1, 3, 4, 7, 8, 9, 15, 16, 17}) {
+    for (std::size_t start : {0, 1, 5, 100}) {
+      differences += CountDifferences(perlin, x, y, start, n);
+    }
+  }
+  VKMC_CHECK(differences == 0);
+}
+
+VKMC_TEST(PerlinIsZeroOnLattice) {
+  std::mt19937 random(17);
+  Perlin<512> perlin(random);
+  std::vector<float> x, y;
+  for (int i = -20; i != 20; ++i) {
+    x.push_back(float(i * 3));
+    y.push_back(float(-i * 7));
+  }
+  std::vector<float> dst(x.size());
+  perlin(x.data(), y.data(), dst.data(), x.size());
+  std::size_t nonzero = 0;
+  for (auto value : dst) {
+    nonzero += value != 0;
+  }
+  VKMC_CHECK(nonzero == 0);
+}
@@ -0,0 +1,139 @@
+#include <cmath>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include "../game/block/registry.h"
+#include "../game/job/worker_pool.h"
+#include "../game/physical/raycast.h"
+#include "test.h"
+
+namespace {
+
+/// Generated terrain around the origin, loaded on construction
+class Terrain {
+public:
+  Terrain() : workers_(2), chunks_(7, workers_) {
+    for (int x = -3; x <= 3; ++x) {
+      for (int z = -3; z <= 3; ++z) {
+        chunks_.Load(registry_, {x, z});
+      }
+    }
+  }
+
+  [[nodiscard]] const ChunkManager &GetChunks() const noexcept {
+    return chunks_;
+  }
+
+  /// Rays from above and around the surface in random directions
+  [[nodiscard]] std::vector<Ray> MakeRays(std::size_t count) const {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> horizontal(-60, 60), height(40, 120), direction(-1, 1);
+    std::vector<Ray> rays;
+    while (rays.size() != count) {
+      Ray ray{
+          .origin = {horizontal(random), height(random), horizontal(random)},
+          .direction = {direction(random), direction(random), direction(random)},
+          .max_distance = 40,
+      };
+      if (glm::length(ray.direction) > 1e-3f) {
+        rays.push_back(ray);
+      }
+    }
+    return rays;
+  }
+
+private:
+  test::AssetsScope assets_;
+  BlockRegistry registry_;
+  WorkerPool workers_;
+  ChunkManager chunks_;
+};
+
+} // namespace
+
+VKMC_TEST(RaycastMatchesFineMarch) {
+  Terrain terrain;
+  auto &chunks = terrain.GetChunks();
+  std::size_t hits = 0, mismatches = 0;
+  for (auto &ray : terrain.MakeRays(3000)) {
+    auto hit = CastRay(chunks, ray);
+    hits += hit.has_value();
+
+    auto direction = glm::normalize(ray.direction);
+    std::optional<glm::ivec3> marched;
+    float distance = 0;
+    for (float t = 0; t <= ray.max_distance; t += 0.002f) {
+      glm::ivec3 block = glm::floor(ray.origin + direction * t);
+      if (chunks.GetBlock(block) != blocks::kAir) {
+        marched = block;
+        distance = t;
+        break;
+      }
+    }
+
+    // The march steps over the corner of a block a ray only grazes
+    if (hit.has_value() != marched.has_value() || (hit && hit->block != *marched)) {
+      mismatches += !(hit && marched && std::abs(hit->distance - distance) < 0.01f);
+    }
+  }
+  VKMC_CHECK(hits > 1000);
+  VKMC_CHECK(mismatches == 0);
+}
+
+VKMC_TEST(RaycastNormalFacesTheRay) {
+  Terrain terrain;
+  std::size_t checked = 0, wrong = 0;
+  for (auto &ray : terrain.MakeRays(3000)) {
+    auto hit = CastRay(terrain.GetChunks(), ray);
+    if (!hit || hit->distance == 0) {
+      continue;
+    }
+    ++checked;
+    // Just before the face the ray is in the block placed against it
+    auto direction = glm::normalize(ray.direction);
+    glm::ivec3 before = glm::floor(ray.origin + direction * (hit->distance - 1e-3f));
+    wrong += before != hit->block + hit->normal;
+    wrong += glm::dot(glm::vec3(hit->normal), direction) >= 0;
+    wrong += std::abs(hit->normal.x) + std::abs(hit->normal.y) + std::abs(hit->normal.z) != 1;
+  }
+  VKMC_CHECK(checked > 500);
+  VKMC_CHECK(wrong == 0);
+}
+
+VKMC_TEST(RaycastBatchMatchesSingle) {
+  Terrain terrain;
+  auto rays = terrain.MakeRays(3000);
+  std::vector<std::optional<RayHit>> hits(rays.size());
+  CastRays(terrain.GetChunks(), rays, hits);
+  std::size_t different = 0;
+  for (std::size_t i = 0; i != rays.size(); ++i) {
+    auto hit = CastRay(terrain.GetChunks(), rays[i]);
+    different += hit.has_value() != hits[i].has_value() ||
+                 (hit && (hit->block != hits[i]->block || hit->normal != hits[i]->normal ||
+                          hit->distance != hits[i]->distance));
+  }
+  VKMC_CHECK(different == 0);
+}
+
+VKMC_TEST(RaycastVertical) {
+  Terrain terrain;
+  auto &chunks = terrain.GetChunks();
+  auto down = CastRay(chunks, {.origin = {0.5f, 200, 0.5f}, .direction = {0, -1, 0}, .max_distance = 300});
+  VKMC_CHECK(down && down->normal == glm::ivec3(0, 1, 0));
+  VKMC_CHECK(down && chunks.GetBlock(down->block + glm::ivec3(0, 1, 0)) == blocks::kAir);
+  VKMC_CHECK(down && std::abs(down->distance - (200 - float(down->block.y + 1))) < 1e-4f);
+
+  // Leaves the top of the world
+  VKMC_CHECK(!CastRay(chunks, {.origin = {0.5f, 250, 0.5f}, .direction = {0, 1, 0}, .max_distance = 300}));
+
+  // Starts in the block it hits
+  if (down) {
+    auto inside = glm::vec3(down->block) + 0.5f;
+    auto hit = CastRay(chunks, {.origin = inside, .direction = {1, 0, 0}, .max_distance = 10});
+    VKMC_CHECK(hit && hit->block == down->block && hit->distance == 0 && hit->normal == glm::ivec3(0));
+  }
+}
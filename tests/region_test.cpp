@@ -0,0 +1,226 @@
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "../game/chunk/codec.h"
+#include "../game/chunk/region.h"
+#include "test.h"
+
+namespace {
+
+bool IsSameChunk(const Chunk &a, const Chunk &b) {
+  for (int y = 0; y != int(Chunk::kHeight); ++y) {
+    for (int z = 0; z != int(Chunk::kLength); ++z) {
+      for (int x = 0; x != int(Chunk::kLength); ++x) {
+        if (a(x, y, z) != b(x, y, z)) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/// Stone with random blocks, the encoded size grows with the edits
+void MakeChunk(std::mt19937 &random, int edits, Chunk &chunk) {
+  chunk.Fill(2);
+  for (int i = 0; i != edits; ++i) {
+    chunk.Set(int(random() % 32), int(random() % 256), int(random() % 32), BlockId(random() % 300));
+  }
+}
+
+std::vector<std::uint8_t> Encode(const Chunk &chunk) {
+  std::vector<std::uint8_t> data;
+  EncodeChunk(chunk, data);
+  return data;
+}
+
+} // namespace
+
+VKMC_TEST(RegionStoresChunks) {
+  test::TemporaryDirectory directory("vkmc_region_stores");
+  auto path = directory.GetPath() / "r.0.0.vkr";
+  std::mt19937 random(1);
+  std::vector<Chunk> chunks(3);
+  {
+    RegionFile region(path);
+    for (int i = 0; i != 3; ++i) {
+      MakeChunk(random, i * 1000, chunks[i]);
+      region.Write({i, -i}, Encode(chunks[i]));
+    }
+  }
+
+  RegionFile region(path);
+  for (int i = 0; i != 3; ++i) {
+    Chunk loaded;
+    VKMC_CHECK(region.Load({i, -i}, loaded) && IsSameChunk(loaded, chunks[i]));
+  }
+  Chunk missing;
+  VKMC_CHECK(!region.Load({5, 5}, missing));
+  // The id wraps into the region, the caller picks the region file
+  VKMC_CHECK(region.Load({32, 0}, missing) && IsSameChunk(missing, chunks[0]));
+}
+
+VKMC_TEST(RegionRejectsOtherFiles) {
+  test::TemporaryDirectory directory("vkmc_region_rejects");
+  auto path = directory.GetPath() / "r.0.0.vkr";
+  std::ofstream(path, std::ios::binary) << "not a region file";
+  VKMC_CHECK_THROWS(RegionFile region(path), std::runtime_error);
+}
+
+VKMC_TEST(RegionRejectsDamagedTable) {
+  test::TemporaryDirectory directory("vkmc_region_damaged");
+  auto path = directory.GetPath() / "r.0.0.vkr";
+  std::mt19937 random(4);
+  {
+    RegionFile region(path);
+    Chunk chunk;
+    for (int i = 0; i != 2; ++i) {
+      MakeChunk(random, 500, chunk);
+      region.Write({i, 0}, Encode(chunk));
+    }
+  }
+
+  // The entries of the chunks (0, 0) and (1, 0) after the 16 byte header:
+  // the offset, the size and the capacity
+  struct Entry {
+    std::uint64_t offset;
+    std::uint32_t size;
+    std::uint32_t capacity;
+  };
+  Entry entries[2];
+  {
+    std::ifstream in(path, std::ios::binary);
+    in.seekg(16);
+    in.read(reinterpret_cast<char *>(entries), sizeof(entries));
+  }
+  auto file_size = std::filesystem::file_size(path);
+  Entry damaged[] = {
+      // In the table
+      {16, entries[1].size, entries[1].capacity},
+      // Past the end of the file
+      {file_size - 8, entries[1].size, entries[1].capacity},
+      // Inside the first chunk
+      {entries[0].offset + 8, entries[1].size, entries[1].capacity},
+      {entries[1].offset, entries[1].size, entries[1].size - 1},
+  };
+  for (auto &entry : damaged) {
+    auto copy = directory.GetPath() / "r.0.1.vkr";
+    std::filesystem::copy_file(path, copy, std::filesystem::copy_options::overwrite_existing);
+    {
+      std::fstream out(copy, std::ios::binary | std::ios::in | std::ios::out);
+      out.seekp(16 + sizeof(Entry));
+      out.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+    }
+    VKMC_CHECK_THROWS(RegionFile region(copy), std::runtime_error);
+  }
+
+  RegionFile region(path);
+  Chunk loaded;
+  VKMC_CHECK(region.Load({1, 0}, loaded));
+}
+
+VKMC_TEST(RegionReusesSpaceOfGrowingChunks) {
+  test::TemporaryDirectory directory("vkmc_region_growing");
+  auto path = directory.GetPath() / "r.0.0.vkr";
+  std::mt19937 random(2);
+  constexpr int kChunkCount = 16;
+  std::vector<Chunk> chunks(kChunkCount);
+  std::uintmax_t stored = 0;
+  {
+    RegionFile region(path);
+    // Every chunk grows each round and moves, the space of the old copies
+    // is taken by the next round after the sync
+    for (int round = 0; round != 10; ++round) {
+      stored = 0;
+      for (int i = 0; i != kChunkCount; ++i) {
+        MakeChunk(random, round * 300 + int(random() % 100), chunks[i]);
+        auto data = Encode(chunks[i]);
+        stored += data.size();
+        region.Write({i, 0}, data);
+      }
+      region.Sync();
+    }
+  }
+  // Both copies of the chunks are kept until the sync, appending every
+  // copy instead makes it more than five times as large
+  VKMC_CHECK(std::filesystem::file_size(path) <= 3 * stored);
+
+  RegionFile region(path);
+  for (int i = 0; i != kChunkCount; ++i) {
+    Chunk loaded;
+    VKMC_CHECK(region.Load({i, 0}, loaded) && IsSameChunk(loaded, chunks[i]));
+  }
+}
+
+VKMC_TEST(RegionFindsFreeSpaceAfterReopen) {
+  test::TemporaryDirectory directory("vkmc_region_reopen");
+  auto path = directory.GetPath() / "r.0.0.vkr";
+  std::mt19937 random(3);
+  Chunk small, large, larger;
+  MakeChunk(random, 10, small);
+  MakeChunk(random, 3000, large);
+  MakeChunk(random, 20000, larger);
+  {
+    RegionFile region(path);
+    region.Write({0, 0}, Encode(large));
+    region.Write({1, 0}, Encode(small));
+    region.Sync();
+    // Moves to the end, its old space is a hole before chunk 1
+    region.Write({0, 0}, Encode(larger));
+    region.Sync();
+    auto size = std::filesystem::file_size(path);
+    region.Write({3, 0}, Encode(small));
+    VKMC_CHECK(std::filesystem::file_size(path) == size);
+  }
+  auto size = std::filesystem::file_size(path);
+
+  {
+    RegionFile region(path);
+    region.Write({2, 0}, Encode(small));
+  }
+  VKMC_CHECK(std::filesystem::file_size(path) == size);
+
+  RegionFile region(path);
+  Chunk loaded;
+  VKMC_CHECK(region.Load({0, 0}, loaded) && IsSameChunk(loaded, larger));
+  VKMC_CHECK(region.Load({1, 0}, loaded) && IsSameChunk(loaded, small));
+  VKMC_CHECK(region.Load({2, 0}, loaded) && IsSameChunk(loaded, small));
+}
+
+VKMC_TEST(RegionKeepsOldCopyUntilSync) {
+  test::TemporaryDirectory directory("vkmc_region_sync");
+  auto path = directory.GetPath() / "r.0.0.vkr";
+  // A copy of the file is what a crash would leave on the disk
+  auto crashed = directory.GetPath() / "crashed.vkr";
+  std::mt19937 random(4);
+  Chunk old_copy, new_copy, other;
+  MakeChunk(random, 3000, old_copy);
+  MakeChunk(random, 3000, new_copy);
+  MakeChunk(random, 10, other);
+
+  RegionFile region(path);
+  region.Write({0, 0}, Encode(old_copy));
+  region.Sync();
+  region.Write({0, 0}, Encode(new_copy));
+  // Would take the space of the old copy if it was freed
+  region.Write({1, 0}, Encode(other));
+  Chunk loaded;
+  VKMC_CHECK(region.Load({0, 0}, loaded) && IsSameChunk(loaded, new_copy));
+
+  std::filesystem::copy_file(path, crashed);
+  {
+    RegionFile before_sync(crashed);
+    VKMC_CHECK(before_sync.Load({0, 0}, loaded) && IsSameChunk(loaded, old_copy));
+    VKMC_CHECK(!before_sync.Load({1, 0}, loaded));
+  }
+  std::filesystem::remove(crashed);
+
+  region.Sync();
+  std::filesystem::copy_file(path, crashed);
+  RegionFile after_sync(crashed);
+  VKMC_CHECK(after_sync.Load({0, 0}, loaded) && IsSameChunk(loaded, new_copy));
+  VKMC_CHECK(after_sync.Load({1, 0}, loaded) && IsSameChunk(loaded, other));
+}
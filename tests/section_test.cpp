@@ -0,0 +1,140 @@
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "../game/chunk/palette.h"
+#include "../game/chunk/section.h"
+#include "test.h"
+
+namespace {
+
+constexpr int kLength = int(ChunkSection::kLength);
+
+/// Blocks in runs along z, like generated terrain, drawn from a number of
+/// distinct ids
+std::vector<BlockId> MakeBlocks(std::mt19937 &random, std::uint32_t distinct) {
+  std::vector<BlockId> blocks(ChunkSection::kVolume);
+  BlockId block = 0;
+  for (auto &entry : blocks) {
+    if (random() % 8 == 0) {
+      block = random() % distinct;
+    }
+    entry = block;
+  }
+  // Every id at least once
+  for (std::uint32_t i = 0; i != distinct; ++i) {
+    blocks[random() % blocks.size()] = i;
+  }
+  return blocks;
+}
+
+/// The number of blocks which differ between a section assigned at once
+/// and one set block by block
+std::size_t CountMismatches(const std::vector<BlockId> &blocks, ChunkSection &assigned) {
+  assigned.Assign(blocks.data());
+  ChunkSection set;
+  std::size_t mismatches = 0;
+  for (int y = 0; y != kLength; ++y) {
+    for (int x = 0; x != kLength; ++x) {
+      for (int z = 0; z != kLength; ++z) {
+        set.Set(x, y, z, blocks[ChunkSection::GetIndex(x, y, z)]);
+      }
+    }
+  }
+  for (int y = 0; y != kLength; ++y) {
+    for (int x = 0; x != kLength; ++x) {
+      for (int z = 0; z != kLength; ++z) {
+        mismatches += assigned(x, y, z) != set(x, y, z);
+        mismatches += assigned(x, y, z) != blocks[ChunkSection::GetIndex(x, y, z)];
+      }
+    }
+  }
+  return mismatches;
+}
+
+} // namespace
+
+VKMC_TEST(SectionAssignMatchesSet) {
+  std::mt19937 random(5);
+  ChunkSection section;
+
+  // Uniform input leaves a tag
+  std::vector<BlockId> uniform(ChunkSection::kVolume, 4);
+  VKMC_CHECK(CountMismatches(uniform, section) == 0);
+  VKMC_CHECK(section.IsUniform() && section.GetUniformBlock() == 4);
+
+  // The palette holds only the assigned blocks
+  auto two = MakeBlocks(random, 2);
+  VKMC_CHECK(CountMismatches(two, section) == 0);
+  VKMC_CHECK(!section.IsUniform() && section.GetStorage()->GetBitsPerIndex() == 1);
+  VKMC_CHECK(section.GetStorage()->GetPaletteSize() == 2);
+
+  // 17 blocks take more than 4 bits
+  auto seventeen = MakeBlocks(random, 17);
+  VKMC_CHECK(CountMismatches(seventeen, section) == 0);
+  VKMC_CHECK(section.GetStorage()->GetBitsPerIndex() == 8);
+
+  // A storage in use narrows again
+  VKMC_CHECK(CountMismatches(MakeBlocks(random, 3), section) == 0);
+  VKMC_CHECK(section.GetStorage()->GetBitsPerIndex() == 2);
+
+  auto many = MakeBlocks(random, 300);
+  VKMC_CHECK(CountMismatches(many, section) == 0);
+  VKMC_CHECK(section.GetStorage()->GetBitsPerIndex() == 16);
+
+  VKMC_CHECK(CountMismatches(uniform, section) == 0);
+  VKMC_CHECK(section.IsUniform());
+}
+
+VKMC_TEST(PaletteAssignThrowsPastSixteenBits) {
+  // One more distinct block than a palette holds
+  std::vector<BlockId> blocks(PaletteStorage::kMaxPaletteSize + 1);
+  for (std::size_t i = 0; i != blocks.size(); ++i) {
+    blocks[i] = BlockId(i);
+  }
+  PaletteStorage storage(blocks.size(), 5);
+  storage.Set(3, 6);
+  VKMC_CHECK_THROWS(storage.Assign(blocks), std::runtime_error);
+  // Left as it was
+  VKMC_CHECK(storage.GetPaletteSize() == 2 && storage.Get(3) == 6 && storage.Get(4) == 5);
+
+  VKMC_CHECK_THROWS(storage.Assign({blocks.data(), 10}), std::runtime_error);
+}
+
+VKMC_TEST(SectionFillKeepsStorage) {
+  std::mt19937 random(9);
+  ChunkSection section;
+  section.Set(1, 2, 3, 5);
+  auto storage = section.GetStorage();
+
+  // Filled, the storage stays with one block
+  section.Fill(6);
+  VKMC_CHECK(section.GetStorage() == storage && section.IsUniform());
+  VKMC_CHECK(section.GetUniformBlock() == 6 && section(1, 2, 3) == 6 && storage->GetBitsPerIndex() == 0);
+
+  // And takes the next different block
+  section.Set(4, 5, 6, 7);
+  VKMC_CHECK(section.GetStorage() == storage && !section.IsUniform());
+  VKMC_CHECK(section(4, 5, 6) == 7 && section(1, 2, 3) == 6);
+
+  std::vector<BlockId> uniform(ChunkSection::kVolume, 8);
+  VKMC_CHECK(CountMismatches(uniform, section) == 0);
+  VKMC_CHECK(section.GetStorage() == storage && section.IsUniform() && section.GetUniformBlock() == 8);
+  VKMC_CHECK(CountMismatches(MakeBlocks(random, 5), section) == 0);
+  VKMC_CHECK(section.GetStorage() == storage);
+
+  // Copying a uniform section keeps the storage too, a copy constructed
+  // from it gets none
+  ChunkSection source;
+  source.Fill(9);
+  section = source;
+  VKMC_CHECK(section.GetStorage() == storage && section.IsUniform() && section(0, 0, 0) == 9);
+  ChunkSection copy(section);
+  VKMC_CHECK(copy.GetStorage() == nullptr && copy.GetUniformBlock() == 9);
+
+  // A storage of one block assigned as is counts as uniform
+  section.Assign(std::make_unique<PaletteStorage>(ChunkSection::kVolume, 10));
+  VKMC_CHECK(section.IsUniform() && section.GetUniformBlock() == 10);
+}
@@ -0,0 +1,96 @@
+#include <random>
+#include <vector>
+
+#include "../game/render/staging_ring.h"
+#include "test.h"
+
+VKMC_TEST(StagingRingAlignsAllocations) {
+  StagingRing ring(256);
+  VKMC_CHECK(ring.Allocate(10) == 0);
+  VKMC_CHECK(ring.Allocate(10) == 16);
+  VKMC_CHECK(ring.Allocate(1, 64) == 64);
+  // The padding stays in use until it is reclaimed
+  VKMC_CHECK(ring.GetUsedSize() == 65);
+}
+
+VKMC_TEST(StagingRingRetiresBySerial) {
+  StagingRing ring(100);
+  VKMC_CHECK(ring.Allocate(40, 1) == 0);
+  ring.Submit(1);
+  VKMC_CHECK(ring.Allocate(40, 1) == 40);
+  ring.Submit(2);
+  // Nothing was allocated, no batch is closed
+  ring.Submit(3);
+
+  // [80, 100) is too short and [0, 40) is read by submission 1
+  VKMC_CHECK(ring.Allocate(30, 1) == StagingRing::kInvalidOffset);
+  ring.Retire(0);
+  VKMC_CHECK(ring.GetUsedSize() == 80);
+  ring.Retire(1);
+  VKMC_CHECK(ring.GetUsedSize() == 40);
+
+  // Wraps to the front, the skipped [80, 100) is held with it
+  VKMC_CHECK(ring.Allocate(30, 1) == 0);
+  ring.Submit(4);
+  VKMC_CHECK(ring.GetUsedSize() == 90);
+  VKMC_CHECK(ring.Allocate(11, 1) == StagingRing::kInvalidOffset);
+  VKMC_CHECK(ring.Allocate(10, 1) == 30);
+  ring.Submit(5);
+  VKMC_CHECK(ring.GetUsedSize() == 100);
+  VKMC_CHECK(ring.Allocate(1, 1) == StagingRing::kInvalidOffset);
+
+  // Retiring 2 frees [40, 80) between the head and the tail
+  ring.Retire(2);
+  VKMC_CHECK(ring.GetUsedSize() == 60);
+  VKMC_CHECK(ring.Allocate(41, 1) == StagingRing::kInvalidOffset);
+  VKMC_CHECK(ring.Allocate(40, 1) == 40);
+  ring.Submit(6);
+  VKMC_CHECK(ring.GetUsedSize() == 100);
+  ring.Retire(5);
+  VKMC_CHECK(ring.GetUsedSize() == 40);
+  ring.Retire(6);
+  VKMC_CHECK(ring.GetUsedSize() == 0);
+
+  // An empty ring starts again from the front
+  VKMC_CHECK(ring.Allocate(100, 1) == 0);
+}
+
+VKMC_TEST(StagingRingKeepsInFlightRangesApart) {
+  // Frames allocate, submit and retire the submission two frames back
+  // like the renderer, ranges still read by the GPU must never overlap
+  constexpr std::size_t capacity = 4096;
+  StagingRing ring(capacity);
+  struct Allocation {
+    std::size_t offset;
+    std::size_t size;
+    std::uint64_t serial;
+  };
+  std::vector<Allocation> live;
+  std::mt19937 random(3);
+  std::size_t allocated = 0;
+  std::uint64_t serial = 0;
+  for (int frame = 0; frame != 20000; ++frame) {
+    ++serial;
+    for (auto n = random() % 5; n != 0; --n) {
+      std::size_t size = 1 + random() % 1500;
+      auto offset = ring.Allocate(size);
+      if (offset == StagingRing::kInvalidOffset) {
+        continue;
+      }
+      ++allocated;
+      VKMC_CHECK(offset % 16 == 0 && offset + size <= capacity);
+      for (auto &other : live) {
+        VKMC_CHECK(offset + size <= other.offset || other.offset + other.size <= offset);
+      }
+      live.push_back({offset, size, serial});
+    }
+    ring.Submit(serial);
+    if (serial > 2) {
+      ring.Retire(serial - 2);
+      std::erase_if(live, [&](const Allocation &allocation) { return allocation.serial <= serial - 2; });
+    }
+  }
+  VKMC_CHECK(allocated > 20000);
+  ring.Retire(serial);
+  VKMC_CHECK(ring.GetUsedSize() == 0);
+}
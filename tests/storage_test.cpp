@@ -0,0 +1,99 @@
+#include <memory>
+#include <random>
+
+#include "../game/chunk/generator.h"
+#include "../game/chunk/manager.h"
+#include "../game/chunk/storage.h"
+#include "test.h"
+
+namespace {
+
+bool IsSameChunk(const Chunk &a, const Chunk &b) {
+  for (int y = 0; y != int(Chunk::kHeight); ++y) {
+    for (int z = 0; z != int(Chunk::kLength); ++z) {
+      for (int x = 0; x != int(Chunk::kLength); ++x) {
+        if (a(x, y, z) != b(x, y, z)) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+VKMC_TEST(StorageSavesAndReloads) {
+  test::AssetsScope assets;
+  test::TemporaryDirectory directory("vkmc_storage_saves");
+  BlockRegistry registry;
+  ChunkGenerator generator(7);
+  std::mt19937 random(3);
+  // In four regions, one of them at negative coordinates
+  ChunkId ids[4] = {{0, 0}, {31, -17}, {62, -34}, {93, -51}};
+  Chunk saved[4];
+  {
+    ChunkStorage storage(directory.GetPath());
+    for (int i = 0; i != 4; ++i) {
+      auto chunk = std::make_shared<Chunk>();
+      generator.Generate(registry, *chunk, ids[i].x, ids[i].y);
+      saved[i] = *chunk;
+      storage.Save(ids[i], chunk);
+      // Queued chunks are loaded before they are written
+      Chunk loaded;
+      VKMC_CHECK(storage.Load(ids[i], loaded) && IsSameChunk(loaded, saved[i]));
+    }
+    storage.Flush();
+
+    // Smaller than before, then larger than before
+    auto smaller = std::make_shared<Chunk>();
+    smaller->Fill(1);
+    saved[0] = *smaller;
+    storage.Save(ids[0], smaller);
+    storage.Flush();
+    auto larger = std::make_shared<Chunk>(saved[1]);
+    for (int i = 0; i != 5000; ++i) {
+      larger->Set(int(random() % 32), int(random() % 256), int(random() % 32), BlockId(random() % 200));
+    }
+    saved[1] = *larger;
+    storage.Save(ids[1], larger);
+
+    Chunk missing;
+    VKMC_CHECK(!storage.Load({5, 5}, missing));
+    VKMC_CHECK(!storage.Load({-500, 5}, missing));
+  }
+
+  ChunkStorage storage(directory.GetPath());
+  for (int i = 0; i != 4; ++i) {
+    Chunk loaded;
+    VKMC_CHECK(storage.Load(ids[i], loaded) && IsSameChunk(loaded, saved[i]));
+  }
+}
+
+VKMC_TEST(StorageKeepsEditsOfUnloadedChunks) {
+  test::AssetsScope assets;
+  test::TemporaryDirectory directory("vkmc_storage_edits");
+  BlockRegistry registry;
+  WorkerPool workers(2);
+  {
+    ChunkStorage storage(directory.GetPath());
+    ChunkManager manager(7, workers);
+    manager.SetStorage(&storage);
+    manager.Load(registry, {2, 3});
+    manager.SetBlock({70, 200, 100}, 3);
+    // Loaded again from the storage instead of generated
+    manager.Unload({2, 3});
+    manager.Request(registry, {2, 3});
+    workers.Wait();
+    manager.Integrate();
+    VKMC_CHECK(manager.GetBlock({70, 200, 100}) == 3);
+    manager.SetBlock({71, 201, 101}, 2);
+  }
+
+  ChunkStorage storage(directory.GetPath());
+  ChunkManager manager(7, workers);
+  manager.SetStorage(&storage);
+  manager.Load(registry, {2, 3});
+  VKMC_CHECK(manager.GetBlock({70, 200, 100}) == 3);
+  VKMC_CHECK(manager.GetBlock({71, 201, 101}) == 2);
+}
@@ -0,0 +1,88 @@
+#include <cstdio>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "../base/sources/internal/assets.h"
+#include "test.h"
+
+namespace {
+
+struct TestCase {
+  std::string_view name;
+  test::Function function;
+};
+
+/// Filled by the static registrations before main
+std::vector<TestCase> &GetTestCases() {
+  static std::vector<TestCase> cases;
+  return cases;
+}
+
+std::size_t failures;
+bool skipped;
+
+} // namespace
+
+bool test::Register(std::string_view name, Function function) {
+  GetTestCases().push_back({name, function});
+  return true;
+}
+
+void test::Fail(const char *file, int line, const char *expression) {
+  std::printf("%s:%d: check failed: %s\n", file, line, expression);
+  ++failures;
+}
+
+void test::Skip(const char *reason) {
+  std::printf("skipped: %s\n", reason);
+  skipped = true;
+}
+
+test::AssetsScope::AssetsScope() {
+  assets::internal::LoadAssetsFile(VKMC_TEST_ASSETS);
+}
+
+test::AssetsScope::~AssetsScope() {
+  assets::internal::UnloadAssetsFile();
+}
+
+test::TemporaryDirectory::TemporaryDirectory(std::string_view name)
+    : path_(std::filesystem::temp_directory_path() / name) {
+  std::filesystem::remove_all(path_);
+  std::filesystem::create_directories(path_);
+}
+
+test::TemporaryDirectory::~TemporaryDirectory() {
+  std::error_code error;
+  std::filesystem::remove_all(path_, error);
+}
+
+/// Run the test cases whose name contains the first argument, or all
+int main(int argc, char **argv) {
+  std::string_view filter = argc > 1 ? argv[1] : "";
+  std::size_t failed_cases = 0, skipped_cases = 0, run_cases = 0;
+  for (auto &[name, function] : GetTestCases()) {
+    if (name.find(filter) == std::string_view::npos) {
+      continue;
+    }
+    auto before = failures;
+    skipped = false;
+    ++run_cases;
+    try {
+      function();
+    } catch (std::exception &e) {
+      std::printf("unexpected exception: %s\n", e.what());
+      ++failures;
+    }
+    auto passed = failures == before;
+    failed_cases += !passed;
+    skipped_cases += passed && skipped;
+    auto status = !passed ? "FAIL" : skipped ? "skip" : "pass";
+    std::printf("[%s] %.*s\n", status, int(name.size()), name.data());
+  }
+  if (failed_cases != 0) {
+    return 1;
+  }
+  return run_cases != 0 && skipped_cases == run_cases ? test::kSkipCode : 0;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#ifndef VKMC_TESTS_TEST_H_
+#define VKMC_TESTS_TEST_H_
+
+#include <filesystem>
+#include <string_view>
+
+namespace test {
+
+using Function = void (*)();
+
+/// Add a test case to the executable, used by VKMC_TEST
+bool Register(std::string_view name, Function function);
+
+/// Report a failed check, the test case goes on
+void Fail(const char *file, int line, const char *expression);
+
+/// Mark the test case skipped, e.g. without a GPU, it should return after.
+/// An executable whose test cases were all skipped exits with kSkipCode.
+void Skip(const char *reason);
+
+constexpr int kSkipCode = 77;
+
+/// Loads the default assets of the build for the lifetime of the scope
+class AssetsScope {
+public:
+  AssetsScope();
+  ~AssetsScope();
+
+  AssetsScope(const AssetsScope &) = delete;
+  AssetsScope &operator=(const AssetsScope &) = delete;
+};
+
+/// An empty directory removed with its files at the end of the scope
+class TemporaryDirectory {
+public:
+  explicit TemporaryDirectory(std::string_view name);
+  ~TemporaryDirectory();
+
+  TemporaryDirectory(const TemporaryDirectory &) = delete;
+  TemporaryDirectory &operator=(const TemporaryDirectory &) = delete;
+
+  [[nodiscard]] const std::filesystem::path &GetPath() const noexcept {
+    return path_;
+  }
+
+private:
+  std::filesystem::path path_;
+};
+
+} // namespace test
+
+#define VKMC_TEST(name)                                                \
+  static void name();                                                  \
+  [[maybe_unused]] static const bool name##_registered = test::Register(#name, name); \
+  static void name()
+
+#define VKMC_CHECK(expression)                       \
+  do {                                               \
+    if (!(expression)) {                             \
+      test::Fail(__FILE__, __LINE__, #expression);   \
+    }                                                \
+  } while (0)
+
+/// Check that the statement throws the exception type
+#define VKMC_CHECK_THROWS(statement, exception)      \
+  do {                                               \
+    bool thrown = false;                             \
+    try {                                            \
+      statement;                                     \
+    } catch (const exception &) {                    \
+      thrown = true;                                 \
+    }                                                \
+    if (!thrown) {                                   \
+      test::Fail(__FILE__, __LINE__, #statement " throws " #exception); \
+    }                                                \
+  } while (0)
+
+#endif // VKMC_TESTS_TEST_H_
@@ -4,6 +4,7 @@
 #include <fstream>
 #include <iostream>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 #include <string>
@@ -50,8 +51,8 @@ void WriteStruct(Writer &writer, const Tp &val) {
 }
 
 int main(int argc, char *argv[]) {
-  if (argc != 3) {
-    std::cerr << "Usage: respack_builder [assets directory] [respack output location]\n";
+  if (argc < 3) {
+    std::cerr << "Usage: respack_builder [assets directory...] [respack output location]\n";
     return 1;
   }
 
@@ -59,7 +60,7 @@ int main(int argc, char *argv[]) {
 
   auto begin_time = std::chrono::steady_clock::now();
 
-  auto output = std::filesystem::path(argv[2]);
+  auto output = std::filesystem::path(argv[argc - 1]);
   std::ofstream out(output, std::ios::binary);
   if (!out.is_open()) {
     std::cerr << "Can't not write data to " << output.lexically_normal() << "!\n";
@@ -72,19 +73,31 @@ int main(int argc, char *argv[]) {
   ImageCollector image_collector;
   JsonCollector json_collector;
 
-  std::uint32_t resources_count;
+  std::uint32_t resources_count = 0;
   {
-    std::filesystem::path assets = argv[1];
-    if (!std::filesystem::is_directory(assets)) {
-      std::cerr << "Could not open assets folder: " << assets.lexically_normal() << '\n';
-      return 1;
-    }
-
     processes[".png"] = {&image_collector};
     processes[".spv"] = {&shader_collector};
     processes[".json"] = {&json_collector};
 
-    resources_count = search_assets("", std::move(assets));
+    // The folders are merged, e.g. the assets and the shaders compiled by the build
+    for (int i = 1; i != argc - 1; ++i) {
+      std::filesystem::path assets = argv[i];
+      if (!std::filesystem::is_directory(assets)) {
+        std::cerr << "Could not open assets folder: " << assets.lexically_normal() << '\n';
+        return 1;
+      }
+      resources_count += search_assets("", std::move(assets));
+    }
+
+    std::unordered_set<std::string> names;
+    for (auto &[_, p] : processes) {
+      for (auto &[name, path] : p.files) {
+        if (!names.insert(name).second) {
+          std::cerr << "Resource " << name << " is found twice, the second is " << path.lexically_normal() << '\n';
+          return 1;
+        }
+      }
+    }
   }
 
   auto detected_time = std::chrono::steady_clock::now();
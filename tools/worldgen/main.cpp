@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "../../base/sources/internal/assets.h"
+#include "../../game/block/registry.h"
+#include "../../game/chunk/codec.h"
+#include "../../game/chunk/generator.h"
+#include "../../game/job/worker_pool.h"
+#include "../../game/world/world_file.h"
+
+namespace {
+
+/// The chunks generated while the previous batch is written
+constexpr std::size_t kBatchChunks = 1024;
+
+struct Options {
+  std::string assets = "default.assets";
+  std::string output = "world.vkw";
+  std::string json;
+  std::uint64_t seed = 114514;
+  std::int32_t min = -32;
+  std::int32_t max = 32;
+  /// 0 uses all hardware threads
+  std::size_t threads = 0;
+};
+
+Options ParseOptions(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    auto value = [&] {
+      if (i + 1 == argc) {
+        throw std::runtime_error("Missing value of " + std::string(arg));
+      }
+      return std::string(argv[++i]);
+    };
+    if (arg == "--assets") {
+      options.assets = value();
+    } else if (arg == "--output") {
+      options.output = value();
+    } else if (arg == "--json") {
+      options.json = value();
+    } else if (arg == "--seed") {
+      options.seed = std::stoull(value());
+    } else if (arg == "--region") {
+      // The chunk range on both x and z, as min..max
+      auto range = value();
+      auto dots = range.find("..");
+      if (dots == std::string::npos) {
+        throw std::runtime_error("The region should be min..max, not " + range);
+      }
+      options.min = std::stoi(range.substr(0, dots));
+      options.max = std::stoi(range.substr(dots + 2));
+    } else if (arg == "--threads") {
+      options.threads = std::stoull(value());
+    } else {
+      throw std::runtime_error(
+          "Usage: worldgen [--assets file] [--output file] [--json file] [--seed n] [--region min..max] [--threads n]"
+      );
+    }
+  }
+  if (options.threads == 0) {
+    options.threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  return options;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  try {
+    auto options = ParseOptions(argc, argv);
+    assets::internal::LoadAssetsFile(options.assets);
+
+    {
+      BlockRegistry registry;
+      ChunkGenerator generator(options.seed);
+      WorkerPool workers(options.threads);
+      ChunkId min{options.min, options.min}, max{options.max, options.max};
+      WorldFileWriter writer(options.output, options.seed, min, max);
+      auto width = std::size_t(max.x - min.x + 1);
+      auto count = writer.GetChunkCount();
+
+      // Each chunk only depends on the seed and its position, and the
+      // batches are written in file order. The file is the same on any
+      // number of threads.
+      std::vector<std::vector<std::uint8_t>> batches[2];
+      auto submit = [&](std::size_t batch) {
+        auto first = batch * kBatchChunks;
+        auto &encoded = batches[batch & 1];
+        encoded.resize(std::min(kBatchChunks, count - first));
+        for (std::size_t i = 0; i != encoded.size(); ++i) {
+          workers.Submit([&, i, index = first + i] {
+            Chunk chunk;
+            auto x = min.x + std::int32_t(index % width), z = min.y + std::int32_t(index / width);
+            generator.Generate(registry, chunk, x, z);
+            encoded[i].clear();
+            EncodeChunk(chunk, encoded[i]);
+          });
+        }
+      };
+
+      std::cout << "Generating " << count << " chunks on " << workers.GetWorkerCount() << " threads...\n";
+      auto begin = std::chrono::steady_clock::now();
+      auto n_batch = (count + kBatchChunks - 1) / kBatchChunks;
+      submit(0);
+      workers.Wait();
+      for (std::size_t batch = 0; batch != n_batch; ++batch) {
+        if (batch + 1 != n_batch) {
+          submit(batch + 1);
+        }
+        for (auto &chunk : batches[batch & 1]) {
+          writer.Write(chunk);
+        }
+        workers.Wait();
+      }
+      writer.Finish();
+      auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+      std::printf(
+          "%zu chunks in %.2f s, %.1f chunk/s, %llu bytes, checksum %016llx\n",
+          count, seconds, double(count) / seconds,
+          static_cast<unsigned long long>(writer.GetSize()),
+          static_cast<unsigned long long>(writer.GetChecksum())
+      );
+      auto stats = generator.GetStageStats();
+      for (std::size_t i = 0; i != stats.size(); ++i) {
+        auto &stage = stats[i];
+        if (stage.runs != 0) {
+          std::printf(
+              "  %-12s %12.1f ns/run %10.1f%% cached\n",
+              ChunkGenerator::GetStageName(ChunkGenerator::Stage(i)),
+              double(stage.nanoseconds) / double(stage.runs),
+              100. * double(stage.cache_hits) / double(stage.runs)
+          );
+        }
+      }
+
+      if (!options.json.empty()) {
+        nlohmann::json json{
+            {"seed", options.seed},
+            {"threads", workers.GetWorkerCount()},
+            {"chunks", count},
+            {"seconds", seconds},
+            {"chunks_per_second", double(count) / seconds},
+            {"bytes", writer.GetSize()},
+            {"checksum", writer.GetChecksum()},
+        };
+        std::ofstream(options.json) << json.dump(2) << '\n';
+      }
+    }
+
+    assets::internal::UnloadAssetsFile();
+  } catch (std::exception &e) {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+  return 0;
+}